@@ -0,0 +1,304 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "bsp.h"
+
+// Benchmarks for make bench
+//
+// each result is printed as "BENCH <name> <value> <unit>" and the run
+// ends with "BENCH end" and a reset, which stops QEMU with -no-reboot.
+// all the results are rates, higher is better.
+
+#define BENCH_TIME  200000  // us for each benchmark
+
+static void result(const char *name, uint32_t count, uint32_t us, const char *unit) {
+    uint32_t rate = (uint32_t) (((uint64_t) count * 1000000) / (us ? us : 1));
+    uart_printf("\r\nBENCH %s %u %s", name, rate, unit);
+}
+
+// memcpy and memset
+
+#define MEM_SIZE  (64 * 1024)
+
+static uint8_t src[MEM_SIZE] __attribute__((aligned(32)));
+static uint8_t dst[MEM_SIZE] __attribute__((aligned(32)));
+
+static void bench_memory(void) {
+    uint32_t n = 0;
+    uint32_t start = SYST_CLO;
+    uint32_t t;
+
+    do {
+        memcpy(dst, src, MEM_SIZE);
+        n++;
+    } while ((t = SYST_CLO - start) < BENCH_TIME);
+    result("memcpy", n * (MEM_SIZE / 1024), t, "KB/s");
+
+    n = 0;
+    start = SYST_CLO;
+    do {
+        memset(dst, n, MEM_SIZE);
+        n++;
+    } while ((t = SYST_CLO - start) < BENCH_TIME);
+    result("memset", n * (MEM_SIZE / 1024), t, "KB/s");
+}
+
+// 16bpp framebuffer fill
+
+#define FB_W  640
+#define FB_H  480
+#define RECT  64
+
+static uint16_t *fb;
+static uint32_t fb_pitch;   // bytes
+
+#ifndef HOST
+#define MAILBOX0_FIFO   IOREG(0x2000B880)
+#define MAILBOX0_STATUS IOREG(0x2000B898)
+#define MAILBOX1_FIFO   IOREG(0x2000B8A0)
+#define MAILBOX1_STATUS IOREG(0x2000B8B8)
+
+#define MAIL_FULL      0x80000000
+#define MAIL_EMPTY     0x40000000
+
+static volatile uint32_t fb_message[] __attribute__((aligned(16))) = {
+    26 * 4,                     // buffer size
+    0,                          // request
+    0x00048003, 8, 0,           // set the screen size
+    FB_W, FB_H,
+    0x00048004, 8, 0,           // set the virtual screen size
+    FB_W, FB_H,
+    0x00048005, 4, 0,           // set the depth
+    16,
+    0x00040008, 4, 0,           // get the pitch
+    0,                          // @19
+    0x00040001, 8, 0,           // allocate the frame buffer
+    16, 0,                      // @23 address
+    0,                          // end tag
+};
+
+static void fb_init(void) {
+    uint32_t data;
+
+    while (MAILBOX1_STATUS & MAIL_FULL) {
+    }
+    MAILBOX1_FIFO = ((uint32_t) fb_message + 0x40000000) | 8;
+    do {
+        while (MAILBOX0_STATUS & MAIL_EMPTY) {
+        }
+    } while (((data = MAILBOX0_FIFO) & 0xfU) != 8);
+
+    if ((fb_message[1] == 0x80000000) && (fb_message[23] != 0)) {
+        fb = (uint16_t *) (fb_message[23] & 0x3fffffff);
+        fb_pitch = fb_message[19];
+    }
+}
+#else
+static uint16_t fb_buf[FB_W * FB_H] __attribute__((aligned(16)));
+
+static void fb_init(void) {
+    fb = fb_buf;
+    fb_pitch = FB_W * 2;
+}
+#endif
+
+static void fill_rect(uint32_t x, uint32_t y, uint32_t w, uint32_t h, uint16_t c) {
+    uint32_t c2 = ((uint32_t) c << 16) | c;
+
+    for (uint32_t j = 0; j < h; j++) {
+        uint16_t *p = (uint16_t *) ((uint8_t *) fb + fb_pitch * (y + j)) + x;
+        uint32_t l = w;
+        if (((uintptr_t) p & 2) && l) {
+            *p++ = c;
+            l--;
+        }
+        uint32_t *q = (uint32_t *) p;
+        for (; l >= 8; l -= 8) {
+            q[0] = c2;
+            q[1] = c2;
+            q[2] = c2;
+            q[3] = c2;
+            q += 4;
+        }
+        for (; l >= 2; l -= 2) {
+            *q++ = c2;
+        }
+        if (l) {
+            *(uint16_t *) q = c;
+        }
+    }
+}
+
+static void bench_fill(void) {
+    uint32_t n = 0;
+    uint32_t start;
+    uint32_t t;
+
+    fb_init();
+    if (fb == NULL) {
+        uart_print("\r\nbench: no framebuffer");
+        return;
+    }
+    start = SYST_CLO;
+    do {
+        // rectangles at odd and even positions
+        uint32_t x = (n * 37) % (FB_W - RECT);
+        uint32_t y = (n * 23) % (FB_H - RECT);
+        fill_rect(x, y, RECT, RECT, (uint16_t) (n * 0x0841));
+        n++;
+    } while ((t = SYST_CLO - start) < BENCH_TIME);
+    result("fill16", n * RECT * RECT / 1000, t, "Kpixel/s");
+}
+
+// UART text output and formatting
+
+#define TEXT_LINES  16
+
+static void bench_text(void) {
+    const char line[] = "\r\nthe quick brown fox jumps over the lazy dog 0123456789 ......";
+    uint32_t start = SYST_CLO;
+
+    for (int i = 0; i < TEXT_LINES; i++) {
+        uart_print(line);
+    }
+    result("uart_text", TEXT_LINES * (sizeof(line) - 1), SYST_CLO - start, "char/s");
+}
+
+static void bench_printf(void) {
+    char buf[64];
+    uint32_t n = 0;
+    uint32_t start = SYST_CLO;
+    uint32_t t;
+
+    do {
+        fmt_snprintf(buf, sizeof(buf), "%s %5d 0x%08x %c %u", "line",
+                     (int) n, n * 2654435761U, 'a' + (int) (n % 26), n);
+        n++;
+    } while ((t = SYST_CLO - start) < BENCH_TIME);
+    result("snprintf", n, t, "call/s");
+}
+
+// system timer interrupt rate
+
+#ifndef HOST
+// ldr pc, [pc, #24]
+#define JMP_PC_24   0xe59ff018
+
+typedef void (*exception_hander_t)(void);
+
+typedef struct __attribute__((aligned(32))) _vector_table_t {
+    const unsigned int vector[8]; // all elements shoud be JMP_PC_24
+    exception_hander_t reset;
+    exception_hander_t undef;
+    exception_hander_t svc;
+    exception_hander_t prefetch_abort;
+    exception_hander_t data_abort;
+    exception_hander_t hypervisor_trap;
+    exception_hander_t irq;
+    exception_hander_t fiq;
+} vector_table_t;
+
+static void __attribute__((interrupt("IRQ"))) irq_handler(void);
+static void __attribute__((naked)) hangup(void);
+
+static vector_table_t exception_vector = { \
+    .vector = { JMP_PC_24, JMP_PC_24, JMP_PC_24, JMP_PC_24, \
+                JMP_PC_24, JMP_PC_24, JMP_PC_24, JMP_PC_24 },
+    .reset = Init_Machine,
+    .undef = hangup,
+    .svc = hangup,
+    .prefetch_abort = hangup,
+    .data_abort = hangup,
+    .hypervisor_trap = hangup,
+    .irq = irq_handler,
+    .fiq = hangup
+};
+
+static void set_vbar(vector_table_t *base) {
+    __asm volatile ("mcr p15, 0, %[base], c12, c0, 0"
+                  :: [base] "r" (base));
+}
+
+#define IRQ_PEND1         IOREG(0x2000B204)
+#define IRQ_ENABLE1       IOREG(0x2000B210)
+#define IRQ_DISABLE1      IOREG(0x2000B21C)
+
+#define IRQ_SYST_C1       (1 << 1)
+
+#define IRQ_PERIOD  10      // us
+
+static volatile uint32_t irq_count;
+static volatile uint32_t irq_last;
+
+static void __attribute__((interrupt("IRQ"))) irq_handler(void) {
+    if (IRQ_PEND1 & IRQ_SYST_C1) {
+        SYST_CS = IRQ_SYST_C1;
+        irq_last = SYST_CLO;
+        SYST_C1 = irq_last + IRQ_PERIOD;
+        irq_count++;
+    }
+}
+
+static void __attribute__((naked)) hangup(void) {
+    while(1) {
+    }
+}
+
+static void bench_irq(void) {
+    uint32_t start;
+    uint32_t t;
+
+    set_vbar(&exception_vector);
+    irq_count = 0;
+    irq_last = SYST_CLO;
+    SYST_CS = IRQ_SYST_C1;
+    SYST_C1 = irq_last + IRQ_PERIOD;
+    IRQ_ENABLE1 = IRQ_SYST_C1;
+    __asm volatile("cpsie i" ::: "memory");
+
+    start = SYST_CLO;
+    while ((t = SYST_CLO - start) < BENCH_TIME) {
+        // the compare matches only the exact count: if the handler was
+        // late for the next match, the counter has to wrap around
+        if (SYST_CLO - irq_last > 1000) {
+            irq_last = SYST_CLO;
+            SYST_C1 = irq_last + IRQ_PERIOD;
+        }
+    }
+
+    __asm volatile("cpsid i" ::: "memory");
+    IRQ_DISABLE1 = IRQ_SYST_C1;
+    SYST_CS = IRQ_SYST_C1;
+    result("timer_irq", irq_count, t, "irq/s");
+}
+
+static void enable_icache(void) {
+    uint32_t c1;
+    __asm volatile("mrc p15, 0, %0, c1, c0, 0" : "=r" (c1));
+    c1 |= (1 << 12) | (1 << 11);    // I-cache, branch prediction
+    __asm volatile("mcr p15, 0, %0, c1, c0, 0" :: "r" (c1));
+}
+#endif
+
+int main(int argc, char **argv) {
+  uart_init(UART_BAUD);
+#ifndef HOST
+  enable_icache();
+#endif
+  uart_print("\r\nbench: start");
+
+  bench_memory();
+  bench_fill();
+  bench_text();
+  bench_printf();
+#ifndef HOST
+  bench_irq();
+#endif
+
+  uart_print("\r\nBENCH end\r\n");
+  delay_ms(10);   // let the FIFO drain before the reset
+  power_reset();
+
+  return 0;
+}
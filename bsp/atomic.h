@@ -0,0 +1,62 @@
+#ifndef ATOMIC_H
+#define ATOMIC_H
+
+// Lock-free primitives shared by interrupt handlers and tasks
+//
+// dmb()               data memory barrier: the accesses before it are
+//                     seen by the other contexts before the ones after it
+// cas32(p, old, new)  compare and swap with ldrex/strex, returns 1 if *p
+//                     was old and is replaced by new
+// atomic_inc(p)       *p += 1 with cas32()
+//
+// An interrupt between ldrex and strex makes the strex fail: the
+// interrupt entry must clrex (see irq-nested/irq.S) and cas32() retries.
+// The host builds (HOST=1 and the host tests) use the GCC builtins.
+
+#include <stdint.h>
+
+#if defined(__arm__)
+
+static inline void dmb(void) {
+#if (__ARM_ARCH >= 7)
+    __asm volatile("dmb" ::: "memory");
+#else
+    __asm volatile("mcr p15, 0, %0, c7, c10, 5" :: "r" (0) : "memory");
+#endif
+}
+
+static inline int cas32(volatile uint32_t *p, uint32_t old, uint32_t new) {
+    uint32_t cur;
+    uint32_t fail;
+    do {
+        __asm volatile("ldrex %0, [%1]" : "=&r" (cur) : "r" (p) : "memory");
+        if (cur != old) {
+            __asm volatile("clrex" ::: "memory");
+            return 0;
+        }
+        __asm volatile("strex %0, %2, [%1]"
+                       : "=&r" (fail) : "r" (p), "r" (new) : "memory");
+    } while (fail);
+    return 1;
+}
+
+#else  // host build
+
+static inline void dmb(void) {
+    __sync_synchronize();
+}
+
+static inline int cas32(volatile uint32_t *p, uint32_t old, uint32_t new) {
+    return __sync_bool_compare_and_swap(p, old, new);
+}
+
+#endif
+
+static inline void atomic_inc(volatile uint32_t *p) {
+    uint32_t v;
+    do {
+        v = *p;
+    } while (!cas32(p, v, v + 1));
+}
+
+#endif
@@ -0,0 +1,56 @@
+# Benchmark results from the serial output of a kernel
+#
+# the kernel prints a line for each result and one at the end:
+#
+#   BENCH <name> <value> <unit>
+#   BENCH end
+#
+# the results are printed as "<name> <value> <unit>". with -v ref=file
+# (an earlier output of this script) every value is compared with the
+# reference, a value lower by more than tol percent is a regression.
+# all the results are rates, higher is better.
+#
+# exit status 1 if "BENCH end" is missing or there is a regression.
+
+BEGIN {
+    if (tol == "") {
+        tol = 10
+    }
+    if (ref != "") {
+        while ((getline line < ref) > 0) {
+            split(line, f, " ")
+            if (f[1] != "") {
+                refval[f[1]] = f[2]
+            }
+        }
+        close(ref)
+    }
+}
+
+{ sub(/\r$/, "") }
+
+$1 == "BENCH" && $2 == "end" { done = 1; next }
+
+$1 == "BENCH" && NF >= 3 {
+    note = ""
+    if (($2 in refval) && (refval[$2] > 0)) {
+        change = ($3 - refval[$2]) * 100 / refval[$2]
+        note = sprintf(" %+.1f%%", change)
+        if (change < -tol) {
+            note = note " REGRESSION"
+            regressions++
+        }
+    }
+    print $2, $3, $4 note
+}
+
+END {
+    if (!done) {
+        print "bench: no BENCH end in the output" > "/dev/stderr"
+        exit 1
+    }
+    if (regressions) {
+        printf "bench: %d regression(s) over %d%%\n", regressions, tol > "/dev/stderr"
+        exit 1
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef BSP_H
+#define BSP_H
+
+// Board support for RPi Zero (BCM2835)
+//
+// Startup code, GPIO, mini UART, system timer, printf and memcpy/memset
+// shared by the examples.
+// Link ../bsp/libbsp.a and include bsp.mk from the Makefile.
+
+#include <stdint.h>
+
+// IOREG(X) is the register at X, IOBASE(X) the address of a register
+// block at X to cast to its struct (spi_t, pcm_t, ...).
+// REG_RD/REG_WR read and write a register: use them for the registers
+// whose access has a side effect (FIFOs, status bits cleared by a write,
+// start bits), so that the host models see every access.
+#ifdef HOST
+// registers are simulated, see host.h
+#include "host.h"
+#define IOREG(X)      (*host_reg(X))
+#define IOBASE(X)     ((uintptr_t) host_reg(X))
+#define REG_RD(r)     host_read(&(r))
+#define REG_WR(r, v)  host_write(&(r), (v))
+#else
+#define IOREG(X)      (*(volatile uint32_t *) (X))
+#define IOBASE(X)     (X)
+#define REG_RD(r)     (r)
+#define REG_WR(r, v)  ((r) = (v))
+#endif
+
+// stack tops of the startup code. the SVC stack grows down from the end
+// of the 100MB that the firmware leaves to the ARM with the default split.
+// IRQ has 16KB down to the FIQ stack, FIQ 8KB down to the UND stack.
+// the UND stack is set only with VFP=1, for the lazy VFP save in the
+// undefined instruction handler, which needs a few words.
+#define BSP_IRQ_STACK  0x00008000
+#define BSP_FIQ_STACK  0x00004000
+#define BSP_UND_STACK  0x00002000
+#define BSP_SVC_STACK  0x06400000
+
+#include "gpio.h"
+#include "uart.h"
+#include "systime.h"
+#include "power.h"
+#include "fmt.h"
+
+#ifndef HOST
+// entry point at 0x8000, also the reset handler of a vector table
+void Init_Machine(void);
+#endif
+
+#endif
@@ -0,0 +1,40 @@
+# include from the Makefile of an example after profile.mk:
+#
+#   BSP = ../bsp
+#   include $(BSP)/profile.mk
+#   include $(BSP)/bsp.mk
+#
+# and add $(LIBBSP) to the prerequisites of kernel.elf.
+
+BSP ?= ../bsp
+INC += -I$(BSP)
+
+ifeq ($(HOST), 1)
+# native executable with simulated registers (see host.h), run it as
+# ./kernel.elf. only examples that access the hardware through bsp.h
+# can be built. make clean before switching between HOST and target.
+LIBBSP = $(BSP)/libbsp_host.a
+CROSS_COMPILE =
+CFLAGS = $(INC) -Wall -Werror -std=c99 -DHOST $(POPT) $(COPT)
+LDFLAGS = -Wl,-Map=$@.map
+LIBGCC =
+else
+ifeq ($(VFP), 1)
+LIBBSP = $(BSP)/libbsp_vfp.a
+else
+LIBBSP = $(BSP)/libbsp.a
+endif
+# Init_Machine is not referenced by any object, pull it out of the archive
+LDFLAGS += -u Init_Machine
+# uart_init divides by the baud rate. libgcc of the same float ABI
+BSP_LIBGCC != $(CC) $(CFLAGS_ARM1176JZF-S) -print-file-name=libgcc.a
+LIBS += $(BSP_LIBGCC)
+endif
+
+$(LIBBSP): $(wildcard $(BSP)/*.c $(BSP)/*.h)
+	$(MAKE) -C $(BSP) COPT="$(COPT)" VFP="$(VFP)" LTO="$(LTO)"
+
+clean ::
+	$(MAKE) -C $(BSP) clean
+
+include $(BSP)/qemu.mk
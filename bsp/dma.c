@@ -0,0 +1,25 @@
+#include <stdint.h>
+#include "bsp.h"
+#include "dma.h"
+
+void dma_init(int ch) {
+    DMA_ENABLE |= (1 << ch);
+    REG_WR(DMA_CH(ch)->CS, DMA_CS_RESET);
+}
+
+void dma_start(int ch, dma_cb_t *cb) {
+    dma_t *dma = DMA_CH(ch);
+    REG_WR(dma->CS, DMA_CS_INT | DMA_CS_END);
+    REG_WR(dma->CONBLK_AD, BUS_ADDR(cb));
+    REG_WR(dma->CS, DMA_CS_WAIT_WR | DMA_CS_PANIC(15) | DMA_CS_PRIO(8) | DMA_CS_ACTIVE);
+}
+
+int dma_busy(int ch) {
+    return REG_RD(DMA_CH(ch)->CS) & DMA_CS_ACTIVE;
+}
+
+void dma_abort(int ch) {
+    dma_t *dma = DMA_CH(ch);
+    REG_WR(dma->CS, DMA_CS_ABORT);
+    REG_WR(dma->CS, DMA_CS_RESET);
+}
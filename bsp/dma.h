@@ -0,0 +1,80 @@
+#ifndef DMA_H
+#define DMA_H
+
+#include <stdint.h>
+#include "bsp.h"
+
+// DMA controller registers
+
+#define DMA_BASE   IOBASE(0x20007000)
+#define DMA_CH(n)  ((dma_t *) (DMA_BASE + (n) * 0x100))
+#define DMA_ENABLE IOREG(0x20007FF0)
+
+typedef volatile struct _dma_t {
+    uint32_t CS;
+    uint32_t CONBLK_AD;
+    uint32_t TI;
+    uint32_t SOURCE_AD;
+    uint32_t DEST_AD;
+    uint32_t TXFR_LEN;
+    uint32_t STRIDE;
+    uint32_t NEXTCONBK;
+    uint32_t DEBUG;
+} dma_t;
+
+#define DMA_CS_RESET    (1<<31)
+#define DMA_CS_ABORT    (1<<30)
+#define DMA_CS_WAIT_WR  (1<<28)
+#define DMA_CS_PANIC(x) ((x)<<20)
+#define DMA_CS_PRIO(x)  ((x)<<16)
+#define DMA_CS_ERROR    (1<<8)
+#define DMA_CS_INT      (1<<2)
+#define DMA_CS_END      (1<<1)
+#define DMA_CS_ACTIVE   (1)
+
+#define DMA_TI_NO_WIDE  (1<<26)
+#define DMA_TI_PERMAP(x) ((x)<<16)
+#define DMA_TI_SRC_IGNORE (1<<11)
+#define DMA_TI_SRC_DREQ (1<<10)
+#define DMA_TI_SRC_INC  (1<<8)
+#define DMA_TI_DEST_IGNORE (1<<7)
+#define DMA_TI_DEST_DREQ (1<<6)
+#define DMA_TI_DEST_INC (1<<4)
+#define DMA_TI_WAIT_RESP (1<<3)
+#define DMA_TI_INTEN    (1)
+
+// peripheral DREQ numbers for PERMAP
+#define DREQ_PCM_TX  2
+#define DREQ_PCM_RX  3
+#define DREQ_PWM     5
+#define DREQ_SPI_TX  6
+#define DREQ_SPI_RX  7
+
+// control block, must be 32 byte aligned
+typedef struct __attribute__((aligned(32))) _dma_cb_t {
+    uint32_t ti;
+    uint32_t source_ad;
+    uint32_t dest_ad;
+    uint32_t txfr_len;
+    uint32_t stride;
+    uint32_t nextconbk;
+    uint32_t reserved[2];
+} dma_cb_t;
+
+// bus addresses seen by DMA
+#define BUS_ADDR(p)   ((uint32_t) (uintptr_t) (p) | 0x40000000)   // RAM (L2 coherent)
+#define PERI_ADDR(p)  (((uint32_t) (uintptr_t) (p) & 0x00FFFFFF) | 0x7E000000)
+
+// enable and reset channel ch
+void dma_init(int ch);
+
+// start a chain of control blocks
+void dma_start(int ch, dma_cb_t *cb);
+
+// returns 1 while the channel is active
+int dma_busy(int ch);
+
+// stop the channel at once
+void dma_abort(int ch);
+
+#endif
@@ -0,0 +1,132 @@
+#include <stdint.h>
+#include "dsp.h"
+
+void dsp_gain(uint32_t *buf, uint32_t n, int16_t gain_l, int16_t gain_r) {
+    uint32_t g = dsp_pack(gain_l, gain_r);
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t f = buf[i];
+        int32_t l = dsp_smlabb(f, g, 0) >> 12;
+        int32_t r = dsp_smlatt(f, g, 0) >> 12;
+        buf[i] = dsp_pack(dsp_sat16(l), dsp_sat16(r));
+    }
+}
+
+void dsp_biquad_init(dsp_biquad_t *bq, int16_t b0, int16_t b1, int16_t b2,
+                     int16_t a1, int16_t a2) {
+    bq->c_b0b1 = dsp_pack(b0, b1);
+    bq->c_b2a1 = dsp_pack(b2, -a1);
+    bq->c_a2 = dsp_pack(-a2, 0);
+    for (int c = 0; c < 2; c++) {
+        bq->x1[c] = 0;
+        bq->s2[c] = 0;
+        bq->y2[c] = 0;
+    }
+}
+
+void dsp_biquad(dsp_biquad_t *bq, uint32_t *buf, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t f = buf[i];
+        int32_t y[2];
+        for (int c = 0; c < 2; c++) {
+            int32_t x0 = c ? DSP_RIGHT(f) : DSP_LEFT(f);
+            // (x[n-1], x[n]) with x[n] replaced
+            uint32_t px = (bq->x1[c] << 16) | ((uint32_t) x0 & 0xffff);
+            int32_t acc = dsp_smlad(px, bq->c_b0b1, 0);
+            acc = dsp_smlad(bq->s2[c], bq->c_b2a1, acc);
+            acc = dsp_smlabb(bq->y2[c], bq->c_a2, acc);
+            y[c] = dsp_sat16(acc >> 14);
+            // shift the states
+            bq->y2[c] = bq->s2[c] >> 16;
+            bq->s2[c] = dsp_pack(bq->x1[c] & 0xffff, y[c]);
+            bq->x1[c] = px;
+        }
+        buf[i] = dsp_pack(y[0], y[1]);
+    }
+}
+
+// y[i] = sum(hr[k] * xs[i + k]) with the taps reversed (hr[k] = h[N-1-k])
+// and xs the history followed by the new samples. Two samples are read
+// as one word, so even outputs use (hr[2j+1], hr[2j]) and odd outputs
+// use (hr[2j], hr[2j-1]) starting one sample earlier.
+void dsp_fir_init(dsp_fir_t *fir, const int16_t *taps, uint32_t ntaps) {
+    int16_t hr[DSP_FIR_MAX_TAPS + 2];
+
+    ntaps = (ntaps > DSP_FIR_MAX_TAPS) ? DSP_FIR_MAX_TAPS : ntaps;
+    uint32_t n = (ntaps + 1) & ~1U;
+    // hr[0] and hr[n + 1] are the zeros around the reversed taps
+    for (uint32_t k = 0; k < n + 2; k++) {
+        hr[k] = 0;
+    }
+    for (uint32_t k = 0; k < ntaps; k++) {
+        hr[1 + n - 1 - k] = taps[k];
+    }
+    for (uint32_t j = 0; j < n / 2; j++) {
+        fir->taps_even[j] = dsp_pack(hr[1 + 2 * j], hr[1 + 2 * j + 1]);
+    }
+    for (uint32_t j = 0; j < n / 2 + 1; j++) {
+        fir->taps_odd[j] = dsp_pack(hr[2 * j], hr[2 * j + 1]);
+    }
+    fir->ntaps = n;
+    for (int c = 0; c < 2; c++) {
+        for (uint32_t i = 0; i < DSP_FIR_MAX_TAPS + DSP_BLOCK_MAX + 2; i++) {
+            fir->hist[c][i] = 0;
+        }
+    }
+}
+
+void dsp_fir(dsp_fir_t *fir, uint32_t *buf, uint32_t n) {
+    uint32_t nt = fir->ntaps;
+    uint32_t nw = nt / 2;
+
+    n = (n > DSP_BLOCK_MAX) ? DSP_BLOCK_MAX : n;
+    for (int c = 0; c < 2; c++) {
+        int16_t *xs = fir->hist[c];
+        const uint32_t *w = (const uint32_t *) xs;
+
+        for (uint32_t i = 0; i < n; i++) {
+            xs[nt - 1 + i] = c ? DSP_RIGHT(buf[i]) : DSP_LEFT(buf[i]);
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            int32_t acc = 0;
+            if ((i & 1) == 0) {
+                const uint32_t *p = &w[i / 2];
+                for (uint32_t j = 0; j < nw; j++) {
+                    acc = dsp_smlad(p[j], fir->taps_even[j], acc);
+                }
+            } else {
+                const uint32_t *p = &w[(i - 1) / 2];
+                for (uint32_t j = 0; j < nw + 1; j++) {
+                    acc = dsp_smlad(p[j], fir->taps_odd[j], acc);
+                }
+            }
+            int32_t y = dsp_sat16(acc >> 15);
+            buf[i] = c ? dsp_pack(DSP_LEFT(buf[i]), y) : dsp_pack(y, DSP_RIGHT(buf[i]));
+        }
+        // keep the last nt - 1 samples as the history
+        for (uint32_t i = 0; i < nt - 1; i++) {
+            xs[i] = xs[n + i];
+        }
+    }
+}
+
+void dsp_mix(uint32_t *buf, const uint32_t *src, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        buf[i] = dsp_qadd16(buf[i], src[i]);
+    }
+}
+
+static inline int32_t soft_clip(int32_t x) {
+    int32_t x2 = (x * x) >> 15;
+    int32_t x3 = (x2 * x) >> 15;
+    return (3 * x - x3) >> 1;
+}
+
+void dsp_soft_clip(uint32_t *buf, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t f = buf[i];
+        int32_t l = soft_clip(DSP_LEFT(f));
+        int32_t r = soft_clip(DSP_RIGHT(f));
+        buf[i] = dsp_pack(dsp_sat16(l), dsp_sat16(r));
+    }
+}
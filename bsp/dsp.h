@@ -0,0 +1,130 @@
+#ifndef DSP_H
+#define DSP_H
+
+// Fixed-point audio DSP kernels
+//
+// A frame is a packed stereo sample, the same format as the PCM FIFO
+// of the i2s example: channel 1 (left) in bits 15:0 and channel 2
+// (right) in bits 31:16, both signed 16-bit.
+//
+// The kernels process a block of frames in place and use the ARMv6
+// SIMD instructions (smlad, qadd16, ssat) through the helpers below.
+// A portable C version of each helper is used on other CPUs.
+
+#include <stdint.h>
+
+#define DSP_BLOCK_MAX     256
+#define DSP_FIR_MAX_TAPS  64
+
+#define DSP_LEFT(f)   ((int16_t) ((f) & 0xffff))
+#define DSP_RIGHT(f)  ((int16_t) ((f) >> 16))
+
+#if defined(__arm__)
+
+// a.lo * b.lo + a.hi * b.hi + acc
+static inline int32_t dsp_smlad(uint32_t a, uint32_t b, int32_t acc) {
+    int32_t r;
+    __asm("smlad %0, %1, %2, %3" : "=r" (r) : "r" (a), "r" (b), "r" (acc));
+    return r;
+}
+
+// a.lo * b.lo + acc
+static inline int32_t dsp_smlabb(uint32_t a, uint32_t b, int32_t acc) {
+    int32_t r;
+    __asm("smlabb %0, %1, %2, %3" : "=r" (r) : "r" (a), "r" (b), "r" (acc));
+    return r;
+}
+
+// a.hi * b.hi + acc
+static inline int32_t dsp_smlatt(uint32_t a, uint32_t b, int32_t acc) {
+    int32_t r;
+    __asm("smlatt %0, %1, %2, %3" : "=r" (r) : "r" (a), "r" (b), "r" (acc));
+    return r;
+}
+
+// saturating add of each halfword
+static inline uint32_t dsp_qadd16(uint32_t a, uint32_t b) {
+    uint32_t r;
+    __asm("qadd16 %0, %1, %2" : "=r" (r) : "r" (a), "r" (b));
+    return r;
+}
+
+// saturate to signed 16-bit
+static inline int32_t dsp_sat16(int32_t a) {
+    int32_t r;
+    __asm("ssat %0, #16, %1" : "=r" (r) : "r" (a));
+    return r;
+}
+
+// lo from the bits 15:0 of lo, hi from the bits 15:0 of hi
+static inline uint32_t dsp_pack(int32_t lo, int32_t hi) {
+    uint32_t r;
+    __asm("pkhbt %0, %1, %2, lsl #16" : "=r" (r) : "r" (lo), "r" (hi));
+    return r;
+}
+
+#else  // host build
+
+static inline int32_t dsp_smlad(uint32_t a, uint32_t b, int32_t acc) {
+    return acc + DSP_LEFT(a) * DSP_LEFT(b) + DSP_RIGHT(a) * DSP_RIGHT(b);
+}
+
+static inline int32_t dsp_smlabb(uint32_t a, uint32_t b, int32_t acc) {
+    return acc + DSP_LEFT(a) * DSP_LEFT(b);
+}
+
+static inline int32_t dsp_smlatt(uint32_t a, uint32_t b, int32_t acc) {
+    return acc + DSP_RIGHT(a) * DSP_RIGHT(b);
+}
+
+static inline int32_t dsp_sat16(int32_t a) {
+    return (a > 32767) ? 32767 : ((a < -32768) ? -32768 : a);
+}
+
+static inline uint32_t dsp_qadd16(uint32_t a, uint32_t b) {
+    int32_t lo = dsp_sat16(DSP_LEFT(a) + DSP_LEFT(b));
+    int32_t hi = dsp_sat16(DSP_RIGHT(a) + DSP_RIGHT(b));
+    return ((uint32_t) hi << 16) | ((uint32_t) lo & 0xffff);
+}
+
+static inline uint32_t dsp_pack(int32_t lo, int32_t hi) {
+    return ((uint32_t) hi << 16) | ((uint32_t) lo & 0xffff);
+}
+
+#endif
+
+// gain of each channel in Q12 (4096 = 1.0, up to 8.0)
+void dsp_gain(uint32_t *buf, uint32_t n, int16_t gain_l, int16_t gain_r);
+
+// biquad IIR filter, direct form I, coefficients in Q14 (a0 = 1.0)
+typedef struct _dsp_biquad_t {
+    uint32_t c_b0b1;            // b1 << 16 | b0
+    uint32_t c_b2a1;            // -a1 << 16 | b2
+    uint32_t c_a2;              // -a2
+    uint32_t x1[2];             // x[n-1] << 16 | x[n] of each channel
+    uint32_t s2[2];             // y[n-1] << 16 | x[n-2] of each channel
+    int32_t y2[2];              // y[n-2] of each channel
+} dsp_biquad_t;
+
+void dsp_biquad_init(dsp_biquad_t *bq, int16_t b0, int16_t b1, int16_t b2,
+                     int16_t a1, int16_t a2);
+void dsp_biquad(dsp_biquad_t *bq, uint32_t *buf, uint32_t n);
+
+// FIR filter, coefficients in Q15
+typedef struct _dsp_fir_t {
+    uint32_t ntaps;             // rounded up to an even number
+    uint32_t taps_even[DSP_FIR_MAX_TAPS / 2];
+    uint32_t taps_odd[DSP_FIR_MAX_TAPS / 2 + 1];
+    int16_t hist[2][DSP_FIR_MAX_TAPS + DSP_BLOCK_MAX + 2] __attribute__((aligned(4)));
+} dsp_fir_t;
+
+void dsp_fir_init(dsp_fir_t *fir, const int16_t *taps, uint32_t ntaps);
+void dsp_fir(dsp_fir_t *fir, uint32_t *buf, uint32_t n);
+
+// buf += src with saturation
+void dsp_mix(uint32_t *buf, const uint32_t *src, uint32_t n);
+
+// cubic soft clipper: y = 1.5x - 0.5x^3 (x in -1.0..1.0)
+void dsp_soft_clip(uint32_t *buf, uint32_t n);
+
+#endif
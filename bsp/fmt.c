@@ -0,0 +1,146 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include "bsp.h"
+
+static const char digits_lower[] = "0123456789abcdef";
+static const char digits_upper[] = "0123456789ABCDEF";
+
+int fmt_format(void (*put)(char c, void *arg), void *arg,
+               const char *fmt, va_list ap) {
+    int len = 0;
+    char buf[11];
+
+    for (; *fmt; fmt++) {
+        if (*fmt != '%') {
+            put(*fmt, arg);
+            len++;
+            continue;
+        }
+        fmt++;
+        char pad = ' ';
+        int width = 0;
+        if (*fmt == '0') {
+            pad = '0';
+            fmt++;
+        }
+        while ((*fmt >= '0') && (*fmt <= '9')) {
+            width = width * 10 + (*fmt++ - '0');
+        }
+        if (*fmt == 'l') {
+            fmt++;
+        }
+
+        const char *s = buf;
+        int n = 0;
+        int neg = 0;
+        uint32_t u;
+        switch (*fmt) {
+        case 'd':
+            u = va_arg(ap, int);
+            if ((int32_t) u < 0) {
+                neg = 1;
+                u = -u;
+            }
+            goto dec;
+        case 'u':
+            u = va_arg(ap, unsigned int);
+        dec:
+            // digits are stored backward from the end of buf
+            do {
+                buf[10 - n++] = '0' + u % 10;
+                u /= 10;
+            } while (u);
+            s = &buf[11 - n];
+            break;
+        case 'x':
+        case 'X': {
+            const char *digits = (*fmt == 'x') ? digits_lower : digits_upper;
+            u = va_arg(ap, unsigned int);
+            do {
+                buf[10 - n++] = digits[u & 0xfU];
+                u >>= 4;
+            } while (u);
+            s = &buf[11 - n];
+            break;
+        }
+        case 'c':
+            buf[0] = va_arg(ap, int);
+            n = 1;
+            break;
+        case 's':
+            s = va_arg(ap, const char *);
+            if (s == NULL) {
+                s = "(null)";
+            }
+            while (s[n]) {
+                n++;
+            }
+            break;
+        case '%':
+            buf[0] = '%';
+            n = 1;
+            break;
+        default:
+            // unknown conversion or end of the string: stop
+            return len;
+        }
+
+        width -= n + neg;
+        if (neg && (pad == '0')) {
+            put('-', arg);
+            len++;
+        }
+        for (; width > 0; width--) {
+            put(pad, arg);
+            len++;
+        }
+        if (neg && (pad == ' ')) {
+            put('-', arg);
+            len++;
+        }
+        for (int i = 0; i < n; i++) {
+            put(s[i], arg);
+        }
+        len += n;
+    }
+    return len;
+}
+
+typedef struct _fmt_buf_t {
+    char *p;
+    char *end;
+} fmt_buf_t;
+
+static void put_buf(char c, void *arg) {
+    fmt_buf_t *b = arg;
+    if (b->p < b->end) {
+        *b->p++ = c;
+    }
+}
+
+int fmt_snprintf(char *buf, size_t size, const char *fmt, ...) {
+    fmt_buf_t b = { buf, buf + ((size > 0) ? size - 1 : 0) };
+    va_list ap;
+
+    va_start(ap, fmt);
+    int len = fmt_format(put_buf, &b, fmt, ap);
+    va_end(ap);
+    if (size > 0) {
+        *b.p = 0;
+    }
+    return len;
+}
+
+static void put_uart(char c, void *arg) {
+    uart_putc(c);
+}
+
+int uart_printf(const char *fmt, ...) {
+    va_list ap;
+
+    va_start(ap, fmt);
+    int len = fmt_format(put_uart, NULL, fmt, ap);
+    va_end(ap);
+    return len;
+}
@@ -0,0 +1,25 @@
+#ifndef FMT_H
+#define FMT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+// Small printf
+//
+// %d %u %x %X %c %s %% with an optional '0' flag and width, and 'l'
+// which is accepted and ignored (long is 32bit). no float.
+
+// format to put(c, arg) for each character, returns the length
+int fmt_format(void (*put)(char c, void *arg), void *arg,
+               const char *fmt, va_list ap);
+
+// format to buf, at most size - 1 characters and a terminating 0.
+// returns the length of the whole output, as snprintf
+int fmt_snprintf(char *buf, size_t size, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+int uart_printf(const char *fmt, ...)
+    __attribute__((format(printf, 1, 2)));
+
+#endif
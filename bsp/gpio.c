@@ -0,0 +1,21 @@
+#include <stdint.h>
+#include "bsp.h"
+
+void gpio_set_function(uint32_t pin, uint32_t func) {
+    volatile uint32_t *fsel = &GPFSEL0 + pin / 10;
+    uint32_t shift = 3 * (pin % 10);
+    *fsel = (*fsel & ~(7U << shift)) | ((func & 7U) << shift);
+}
+
+void gpio_set_pull(uint32_t pin, uint32_t pull) {
+    volatile uint32_t *clk = (pin < 32) ? &GPPUDCLK0 : &GPPUDCLK1;
+
+    // the control signal must be held for 150 cycles before and after
+    // the clock is asserted
+    GPPUD = pull;
+    for (volatile int i = 0; i < 150; i++);
+    *clk = 1U << (pin % 32);
+    for (volatile int i = 0; i < 150; i++);
+    GPPUD = 0;
+    *clk = 0;
+}
@@ -0,0 +1,70 @@
+#ifndef GPIO_H
+#define GPIO_H
+
+#include <stdint.h>
+
+// GPIO registers
+#define GPFSEL0 IOREG(0x20200000)
+#define GPFSEL1 IOREG(0x20200004)
+#define GPFSEL2 IOREG(0x20200008)
+#define GPFSEL3 IOREG(0x2020000C)
+#define GPFSEL4 IOREG(0x20200010)
+#define GPFSEL5 IOREG(0x20200014)
+
+#define GPSET0  IOREG(0x2020001C)
+#define GPSET1  IOREG(0x20200020)
+#define GPCLR0  IOREG(0x20200028)
+#define GPCLR1  IOREG(0x2020002C)
+#define GPLEV0  IOREG(0x20200034)
+#define GPLEV1  IOREG(0x20200038)
+
+#define GPPUD     IOREG(0x20200094)
+#define GPPUDCLK0 IOREG(0x20200098)
+#define GPPUDCLK1 IOREG(0x2020009C)
+
+#define GPF_INPUT  0U
+#define GPF_OUTPUT 1U
+#define GPF_ALT_0  4U
+#define GPF_ALT_1  5U
+#define GPF_ALT_2  6U
+#define GPF_ALT_3  7U
+#define GPF_ALT_4  3U
+#define GPF_ALT_5  2U
+
+#define GPIO_PULL_OFF  0U
+#define GPIO_PULL_DOWN 1U
+#define GPIO_PULL_UP   2U
+
+// set the function of a pin (GPF_*). the other pins of the same
+// GPFSEL register are not changed
+void gpio_set_function(uint32_t pin, uint32_t func);
+
+// set the pull up/down of a pin (GPIO_PULL_*)
+void gpio_set_pull(uint32_t pin, uint32_t pull);
+
+// GPSET/GPCLR only affect the written bits, no read-modify-write needed
+static inline void gpio_set(uint32_t pin) {
+    if (pin < 32) {
+        REG_WR(GPSET0, 1U << pin);
+    } else {
+        REG_WR(GPSET1, 1U << (pin - 32));
+    }
+}
+
+static inline void gpio_clr(uint32_t pin) {
+    if (pin < 32) {
+        REG_WR(GPCLR0, 1U << pin);
+    } else {
+        REG_WR(GPCLR1, 1U << (pin - 32));
+    }
+}
+
+static inline uint32_t gpio_get(uint32_t pin) {
+    if (pin < 32) {
+        return (GPLEV0 >> pin) & 1U;
+    } else {
+        return (GPLEV1 >> (pin - 32)) & 1U;
+    }
+}
+
+#endif
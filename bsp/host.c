@@ -0,0 +1,621 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include "bsp.h"
+
+#define REG_INDEX(addr)  (((addr) - HOST_PERI_BASE) / 4)
+
+static uint32_t peri[HOST_PERI_SIZE / 4];
+
+static int started = 0;
+static struct timespec t0;
+
+static int rx_byte = -1;        // received byte not read yet
+static uint32_t gpio_level[2];
+
+static uint64_t host_us(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t) (t.tv_sec - t0.tv_sec) * 1000000
+        + (t.tv_nsec - t0.tv_nsec) / 1000;
+}
+
+static void rx_poll(void) {
+    struct pollfd fd = { .fd = 0, .events = POLLIN };
+    unsigned char c;
+
+    if ((rx_byte < 0) && (poll(&fd, 1, 0) > 0) && (read(0, &c, 1) == 1)) {
+        rx_byte = c;
+    }
+}
+
+static void gpio_write(int bank, uint32_t set, uint32_t clr) {
+    uint32_t old = gpio_level[bank];
+    gpio_level[bank] = (old | set) & ~clr;
+    if (getenv("HOST_GPIO") && (old != gpio_level[bank])) {
+        uint32_t changed = old ^ gpio_level[bank];
+        for (int i = 0; i < 32; i++) {
+            if (changed & (1U << i)) {
+                fprintf(stderr, "%10llu GPIO%d %d\n",
+                        (unsigned long long) host_us(), bank * 32 + i,
+                        (gpio_level[bank] >> i) & 1);
+            }
+        }
+    }
+}
+
+// FIFOs of the SPI, BSC and PCM models
+
+typedef struct _fifo_t {
+    uint32_t data[64];
+    uint32_t size;
+    uint32_t rd;
+    uint32_t n;
+} fifo_t;
+
+static void fifo_clear(fifo_t *f) {
+    f->rd = 0;
+    f->n = 0;
+}
+
+// returns 0 if the FIFO is full
+static int fifo_push(fifo_t *f, uint32_t v) {
+    if (f->n == f->size) {
+        return 0;
+    }
+    f->data[(f->rd + f->n) % f->size] = v;
+    f->n++;
+    return 1;
+}
+
+// returns 0 if the FIFO is empty
+static int fifo_pop(fifo_t *f, uint32_t *v) {
+    if (f->n == 0) {
+        return 0;
+    }
+    *v = f->data[f->rd];
+    f->rd = (f->rd + 1) % f->size;
+    f->n--;
+    return 1;
+}
+
+static void fail(const char *msg, uint32_t addr) {
+    fprintf(stderr, "host: %s (0x%08x)\n", msg, (unsigned) addr);
+    abort();
+}
+
+// SPI0
+
+#define SPI_BASE     0x20204000U
+#define SPI_CS       (SPI_BASE + 0x00)
+#define SPI_FIFO     (SPI_BASE + 0x04)
+
+#define SPI_CS_RXF   (1U << 20)
+#define SPI_CS_RXR   (1U << 19)
+#define SPI_CS_TXD   (1U << 18)
+#define SPI_CS_RXD   (1U << 17)
+#define SPI_CS_DONE  (1U << 16)
+#define SPI_CS_TA    (1U << 7)
+#define SPI_CS_CLEAR_RX  (1U << 5)
+#define SPI_CS_CLEAR_TX  (1U << 4)
+#define SPI_CS_STATUS    (SPI_CS_RXF | SPI_CS_RXR | SPI_CS_TXD | SPI_CS_RXD | SPI_CS_DONE)
+
+static uint8_t spi_loopback(int cs, uint8_t mosi, int first) {
+    return mosi;
+}
+
+static struct {
+    fifo_t tx;
+    fifo_t rx;
+    int first;
+    host_spi_dev_t dev;
+} spi = {
+    .tx = { .size = 16 },
+    .rx = { .size = 16 },
+    .dev = spi_loopback,
+};
+
+void host_spi_attach(host_spi_dev_t dev) {
+    spi.dev = dev ? dev : spi_loopback;
+}
+
+static void spi_status(void) {
+    uint32_t *cs = &peri[REG_INDEX(SPI_CS)];
+    uint32_t s = 0;
+
+    if ((*cs & SPI_CS_TA) && (spi.tx.n == 0)) {
+        s |= SPI_CS_DONE;
+    }
+    s |= (spi.tx.n < spi.tx.size) ? SPI_CS_TXD : 0;
+    s |= (spi.rx.n > 0) ? SPI_CS_RXD : 0;
+    s |= (spi.rx.n >= spi.rx.size * 3 / 4) ? SPI_CS_RXR : 0;
+    s |= (spi.rx.n == spi.rx.size) ? SPI_CS_RXF : 0;
+    *cs = (*cs & ~SPI_CS_STATUS) | s;
+}
+
+// shift one byte: a full RX FIFO stops the transfer as on the hardware
+static void spi_step(void) {
+    uint32_t cs = peri[REG_INDEX(SPI_CS)];
+    uint32_t mosi;
+
+    if ((cs & SPI_CS_TA) && (spi.rx.n < spi.rx.size) && fifo_pop(&spi.tx, &mosi)) {
+        fifo_push(&spi.rx, spi.dev(cs & 3, mosi, spi.first));
+        spi.first = 0;
+    }
+}
+
+static void spi_write_cs(uint32_t v) {
+    uint32_t *cs = &peri[REG_INDEX(SPI_CS)];
+
+    if (v & SPI_CS_CLEAR_TX) {
+        fifo_clear(&spi.tx);
+    }
+    if (v & SPI_CS_CLEAR_RX) {
+        fifo_clear(&spi.rx);
+    }
+    if ((v & SPI_CS_TA) && !(*cs & SPI_CS_TA)) {
+        spi.first = 1;
+    }
+    *cs = v & ~(SPI_CS_STATUS | SPI_CS_CLEAR_TX | SPI_CS_CLEAR_RX);
+}
+
+// BSC0, BSC1, BSC2
+
+#define BSC_C        0x00
+#define BSC_S        0x04
+#define BSC_DLEN     0x08
+#define BSC_A        0x0C
+#define BSC_FIFO     0x10
+#define BSC_SIZE     0x20
+
+#define BSC_C_ST     (1U << 7)
+#define BSC_C_CLEAR  (3U << 4)
+#define BSC_C_READ   (1U)
+
+#define BSC_S_CLKT   (1U << 9)
+#define BSC_S_ERR    (1U << 8)
+#define BSC_S_RXF    (1U << 7)
+#define BSC_S_TXE    (1U << 6)
+#define BSC_S_RXD    (1U << 5)
+#define BSC_S_TXD    (1U << 4)
+#define BSC_S_RXR    (1U << 3)
+#define BSC_S_TXW    (1U << 2)
+#define BSC_S_DONE   (1U << 1)
+#define BSC_S_TA     (1U)
+
+#define I2C_SLAVES   8
+
+static const uint32_t bsc_base[3] = { 0x20205000U, 0x20804000U, 0x20805000U };
+
+typedef struct _i2c_slave_t {
+    int bus;
+    uint8_t addr;
+    uint8_t *regs;
+    uint32_t size;
+    uint32_t ptr;               // register pointer
+} i2c_slave_t;
+
+typedef struct _bsc_t {
+    fifo_t tx;
+    fifo_t rx;
+    uint32_t flags;             // TA, DONE, ERR, CLKT
+    int reading;
+    int starting;               // START or repeated START not sent yet
+    int first;                  // next byte written is the register address
+    uint32_t remaining;
+    int pending;                // transfer programmed while TA was set
+    int pending_read;
+    uint32_t pending_len;
+    i2c_slave_t *slave;
+    uint32_t fail;              // ERR or CLKT injected by host_i2c_fail()
+    uint32_t fail_after;        // data bytes before the failure
+} bsc_t;
+
+#define BSC_INIT  { .tx = { .size = 16 }, .rx = { .size = 16 } }
+
+static bsc_t bsc[3] = { BSC_INIT, BSC_INIT, BSC_INIT };
+static i2c_slave_t i2c_slaves[I2C_SLAVES];
+static int i2c_nslaves = 0;
+
+void host_i2c_attach(int bus, uint8_t addr, uint8_t *regs, uint32_t size) {
+    if (i2c_nslaves == I2C_SLAVES) {
+        fail("too many I2C slaves", addr);
+    }
+    i2c_slaves[i2c_nslaves++] = (i2c_slave_t) {
+        .bus = bus, .addr = addr, .regs = regs, .size = size, .ptr = 0,
+    };
+}
+
+void host_i2c_fail(int bus, uint32_t status, uint32_t bytes) {
+    bsc[bus].fail = status & (BSC_S_ERR | BSC_S_CLKT);
+    bsc[bus].fail_after = bytes;
+}
+
+// returns the bus of a register address or -1
+static int bsc_bus(uint32_t addr) {
+    for (int i = 0; i < 3; i++) {
+        if ((addr >= bsc_base[i]) && (addr < bsc_base[i] + BSC_SIZE)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static uint32_t *bsc_reg(int bus, uint32_t off) {
+    return &peri[REG_INDEX(bsc_base[bus] + off)];
+}
+
+static void bsc_start(int bus, int reading, uint32_t len) {
+    bsc_t *b = &bsc[bus];
+
+    b->flags |= BSC_S_TA;
+    b->reading = reading;
+    b->remaining = len;
+    b->starting = 1;
+    b->slave = NULL;
+}
+
+// end the transfer with ERR or CLKT, a repeated start is not sent
+static void bsc_abort(int bus, uint32_t status) {
+    bsc_t *b = &bsc[bus];
+
+    b->pending = 0;
+    b->fail = 0;
+    b->flags = (b->flags & ~BSC_S_TA) | status | BSC_S_DONE;
+}
+
+static void bsc_end_phase(int bus) {
+    bsc_t *b = &bsc[bus];
+
+    if (b->pending) {
+        // repeated start, no DONE between the phases
+        b->pending = 0;
+        bsc_start(bus, b->pending_read, b->pending_len);
+    } else {
+        b->flags = (b->flags & ~BSC_S_TA) | BSC_S_DONE;
+    }
+}
+
+// send the address or move one byte
+static void bsc_step(int bus) {
+    bsc_t *b = &bsc[bus];
+    uint32_t v;
+
+    if (!(b->flags & BSC_S_TA)) {
+        return;
+    }
+    if (b->starting) {
+        uint8_t addr = *bsc_reg(bus, BSC_A) & 0x7fU;
+        b->starting = 0;
+        for (int i = 0; i < i2c_nslaves; i++) {
+            if ((i2c_slaves[i].bus == bus) && (i2c_slaves[i].addr == addr)) {
+                b->slave = &i2c_slaves[i];
+            }
+        }
+        if (b->slave == NULL) {
+            // no ACK of the address
+            bsc_abort(bus, BSC_S_ERR);
+            return;
+        }
+        if (b->fail && (b->fail_after == 0)) {
+            bsc_abort(bus, b->fail);
+            return;
+        }
+        b->first = !b->reading;
+        return;
+    }
+    if (b->remaining == 0) {
+        bsc_end_phase(bus);
+        return;
+    }
+    i2c_slave_t *s = b->slave;
+    int ready = b->reading ? (b->rx.n < b->rx.size) : (b->tx.n > 0);
+    if (ready && b->fail && (--b->fail_after == 0)) {
+        bsc_abort(bus, b->fail);
+        return;
+    }
+    if (b->reading) {
+        if (b->rx.n == b->rx.size) {
+            // SCL is held low until the FIFO is read
+            return;
+        }
+        fifo_push(&b->rx, s->regs[s->ptr++ % s->size]);
+    } else {
+        if (!fifo_pop(&b->tx, &v)) {
+            return;
+        }
+        if (b->first) {
+            s->ptr = v & 0xffU;
+            b->first = 0;
+        } else {
+            s->regs[s->ptr++ % s->size] = v;
+        }
+    }
+    if (--b->remaining == 0) {
+        bsc_end_phase(bus);
+    }
+}
+
+static void bsc_status(int bus) {
+    bsc_t *b = &bsc[bus];
+    uint32_t s = b->flags;
+
+    if (b->tx.n == 0) {
+        s |= BSC_S_TXE;
+    }
+    if (b->tx.n < b->tx.size) {
+        s |= BSC_S_TXD;
+        if ((b->flags & BSC_S_TA) && !b->reading) {
+            s |= BSC_S_TXW;
+        }
+    }
+    if (b->rx.n > 0) {
+        s |= BSC_S_RXD;
+    }
+    if ((b->flags & BSC_S_TA) && b->reading && (b->rx.n >= b->rx.size * 3 / 4)) {
+        s |= BSC_S_RXR;
+    }
+    if (b->rx.n == b->rx.size) {
+        s |= BSC_S_RXF;
+    }
+    *bsc_reg(bus, BSC_S) = s;
+}
+
+static void bsc_write_c(int bus, uint32_t v) {
+    bsc_t *b = &bsc[bus];
+
+    if (v & BSC_C_CLEAR) {
+        fifo_clear(&b->tx);
+        fifo_clear(&b->rx);
+    }
+    if (v & BSC_C_ST) {
+        uint32_t len = *bsc_reg(bus, BSC_DLEN) & 0xffffU;
+        if (b->flags & BSC_S_TA) {
+            b->pending = 1;
+            b->pending_read = v & BSC_C_READ;
+            b->pending_len = len;
+        } else {
+            bsc_start(bus, v & BSC_C_READ, len);
+        }
+    }
+    *bsc_reg(bus, BSC_C) = v & ~(BSC_C_ST | BSC_C_CLEAR);
+}
+
+// PCM
+
+#define PCM_BASE     0x20203000U
+#define PCM_CS       (PCM_BASE + 0x00)
+#define PCM_FIFO     (PCM_BASE + 0x04)
+
+#define PCM_CS_SYNC  (1U << 24)
+#define PCM_CS_RXF   (1U << 22)
+#define PCM_CS_TXE   (1U << 21)
+#define PCM_CS_RXD   (1U << 20)
+#define PCM_CS_TXD   (1U << 19)
+#define PCM_CS_RXR   (1U << 18)
+#define PCM_CS_TXW   (1U << 17)
+#define PCM_CS_RXERR (1U << 16)
+#define PCM_CS_TXERR (1U << 15)
+#define PCM_CS_RXCLR (1U << 4)
+#define PCM_CS_TXCLR (1U << 3)
+#define PCM_CS_TXON  (1U << 2)
+#define PCM_CS_RXON  (1U << 1)
+#define PCM_CS_EN    (1U)
+#define PCM_CS_STATUS  (PCM_CS_RXF | PCM_CS_TXE | PCM_CS_RXD | PCM_CS_TXD \
+                        | PCM_CS_RXR | PCM_CS_TXW)
+
+static struct {
+    fifo_t tx;
+    fifo_t rx;
+    uint32_t errors;            // TXERR, RXERR
+} pcm = {
+    .tx = { .size = 64 },
+    .rx = { .size = 64 },
+};
+
+// one frame: TX FIFO to DOUT, DIN to RX FIFO
+static void pcm_step(void) {
+    uint32_t cs = peri[REG_INDEX(PCM_CS)];
+    uint32_t v = 0;
+
+    if (!(cs & PCM_CS_EN) || !(cs & (PCM_CS_TXON | PCM_CS_RXON))) {
+        return;
+    }
+    if ((cs & PCM_CS_TXON) && !fifo_pop(&pcm.tx, &v)) {
+        pcm.errors |= PCM_CS_TXERR;
+    }
+    if ((cs & PCM_CS_RXON) && !fifo_push(&pcm.rx, v)) {
+        pcm.errors |= PCM_CS_RXERR;
+    }
+}
+
+static void pcm_status(void) {
+    uint32_t *cs = &peri[REG_INDEX(PCM_CS)];
+    uint32_t s = pcm.errors;
+
+    s |= (pcm.tx.n == 0) ? PCM_CS_TXE : 0;
+    s |= (pcm.tx.n < pcm.tx.size) ? PCM_CS_TXD : 0;
+    s |= (pcm.tx.n < pcm.tx.size / 2) ? PCM_CS_TXW : 0;
+    s |= (pcm.rx.n > 0) ? PCM_CS_RXD : 0;
+    s |= (pcm.rx.n >= pcm.rx.size / 2) ? PCM_CS_RXR : 0;
+    s |= (pcm.rx.n == pcm.rx.size) ? PCM_CS_RXF : 0;
+    *cs = (*cs & ~(PCM_CS_STATUS | PCM_CS_TXERR | PCM_CS_RXERR)) | s;
+}
+
+static void pcm_write_cs(uint32_t v) {
+    if (v & PCM_CS_TXCLR) {
+        fifo_clear(&pcm.tx);
+    }
+    if (v & PCM_CS_RXCLR) {
+        fifo_clear(&pcm.rx);
+    }
+    // the error flags are cleared by writing 1, SYNC reads back what
+    // was written
+    pcm.errors &= ~(v & (PCM_CS_TXERR | PCM_CS_RXERR));
+    peri[REG_INDEX(PCM_CS)] = v & ~(PCM_CS_STATUS | PCM_CS_TXERR | PCM_CS_RXERR
+                                    | PCM_CS_TXCLR | PCM_CS_RXCLR);
+}
+
+// register access
+
+// set the value that a read of addr returns
+static void update(uint32_t addr) {
+    uint32_t *reg = &peri[REG_INDEX(addr)];
+    uint64_t t;
+    int bus;
+
+    switch (addr) {
+    case 0x20003004:    // SYST_CLO
+    case 0x20003008:    // SYST_CHI
+        t = host_us();
+        peri[REG_INDEX(0x20003004)] = (uint32_t) t;
+        peri[REG_INDEX(0x20003008)] = (uint32_t) (t >> 32);
+        break;
+    case 0x20215054:    // MU_LSR
+        rx_poll();
+        *reg = MU_LSR_TX_IDLE | MU_LSR_TX_EMPTY | ((rx_byte >= 0) ? MU_LSR_RX_RDY : 0);
+        break;
+    case 0x20215040:    // MU_IO
+        *reg = (rx_byte >= 0) ? rx_byte : 0;
+        break;
+    case 0x2020001C:    // GPSET0, GPSET1, GPCLR0, GPCLR1 read as 0
+    case 0x20200020:
+    case 0x20200028:
+    case 0x2020002C:
+        *reg = 0;
+        break;
+    case 0x20200034:    // GPLEV0
+        *reg = gpio_level[0];
+        break;
+    case 0x20200038:    // GPLEV1
+        *reg = gpio_level[1];
+        break;
+    case SPI_CS:
+        spi_status();
+        break;
+    case PCM_CS:
+        pcm_status();
+        break;
+    default:
+        bus = bsc_bus(addr);
+        if ((bus >= 0) && (addr == bsc_base[bus] + BSC_S)) {
+            bsc_status(bus);
+        }
+        break;
+    }
+}
+
+static uint32_t reg_addr(volatile uint32_t *reg) {
+    uintptr_t i = (uintptr_t) (reg - (volatile uint32_t *) peri);
+
+    if (i >= HOST_PERI_SIZE / 4) {
+        fprintf(stderr, "host: %p is not a peripheral register\n", (void *) reg);
+        abort();
+    }
+    return HOST_PERI_BASE + i * 4;
+}
+
+volatile uint32_t *host_reg(uint32_t addr) {
+    if (!started) {
+        started = 1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+    }
+    if ((addr < HOST_PERI_BASE) || (addr >= HOST_PERI_BASE + HOST_PERI_SIZE) || (addr & 3)) {
+        fprintf(stderr, "host: access to 0x%08x is not a peripheral register\n", (unsigned) addr);
+        abort();
+    }
+    update(addr);
+    return &peri[REG_INDEX(addr)];
+}
+
+uint32_t host_read(volatile uint32_t *reg) {
+    uint32_t addr = reg_addr(reg);
+    int bus = bsc_bus(addr);
+    uint32_t v;
+
+    // the transfers advance on the status reads
+    if (addr == SPI_CS) {
+        spi_step();
+    } else if (addr == PCM_CS) {
+        pcm_step();
+    } else if ((bus >= 0) && (addr == bsc_base[bus] + BSC_S)) {
+        bsc_step(bus);
+    }
+    v = *host_reg(addr);
+
+    // FIFOs are popped by the read
+    if (addr == 0x20215040) {           // MU_IO
+        rx_byte = -1;
+    } else if (addr == SPI_FIFO) {
+        fifo_pop(&spi.rx, &v);
+    } else if (addr == PCM_FIFO) {
+        if (!fifo_pop(&pcm.rx, &v)) {
+            pcm.errors |= PCM_CS_RXERR;
+        }
+    } else if ((bus >= 0) && (addr == bsc_base[bus] + BSC_FIFO)) {
+        fifo_pop(&bsc[bus].rx, &v);
+    }
+    peri[REG_INDEX(addr)] = v;
+    return v;
+}
+
+void host_write(volatile uint32_t *reg, uint32_t value) {
+    uint32_t addr = reg_addr(reg);
+    int bus = bsc_bus(addr);
+
+    host_reg(addr);
+    switch (addr) {
+    case 0x20215040:    // MU_IO
+        putchar(value & 0xffU);
+        fflush(stdout);
+        break;
+    case 0x2020001C:    // GPSET0
+        gpio_write(0, value, 0);
+        break;
+    case 0x20200020:    // GPSET1
+        gpio_write(1, value, 0);
+        break;
+    case 0x20200028:    // GPCLR0
+        gpio_write(0, 0, value);
+        break;
+    case 0x2020002C:    // GPCLR1
+        gpio_write(1, 0, value);
+        break;
+    case SPI_CS:
+        spi_write_cs(value);
+        break;
+    case SPI_FIFO:
+        if (!fifo_push(&spi.tx, value & 0xffU)) {
+            fail("SPI TX FIFO overflow", addr);
+        }
+        break;
+    case PCM_CS:
+        pcm_write_cs(value);
+        break;
+    case PCM_FIFO:
+        if (!fifo_push(&pcm.tx, value)) {
+            pcm.errors |= PCM_CS_TXERR;
+        }
+        break;
+    default:
+        if (bus < 0) {
+            *reg = value;
+        } else if (addr == bsc_base[bus] + BSC_C) {
+            bsc_write_c(bus, value);
+        } else if (addr == bsc_base[bus] + BSC_S) {
+            // DONE, ERR and CLKT are cleared by writing 1
+            bsc[bus].flags &= ~(value & (BSC_S_DONE | BSC_S_ERR | BSC_S_CLKT));
+        } else if (addr == bsc_base[bus] + BSC_FIFO) {
+            if (!fifo_push(&bsc[bus].tx, value & 0xffU)) {
+                fail("BSC TX FIFO overflow", addr);
+            }
+        } else {
+            *reg = value;
+        }
+        break;
+    }
+}
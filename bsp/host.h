@@ -0,0 +1,63 @@
+#ifndef HOST_H
+#define HOST_H
+
+// Host build (make HOST=1)
+//
+// The peripheral registers are words of a simulated block in memory.
+// REG_WR() and REG_RD() of bsp.h call host_write() and host_read(),
+// which run the behaviour models of the peripherals on every access:
+//
+//   system timer  CLO/CHI count in us from the start of the program
+//   mini UART     MU_IO writes go to stdout, reads come from stdin,
+//                 LSR reports TX_EMPTY/TX_IDLE and RX_RDY
+//   GPIO          GPSET/GPCLR change the levels read from GPLEV,
+//                 changes of the outputs are traced to stderr when
+//                 HOST_GPIO is set in the environment
+//   SPI0          16 word TX/RX FIFOs, TA, DONE, TXD, RXD, RXR, RXF and
+//                 CLEAR. a slave (host_spi_attach) answers each byte,
+//                 the default one loops MOSI back to MISO
+//   BSC0-2        16 byte FIFOs, ST, TA, DONE, ERR (NACK of an address
+//                 without a slave), CLKT and ERR injected by
+//                 host_i2c_fail(), TXW/TXD/TXE, RXR/RXD/RXF and the
+//                 repeated start of a read programmed while TA is set.
+//                 slaves are register files (host_i2c_attach)
+//   PCM           64 word FIFOs, TXCLR/RXCLR, SYNC, TXERR/RXERR and the
+//                 FIFO flags. DOUT is looped back to DIN
+//
+// The transfers advance on the reads of the status register (SPI CS,
+// BSC S, PCM CS): one byte (SPI, BSC) or one frame (PCM) per read, so
+// that a polling loop sees the FIFOs fill and drain.
+//
+// IOREG() returns the word itself through host_reg(). Reads of status
+// registers return the current state, but an access through IOREG() has
+// no side effect: a write is only stored and a read does not pop a FIFO.
+// DMA and the clock manager are not simulated, their registers read back
+// what was written.
+
+#include <stdint.h>
+
+#define HOST_PERI_BASE 0x20000000U
+#define HOST_PERI_SIZE 0x01000000U
+
+volatile uint32_t *host_reg(uint32_t addr);
+
+uint32_t host_read(volatile uint32_t *reg);
+void host_write(volatile uint32_t *reg, uint32_t value);
+
+// SPI0 slave: returns the MISO byte for mosi. first is 1 for the first
+// byte after TA is set
+typedef uint8_t (*host_spi_dev_t)(int cs, uint8_t mosi, int first);
+
+void host_spi_attach(host_spi_dev_t dev);
+
+// I2C slave at addr on BSC bus with size registers. the first byte
+// written after a START is the register address, the following bytes
+// are written from there and reads continue from there
+void host_i2c_attach(int bus, uint8_t addr, uint8_t *regs, uint32_t size);
+
+// make the next transfer on BSC bus end with status, S_ERR (no ACK) or
+// S_CLKT (clock stretch timeout), after bytes data bytes. 0 fails the
+// address
+void host_i2c_fail(int bus, uint32_t status, uint32_t bytes);
+
+#endif
@@ -0,0 +1,342 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "bsp.h"
+#include "i2c.h"
+
+#ifdef HOST
+// no interrupts on the host, i2c_isr() is called by the test
+static inline uint32_t cpu_irq_save(void) {
+    return 0;
+}
+
+static inline void cpu_irq_restore(uint32_t cpsr) {
+}
+#else
+static inline uint32_t cpu_irq_save(void) {
+    uint32_t cpsr;
+    __asm volatile("mrs %0, cpsr \n"
+                   "cpsid i \n" : "=r" (cpsr) :: "memory");
+    return cpsr;
+}
+
+static inline void cpu_irq_restore(uint32_t cpsr) {
+    __asm volatile("msr cpsr_c, %0" :: "r" (cpsr) : "memory");
+}
+#endif
+
+int i2c_init(i2c_bus_t *bus, int id) {
+    i2c_t *regs;
+
+    switch (id) {
+    case 0:
+        regs = (i2c_t *) BSC0;
+        break;
+    case 1:
+        regs = (i2c_t *) BSC1;
+        break;
+    case 2:
+        regs = (i2c_t *) BSC2;
+        break;
+    default:
+        return -1;
+    }
+
+    if (id < 2) {
+        // set GPIO0, GPIO1 (BSC0) or GPIO2, GPIO3 (BSC1) to alternate function 0
+        uint32_t pin = id * 2;
+        uint32_t sel = GPFSEL0;
+        sel &= ~((7U << (3*pin)) | (7U << (3*(pin + 1))));
+        sel |= (GPF_ALT_0 << (3*pin)) | (GPF_ALT_0 << (3*(pin + 1)));
+        GPFSEL0 = sel;
+    }
+    bus->regs = regs;
+    bus->id = id;
+    bus->head = NULL;
+    bus->tail = NULL;
+    bus->reading = 0;
+    bus->pos = 0;
+    REG_WR(regs->C, C_I2CEN | C_CLEAR);
+    REG_WR(regs->S, S_CLKT | S_ERR | S_DONE);
+    return 0;
+}
+
+uint32_t i2c_set_clock_speed(i2c_bus_t *bus, uint32_t speed) {
+    // DIV is rounded up so that SCL never exceeds the speed
+    uint32_t cdiv = (I2C_CORE_CLOCK + speed - 1) / speed;
+    cdiv = (cdiv < 2) ? 2 : cdiv;
+    cdiv = (cdiv > 0xfffe) ? 0xfffe : cdiv;
+    cdiv = (cdiv + 1) & ~1U;    // BSC uses an even divisor only
+    REG_WR(bus->regs->DIV, cdiv);
+    // sample and change SDA a bit after the edges of SCL
+    uint32_t fedl = (cdiv > 15) ? (cdiv / 16) : 1;
+    uint32_t redl = (cdiv > 3) ? (cdiv / 4) : 1;
+    i2c_set_delay(bus, fedl, redl);
+    return I2C_CORE_CLOCK / cdiv;
+}
+
+uint32_t i2c_get_clock_speed(i2c_bus_t *bus) {
+    return I2C_CORE_CLOCK / REG_RD(bus->regs->DIV);
+}
+
+void i2c_set_delay(i2c_bus_t *bus, uint32_t fedl, uint32_t redl) {
+    uint32_t max = REG_RD(bus->regs->DIV) / 2 - 1;
+    fedl = (fedl > max) ? max : fedl;
+    redl = (redl > max) ? max : redl;
+    REG_WR(bus->regs->DEL, (fedl << 16) | redl);
+}
+
+void i2c_set_timeout(i2c_bus_t *bus, uint32_t tout) {
+    REG_WR(bus->regs->CLKT, tout & 0xffffU);
+}
+
+// bound of the wait for TA in start_write(), in us. TA is set when BSC
+// sends START, a few core clocks after ST on an idle bus
+#define TA_WAIT  10
+
+// start the write phase of the transaction at the head of the queue.
+// the FIFO is filled before ST is set and refilled by the TXW interrupt.
+// returns I2C_PENDING, or the error if the transfer already ended with
+// ERR or CLKT while waiting for TA
+static int start_write(i2c_bus_t *bus) {
+    i2c_t *i2c = bus->regs;
+    i2c_xfer_t *x = bus->head;
+
+    bus->reading = 0;
+    bus->pos = 0;
+    REG_WR(i2c->A, x->addr & 0x7FU);
+    REG_WR(i2c->DLEN, x->wlen);
+    REG_WR(i2c->S, S_CLKT | S_ERR | S_DONE);
+    REG_WR(i2c->C, C_I2CEN | C_CLEAR);
+    while ((bus->pos < x->wlen) && (REG_RD(i2c->S) & S_TXD)) {
+        REG_WR(i2c->FIFO, x->wbuf[bus->pos++]);
+    }
+    if ((x->rlen != 0) && (bus->pos == x->wlen)) {
+        // whole write phase is in the FIFO: program the read phase as
+        // soon as the transfer is active, so that BSC sends a repeated
+        // start instead of STOP after the last byte is written
+        uint32_t t0 = SYST_CLO;
+        uint32_t s;
+        REG_WR(i2c->C, C_I2CEN | C_ST);
+        do {
+            s = REG_RD(i2c->S);
+        } while (!(s & (S_TA | S_DONE | S_ERR | S_CLKT)) && (SYST_CLO - t0 < TA_WAIT));
+        if (s & S_ERR) {
+            return I2C_ERR_NACK;
+        } else if (s & S_CLKT) {
+            return I2C_ERR_CLKT;
+        } else if ((s & (S_TA | S_DONE)) == S_TA) {
+            bus->reading = 1;
+            bus->pos = 0;
+            REG_WR(i2c->DLEN, x->rlen);
+            REG_WR(i2c->C, C_I2CEN | C_INTR | C_INTD | C_ST | C_READ);
+        } else {
+            // TA not seen in time or the write phase is already done:
+            // the read follows with STOP and START from the DONE interrupt
+            REG_WR(i2c->C, C_I2CEN | C_INTD);
+        }
+    } else if (bus->pos < x->wlen) {
+        REG_WR(i2c->C, C_I2CEN | C_INTT | C_INTD | C_ST);
+    } else {
+        REG_WR(i2c->C, C_I2CEN | C_INTD | C_ST);
+    }
+    return I2C_PENDING;
+}
+
+static void start_read(i2c_bus_t *bus) {
+    i2c_t *i2c = bus->regs;
+    i2c_xfer_t *x = bus->head;
+
+    bus->reading = 1;
+    bus->pos = 0;
+    // a read only transaction starts here, A may be of the previous one
+    REG_WR(i2c->A, x->addr & 0x7FU);
+    REG_WR(i2c->DLEN, x->rlen);
+    REG_WR(i2c->S, S_CLKT | S_ERR | S_DONE);
+    REG_WR(i2c->C, C_I2CEN | C_CLEAR);
+    REG_WR(i2c->C, C_I2CEN | C_INTR | C_INTD | C_ST | C_READ);
+}
+
+// complete the running transaction
+static void complete(i2c_bus_t *bus, int status) {
+    i2c_xfer_t *x = bus->head;
+
+    REG_WR(bus->regs->C, C_I2CEN);
+    bus->head = x->next;
+    if (bus->head == NULL) {
+        bus->tail = NULL;
+    }
+    x->next = NULL;
+    x->status = status;
+    if (x->callback) {
+        x->callback(x);
+    }
+}
+
+// start the transaction at the head of the queue. the transactions
+// which fail in start_write() are completed here in a loop, not by
+// recursion through finish()
+static void start(i2c_bus_t *bus) {
+    while (bus->head) {
+        i2c_xfer_t *x = bus->head;
+        int status;
+
+        if ((x->wlen == 0) && (x->rlen != 0)) {
+            start_read(bus);
+            return;
+        }
+        status = start_write(bus);
+        if (status == I2C_PENDING) {
+            return;
+        }
+        REG_WR(bus->regs->S, S_CLKT | S_ERR | S_DONE);
+        complete(bus, status);
+    }
+}
+
+// complete the running transaction and start the next one
+static void finish(i2c_bus_t *bus, int status) {
+    complete(bus, status);
+    start(bus);
+}
+
+void i2c_submit(i2c_bus_t *bus, i2c_xfer_t *xfer) {
+    i2c_xfer_t *last = xfer;
+
+    for (i2c_xfer_t *x = xfer; x; x = x->next) {
+        x->status = I2C_PENDING;
+        last = x;
+    }
+
+    uint32_t cpsr = cpu_irq_save();
+    if (bus->head == NULL) {
+        bus->head = xfer;
+        bus->tail = last;
+        start(bus);
+    } else {
+        bus->tail->next = xfer;
+        bus->tail = last;
+    }
+    cpu_irq_restore(cpsr);
+}
+
+int i2c_idle(i2c_bus_t *bus) {
+    return bus->head == NULL;
+}
+
+// blocking transfers
+
+int i2c_write_read(i2c_bus_t *bus, uint8_t addr, const uint8_t *wbuf,
+                   uint32_t wlen, uint8_t *rbuf, uint32_t rlen) {
+    i2c_xfer_t x = {
+        .addr = addr,
+        .wbuf = wbuf,
+        .wlen = wlen,
+        .rbuf = rbuf,
+        .rlen = rlen,
+    };
+
+    i2c_submit(bus, &x);
+    while (x.status == I2C_PENDING) {
+        i2c_isr(bus);
+    }
+    if (x.status != I2C_OK) {
+        return x.status;
+    }
+    return (int) (rlen ? rlen : wlen);
+}
+
+int i2c_write(i2c_bus_t *bus, uint8_t addr, const uint8_t *buf, uint32_t len) {
+    return i2c_write_read(bus, addr, buf, len, NULL, 0);
+}
+
+int i2c_read(i2c_bus_t *bus, uint8_t addr, uint8_t *buf, uint32_t len) {
+    return i2c_write_read(bus, addr, NULL, 0, buf, len);
+}
+
+void i2c_isr(i2c_bus_t *bus) {
+    i2c_t *i2c = bus->regs;
+    i2c_xfer_t *x = bus->head;
+    uint32_t s = REG_RD(i2c->S);
+
+    if (x == NULL) {
+        // spurious
+        REG_WR(i2c->C, C_I2CEN);
+        REG_WR(i2c->S, S_CLKT | S_ERR | S_DONE);
+        return;
+    }
+
+    if (s & S_ERR) {
+        // No Ack Error
+        REG_WR(i2c->S, S_CLKT | S_ERR | S_DONE);
+        finish(bus, I2C_ERR_NACK);
+        return;
+    } else if (s & S_CLKT) {
+        // Timeout Error
+        REG_WR(i2c->S, S_CLKT | S_ERR | S_DONE);
+        finish(bus, I2C_ERR_CLKT);
+        return;
+    }
+
+    if (bus->reading) {
+        while ((bus->pos < x->rlen) && (REG_RD(i2c->S) & S_RXD)) {
+            x->rbuf[bus->pos++] = REG_RD(i2c->FIFO);
+        }
+    } else {
+        while ((bus->pos < x->wlen) && (REG_RD(i2c->S) & S_TXD)) {
+            REG_WR(i2c->FIFO, x->wbuf[bus->pos++]);
+        }
+        if (bus->pos == x->wlen) {
+            // TXW stays set while the FIFO is not full
+            REG_WR(i2c->C, REG_RD(i2c->C) & ~C_INTT);
+        }
+    }
+
+    if (s & S_DONE) {
+        REG_WR(i2c->S, S_DONE);
+        if (!bus->reading && (x->rlen != 0)) {
+            start_read(bus);
+        } else {
+            finish(bus, I2C_OK);
+        }
+    }
+}
+
+// batched register block read
+
+static void block_done(i2c_xfer_t *xfer) {
+    i2c_batch_t *batch = xfer->arg;
+
+    if (xfer->status != I2C_OK) {
+        batch->errors++;
+    }
+    batch->remaining--;
+    if ((batch->remaining == 0) && batch->callback) {
+        batch->callback(batch);
+    }
+}
+
+void i2c_read_blocks(i2c_bus_t *bus, i2c_batch_t *batch) {
+    if (batch->count == 0) {
+        batch->remaining = 0;
+        batch->errors = 0;
+        if (batch->callback) {
+            batch->callback(batch);
+        }
+        return;
+    }
+    for (uint32_t i = 0; i < batch->count; i++) {
+        i2c_reg_block_t *b = &batch->blocks[i];
+        i2c_xfer_t *x = &b->xfer;
+        x->addr = b->addr;
+        x->wbuf = &b->reg;
+        x->wlen = 1;
+        x->rbuf = b->buf;
+        x->rlen = b->len;
+        x->callback = block_done;
+        x->arg = batch;
+        x->next = (i < batch->count - 1) ? &batch->blocks[i + 1].xfer : NULL;
+    }
+    batch->remaining = batch->count;
+    batch->errors = 0;
+    i2c_submit(bus, &batch->blocks[0].xfer);
+}
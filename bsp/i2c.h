@@ -0,0 +1,165 @@
+#ifndef I2C_H
+#define I2C_H
+
+#include <stdint.h>
+#include "bsp.h"
+
+// I2C registers
+
+#define BSC0 IOBASE(0x20205000)
+#define BSC1 IOBASE(0x20804000)
+#define BSC2 IOBASE(0x20805000)   // HDMI DDC, no GPIO pins
+
+typedef volatile struct _i2c_t {
+    uint32_t C;
+    uint32_t S;
+    uint32_t DLEN;
+    uint32_t A;
+    uint32_t FIFO;
+    uint32_t DIV;
+    uint32_t DEL;
+    uint32_t CLKT;
+} i2c_t;
+
+#define C_I2CEN (1<<15)
+#define C_INTR  (1<<10)
+#define C_INTT  (1<<9)
+#define C_INTD  (1<<8)
+#define C_ST    (1<<7)
+#define C_CLEAR (3<<4)
+#define C_READ  (1)
+
+#define S_CLKT  (1<<9)
+#define S_ERR   (1<<8)
+#define S_RXF   (1<<7)
+#define S_TXE   (1<<6)
+#define S_RXD   (1<<5)
+#define S_TXD   (1<<4)
+#define S_RXR   (1<<3)
+#define S_TXW   (1<<2)
+#define S_DONE  (1<<1)
+#define S_TA    (1)
+
+#define I2C_FIFO_LEN  16
+
+#define I2C_CORE_CLOCK    250000000
+#define I2C_STANDARD      100000    // Standard-mode
+#define I2C_FAST          400000    // Fast-mode
+#define I2C_FAST_PLUS     1000000   // Fast-mode Plus
+
+// Interrupt driven I2C transaction engine
+//
+// A transaction writes wlen bytes and then reads rlen bytes from the
+// slave. Either length can be 0. If wlen is up to I2C_FIFO_LEN the read
+// follows the write with a repeated start, otherwise (or if the write
+// phase is over before the read is programmed) with STOP and START.
+// Transactions are queued and executed one after another by the I2C
+// interrupt; the callback is called in the interrupt handler when a
+// transaction is completed. A NACK or a clock stretch timeout ends the
+// transaction without its read phase.
+
+#define I2C_OK        0
+#define I2C_PENDING   1
+#define I2C_ERR_NACK  (-1)
+#define I2C_ERR_CLKT  (-2)
+
+typedef struct _i2c_xfer_t i2c_xfer_t;
+typedef void (*i2c_callback_t)(i2c_xfer_t *xfer);
+
+struct _i2c_xfer_t {
+    uint8_t addr;
+    const uint8_t *wbuf;
+    uint32_t wlen;
+    uint8_t *rbuf;
+    uint32_t rlen;
+    i2c_callback_t callback;    // may be NULL
+    void *arg;                  // for the callback
+    volatile int status;        // I2C_PENDING until completed
+    i2c_xfer_t *next;           // next transaction of the list
+};
+
+typedef struct _i2c_bus_t {
+    i2c_t *regs;
+    int id;                     // 0: BSC0, 1: BSC1, 2: BSC2
+    i2c_xfer_t *head;           // queued transactions, head is running
+    i2c_xfer_t *tail;
+    int reading;                // running transaction is in the read phase
+    uint32_t pos;               // bytes transferred in the current phase
+} i2c_bus_t;
+
+// initialize BSC0, BSC1 or BSC2 and its pins (BSC0: GPIO0/1, BSC1: GPIO2/3).
+// the bus runs at 100kHz with the default delays and timeout until
+// it is configured by the functions below.
+// returns -1 if id is not valid
+int i2c_init(i2c_bus_t *bus, int id);
+
+// set SCL frequency in Hz and the default edge delays (DIV, DEL).
+// returns the actual frequency
+uint32_t i2c_set_clock_speed(i2c_bus_t *bus, uint32_t speed);
+uint32_t i2c_get_clock_speed(i2c_bus_t *bus);
+
+// set the delays in core clocks from the falling edge (fedl) and the
+// rising edge (redl) of SCL to sampling or changing SDA (DEL).
+// both must be less than DIV / 2
+void i2c_set_delay(i2c_bus_t *bus, uint32_t fedl, uint32_t redl);
+
+// set the clock stretch timeout in SCL clocks, 0 disables it (CLKT)
+void i2c_set_timeout(i2c_bus_t *bus, uint32_t tout);
+
+// these must be called while the bus is idle
+
+// queue a list of transactions linked by xfer->next.
+// the transactions must not be modified until they are completed.
+void i2c_submit(i2c_bus_t *bus, i2c_xfer_t *xfer);
+
+// returns 1 if no transaction is queued
+int i2c_idle(i2c_bus_t *bus);
+
+// Blocking transfers
+//
+// Queue one transaction and poll i2c_isr() until it is completed, for
+// programs which do not take the I2C interrupt. Do not call them from an
+// interrupt handler or while IRQ 53 is enabled for the bus.
+// i2c_write() returns the number of bytes written, i2c_read() and
+// i2c_write_read() the number of bytes read, or I2C_ERR_*.
+// i2c_write() of 0 bytes sends only the address (bus scan).
+int i2c_write(i2c_bus_t *bus, uint8_t addr, const uint8_t *buf, uint32_t len);
+int i2c_read(i2c_bus_t *bus, uint8_t addr, uint8_t *buf, uint32_t len);
+// write wlen bytes and read rlen bytes with a repeated start
+int i2c_write_read(i2c_bus_t *bus, uint8_t addr, const uint8_t *wbuf,
+                   uint32_t wlen, uint8_t *rbuf, uint32_t rlen);
+
+// Batched register block read
+//
+// Reads len bytes starting at register reg of each device in one queued
+// pass. Each block is a write of the register address followed by a
+// read with a repeated start. The batch callback is called in the
+// interrupt handler after the last block is completed.
+
+typedef struct _i2c_batch_t i2c_batch_t;
+typedef void (*i2c_batch_callback_t)(i2c_batch_t *batch);
+
+typedef struct _i2c_reg_block_t {
+    uint8_t addr;
+    uint8_t reg;
+    uint8_t *buf;
+    uint32_t len;
+    i2c_xfer_t xfer;            // used by the engine, xfer.status is the result
+} i2c_reg_block_t;
+
+struct _i2c_batch_t {
+    i2c_reg_block_t *blocks;
+    uint32_t count;
+    i2c_batch_callback_t callback;  // may be NULL
+    void *arg;                      // for the callback
+    volatile uint32_t remaining;    // 0 when all the blocks are completed
+    volatile uint32_t errors;       // number of failed blocks
+};
+
+void i2c_read_blocks(i2c_bus_t *bus, i2c_batch_t *batch);
+
+// call from the IRQ handler when the I2C interrupt (IRQ 53) is pending.
+// the interrupt is shared by all the buses, call it for each of them.
+void i2c_isr(i2c_bus_t *bus);
+
+#endif
@@ -0,0 +1,259 @@
+// Host test of the I2C transaction engine against the model of host.c
+//
+//   make test
+//
+// There are no interrupts on the host: i2c_isr() is called in a loop
+// until the transactions are completed. The slaves are register files
+// of host.c, an EEPROM like one at 0x50 and a sensor at 0x68 on BSC1.
+// host_i2c_fail() injects the NACKs and clock stretch timeouts.
+// test_blocking() covers the blocking transfers used by the i2c example.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bsp.h"
+#include "i2c.h"
+
+#define ISR_MAX  10000      // calls of i2c_isr() for a transaction
+
+static uint8_t eeprom[256];
+static uint8_t sensor[16];
+
+static int wait(i2c_bus_t *bus, volatile int *status) {
+    for (int i = 0; (i < ISR_MAX) && (*status == I2C_PENDING); i++) {
+        i2c_isr(bus);
+    }
+    if (*status == I2C_PENDING) {
+        printf("transaction not completed\n");
+        return 1;
+    }
+    return 0;
+}
+
+static int run(i2c_bus_t *bus, const char *name, uint8_t addr, const uint8_t *wbuf,
+               uint32_t wlen, uint8_t *rbuf, uint32_t rlen, int expected) {
+    i2c_xfer_t x = {
+        .addr = addr, .wbuf = wbuf, .wlen = wlen, .rbuf = rbuf, .rlen = rlen,
+    };
+
+    i2c_submit(bus, &x);
+    if (wait(bus, &x.status) || (x.status != expected)) {
+        printf("%s: status %d, expected %d\n", name, x.status, expected);
+        return 1;
+    }
+    if (!i2c_idle(bus)) {
+        printf("%s: bus not idle\n", name);
+        return 1;
+    }
+    if (REG_RD(bus->regs->S) & S_TA) {
+        printf("%s: transfer still active\n", name);
+        return 1;
+    }
+    return 0;
+}
+
+static int check(const char *name, const uint8_t *buf, const uint8_t *expected, uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) {
+        if (buf[i] != expected[i]) {
+            printf("%s: byte %u is %02x, expected %02x\n", name, i, buf[i], expected[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int test_xfer(i2c_bus_t *bus) {
+    uint8_t wbuf[41];
+    uint8_t rbuf[40];
+    uint8_t reg;
+    int errors = 0;
+
+    // write 40 bytes from 0x10: the FIFO is refilled by i2c_isr().
+    // the data has runs of equal bytes
+    wbuf[0] = 0x10;
+    for (int i = 0; i < 40; i++) {
+        wbuf[i + 1] = 0xa0 + i / 8;
+    }
+    errors += run(bus, "write", 0x50, wbuf, sizeof(wbuf), NULL, 0, I2C_OK);
+    errors += check("write", &eeprom[0x10], &wbuf[1], 40);
+
+    // register address and a read of 40 bytes with a repeated start
+    reg = 0x10;
+    memset(rbuf, 0, sizeof(rbuf));
+    errors += run(bus, "write/read", 0x50, &reg, 1, rbuf, 40, I2C_OK);
+    errors += check("write/read", rbuf, &wbuf[1], 40);
+
+    // write phase longer than the FIFO, the read follows STOP and START
+    memset(rbuf, 0, sizeof(rbuf));
+    errors += run(bus, "long write/read", 0x50, wbuf, 17, rbuf, 8, I2C_OK);
+    errors += check("long write/read", rbuf, &eeprom[0x20], 8);
+
+    // read only, from the register pointer
+    memset(rbuf, 0, sizeof(rbuf));
+    errors += run(bus, "read", 0x50, NULL, 0, rbuf, 4, I2C_OK);
+    errors += check("read", rbuf, &eeprom[0x28], 4);
+
+    // read only from another slave than the last transaction
+    errors += run(bus, "write 0x68", 0x68, &reg, 1, NULL, 0, I2C_OK);
+    memset(rbuf, 0, sizeof(rbuf));
+    errors += run(bus, "read 0x50", 0x50, NULL, 0, rbuf, 4, I2C_OK);
+    errors += check("read 0x50", rbuf, &eeprom[0x2c], 4);
+
+    // no slave at 0x33
+    errors += run(bus, "nack", 0x33, &reg, 1, rbuf, 4, I2C_ERR_NACK);
+    errors += run(bus, "nack write", 0x33, wbuf, 3, NULL, 0, I2C_ERR_NACK);
+
+    printf("xfer: %d errors\n", errors);
+    return errors;
+}
+
+// errors injected by the model: the transaction ends with the error,
+// no read phase is started after it and the next transaction runs
+static int test_errors(i2c_bus_t *bus) {
+    uint8_t wbuf[20];
+    uint8_t rbuf[8];
+    uint8_t reg = 0x10;
+    int errors = 0;
+
+    memset(wbuf, 0x5a, sizeof(wbuf));
+    wbuf[0] = 0x80;
+
+    // NACK of the address while start_write() waits for TA
+    host_i2c_fail(1, S_ERR, 0);
+    errors += run(bus, "address nack", 0x50, &reg, 1, rbuf, 4, I2C_ERR_NACK);
+    host_i2c_fail(1, S_CLKT, 0);
+    errors += run(bus, "address clkt", 0x50, &reg, 1, rbuf, 4, I2C_ERR_CLKT);
+
+    // NACK of the register address, the read phase is programmed
+    host_i2c_fail(1, S_ERR, 1);
+    errors += run(bus, "data nack", 0x50, &reg, 1, rbuf, 4, I2C_ERR_NACK);
+
+    // timeouts in a write refilled by i2c_isr() and in a read
+    host_i2c_fail(1, S_CLKT, 10);
+    errors += run(bus, "write clkt", 0x50, wbuf, sizeof(wbuf), NULL, 0, I2C_ERR_CLKT);
+    host_i2c_fail(1, S_CLKT, 3);
+    errors += run(bus, "read clkt", 0x50, &reg, 1, rbuf, 4, I2C_ERR_CLKT);
+
+    memset(rbuf, 0, sizeof(rbuf));
+    errors += run(bus, "after errors", 0x50, &reg, 1, rbuf, sizeof(rbuf), I2C_OK);
+    errors += check("after errors", rbuf, &eeprom[0x10], sizeof(rbuf));
+
+    printf("errors: %d errors\n", errors);
+    return errors;
+}
+
+static int batch_calls;
+
+static void batch_done(i2c_batch_t *batch) {
+    batch_calls++;
+}
+
+static int test_batch(i2c_bus_t *bus) {
+    uint8_t acc[6];
+    uint8_t id[2];
+    uint8_t none[2];
+    i2c_reg_block_t blocks[] = {
+        { .addr = 0x68, .reg = 3, .buf = acc, .len = sizeof(acc) },
+        { .addr = 0x33, .reg = 0, .buf = none, .len = sizeof(none) },
+        { .addr = 0x50, .reg = 0, .buf = id, .len = sizeof(id) },
+    };
+    i2c_batch_t batch = {
+        .blocks = blocks, .count = 3, .callback = batch_done,
+    };
+    int errors = 0;
+
+    i2c_read_blocks(bus, &batch);
+    for (int i = 0; (i < ISR_MAX) && batch.remaining; i++) {
+        i2c_isr(bus);
+    }
+    if (batch.remaining || (batch_calls != 1) || (batch.errors != 1)) {
+        printf("batch: remaining %u, errors %u, %d callbacks\n",
+               batch.remaining, batch.errors, batch_calls);
+        errors++;
+    }
+    if (blocks[1].xfer.status != I2C_ERR_NACK) {
+        printf("batch: status %d of the missing slave\n", blocks[1].xfer.status);
+        errors++;
+    }
+    errors += check("batch 0x68", acc, &sensor[3], sizeof(acc));
+    errors += check("batch 0x50", id, &eeprom[0], sizeof(id));
+
+    printf("batch: %d errors\n", errors);
+    return errors;
+}
+
+// i2c_write(), i2c_read() and i2c_write_read() poll i2c_isr() themselves
+// and return the number of bytes or the error
+static int expect(const char *name, int ret, int expected) {
+    if (ret != expected) {
+        printf("%s: returned %d, expected %d\n", name, ret, expected);
+        return 1;
+    }
+    return 0;
+}
+
+static int test_blocking(i2c_bus_t *bus) {
+    const uint8_t wbuf[] = { 5, 0x11, 0x22 };
+    uint8_t rbuf[4];
+    uint8_t reg = 5;
+    int errors = 0;
+
+    errors += expect("write", i2c_write(bus, 0x68, wbuf, sizeof(wbuf)), 3);
+    errors += check("write", &sensor[5], &wbuf[1], 2);
+
+    memset(rbuf, 0, sizeof(rbuf));
+    errors += expect("write_read", i2c_write_read(bus, 0x68, &reg, 1, rbuf, 2), 2);
+    errors += check("write_read", rbuf, &wbuf[1], 2);
+
+    // read continues from the register pointer, after register 6
+    memset(rbuf, 0, sizeof(rbuf));
+    errors += expect("read", i2c_read(bus, 0x68, rbuf, 3), 3);
+    errors += check("read", rbuf, &sensor[7], 3);
+
+    // the probe of a bus scan: address only
+    errors += expect("probe", i2c_write(bus, 0x68, NULL, 0), 0);
+    errors += expect("probe nack", i2c_write(bus, 0x33, NULL, 0), I2C_ERR_NACK);
+    errors += expect("read nack", i2c_read(bus, 0x33, rbuf, 1), I2C_ERR_NACK);
+    errors += expect("write_read nack", i2c_write_read(bus, 0x33, &reg, 1, rbuf, 1),
+                     I2C_ERR_NACK);
+
+    host_i2c_fail(1, S_CLKT, 2);
+    errors += expect("read clkt", i2c_read(bus, 0x68, rbuf, 4), I2C_ERR_CLKT);
+
+    if (!i2c_idle(bus) || (REG_RD(bus->regs->S) & S_TA)) {
+        printf("blocking: bus not idle\n");
+        errors++;
+    }
+
+    printf("blocking: %d errors\n", errors);
+    return errors;
+}
+
+int main(int argc, char **argv) {
+    i2c_bus_t bus;
+
+    for (int i = 0; i < sizeof(eeprom); i++) {
+        eeprom[i] = 255 - i;
+    }
+    for (int i = 0; i < sizeof(sensor); i++) {
+        sensor[i] = 0x40 + i;
+    }
+    host_i2c_attach(1, 0x50, eeprom, sizeof(eeprom));
+    host_i2c_attach(1, 0x68, sensor, sizeof(sensor));
+
+    int errors = 0;
+    if (i2c_init(&bus, 1) < 0) {
+        printf("i2c_init failed\n");
+        errors++;
+    }
+    if (i2c_set_clock_speed(&bus, I2C_FAST) > I2C_FAST) {
+        printf("SCL faster than %u\n", I2C_FAST);
+        errors++;
+    }
+    errors += test_xfer(&bus) + test_errors(&bus) + test_batch(&bus);
+    errors += test_blocking(&bus);
+    printf("%s\n", errors ? "FAIL" : "OK");
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
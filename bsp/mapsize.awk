@@ -0,0 +1,142 @@
+# Per-symbol size report from a GNU ld map file (-Map=kernel.elf.map)
+#
+#   awk -f mapsize.awk kernel.elf.map              sizes of all the symbols
+#   awk -v mode=hot -f mapsize.awk kernel.elf.map  functions only, with the
+#                                                  hot/cold placement
+#
+# The size of a symbol is the distance to the next symbol of the same
+# input section. Static functions and variables are not in the map; with
+# -ffunction-sections/-fdata-sections they are named after their section
+# (.text.<name>), otherwise the rest of the section is shown as [section].
+#
+# The place column is hot, cold or startup for the functions that the
+# compiler put in .text.hot, .text.unlikely or .text.startup (hot/cold
+# attributes, or the profile with -fprofile-use).
+
+function hex(s,    i, c, v) {
+    v = 0
+    s = tolower(s)
+    sub(/^0x/, "", s)
+    for (i = 1; i <= length(s); i++) {
+        c = index("0123456789abcdef", substr(s, i, 1)) - 1
+        v = v * 16 + c
+    }
+    return v
+}
+
+function section_name(sec) {
+    if (sec ~ /^\.(text|rodata|data|bss)\.(hot|unlikely|startup)\./) {
+        sub(/^\.[a-z]+\.[a-z]+\./, "", sec)
+        return sec
+    }
+    if (sec ~ /^\.(text|data|bss)\./ && sec !~ /^\.(text|data|bss)\.(hot|unlikely|startup)$/) {
+        sub(/^\.[a-z]+\./, "", sec)
+        return sec
+    }
+    if (sec ~ /^\.rodata\./ && sec !~ /^\.rodata\.(str|cst)/) {
+        sub(/^\.rodata\./, "", sec)
+        return sec
+    }
+    return "[" sec "]"
+}
+
+function place(sec) {
+    if (sec ~ /^\.text\.hot/) return "hot"
+    if (sec ~ /^\.text\.unlikely/) return "cold"
+    if (sec ~ /^\.text\.startup/ || sec == ".startup") return "startup"
+    return "-"
+}
+
+function emit(size, name, obj) {
+    if (size <= 0) {
+        return
+    }
+    total[outsec] += size
+    objsize[obj] += size
+    if ((mode == "hot") && (outsec != ".text")) {
+        return
+    }
+    if ((mode == "hot") && (place(insec) == "-")) {
+        rest += size
+        return
+    }
+    printf "%8d  %-8s %-8s %-40s %s\n", size, outsec, place(insec), name, obj | sorter
+}
+
+# split the pending input section among its symbols
+function flush(    i, first, end) {
+    if (insec == "") {
+        return
+    }
+    end = inaddr + insize
+    first = (nsym > 0) ? symaddr[1] : end
+    emit(first - inaddr, section_name(insec), inobj)
+    for (i = 1; i <= nsym; i++) {
+        emit(((i < nsym) ? symaddr[i + 1] : end) - symaddr[i], symname[i], inobj)
+    }
+    insec = ""
+    nsym = 0
+}
+
+function start(sec, addr, size, obj) {
+    flush()
+    insec = sec
+    inaddr = hex(addr)
+    insize = hex(size)
+    inobj = obj
+}
+
+BEGIN {
+    sorter = "sort -k1,1nr"
+    printf "%8s  %-8s %-8s %-40s %s\n", "size", "section", "place", "symbol", "object"
+}
+
+/^Linker script and memory map/ { inmap = 1; next }
+/^Cross Reference Table/ || /^OUTPUT\(/ { flush(); inmap = 0; next }
+!inmap { next }
+
+# output section
+/^\.[^ ]/ { flush(); outsec = $1; next }
+
+# input section, the name may be on a line of its own
+/^ [.A-Za-z][^ ]*/ && !/^ \*/ {
+    if (NF >= 4 && $2 ~ /^0x/) {
+        start($1, $2, $3, $4)
+    } else if (NF == 1) {
+        wrapped = $1
+    }
+    next
+}
+wrapped != "" && NF == 3 && $1 ~ /^0x/ {
+    start(wrapped, $1, $2, $3)
+    wrapped = ""
+    next
+}
+
+# symbol of the current input section
+/^ +0x[0-9a-fA-F]+ +[^ =]+$/ && NF == 2 && insec != "" {
+    nsym++
+    symaddr[nsym] = hex($1)
+    symname[nsym] = $2
+    next
+}
+
+END {
+    flush()
+    close(sorter)
+    if (mode == "hot") {
+        if (rest > 0) {
+            printf "%8d  %-8s %-8s %s\n", rest, ".text", "-", "(not placed as hot or cold)"
+        }
+        exit
+    }
+    printf "\n%8s  %s\n", "size", "section"
+    for (s in total) {
+        printf "%8d  %s\n", total[s], s
+    }
+    printf "\n%8s  %s\n", "size", "object"
+    for (o in objsize) {
+        printf "%8d  %s\n", objsize[o], o | sorter
+    }
+    close(sorter)
+}
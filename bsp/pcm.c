@@ -0,0 +1,346 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "bsp.h"
+#include "atomic.h"
+#include "dma.h"
+#include "pcm.h"
+
+static uint32_t clk_freq;
+static uint32_t clk_div;        // DIVI << 12 | DIVF
+static uint32_t frame_len;
+static uint32_t frame_words = 1;
+static uint32_t rx_dreq;
+static uint32_t tx_dreq;
+
+static uint32_t src_freq(uint32_t src) {
+    switch (src) {
+    case CM_PCMCTL_SRC_PLLD:
+        return CM_PLLD_FREQ;
+    case CM_PCMCTL_SRC_PLLC:
+        return CM_PLLC_FREQ;
+    default:
+        return CM_OSC_FREQ;
+    }
+}
+
+static void start_clock(uint32_t src, uint32_t divi, uint32_t divf, uint32_t mash) {
+    CM_PCMCTL = CM_PASSWD | (CM_PCMCTL & (~CM_PCMCTL_ENAB)); // disable
+    do {} while(CM_PCMCTL & CM_PCMCTL_BUSY);
+    // MASH can be changed only while the clock is stopped
+    CM_PCMCTL = CM_PASSWD | (mash << CM_PCMCTL_MASH_SHFT);
+    CM_PCMCTL |= CM_PASSWD | (src & CM_PCMCTL_SRC_MASK);
+    CM_PCMDIV = CM_PASSWD | (divi << 12) | (divf & 0xfff);
+    CM_PCMCTL |= CM_PASSWD | CM_PCMCTL_ENAB;
+    clk_freq = src_freq(src);
+    clk_div = (divi << 12) | (divf & 0xfff);
+}
+
+void pcm_init(pcm_t *pcm, uint32_t src, uint32_t div) {
+    // set GPIO18, 19 to ALT0
+    GPFSEL1 = (GPFSEL1 & ~((7U << (3*8)) | (7U << (3*9))))
+        | (GPF_ALT_0 << (3*8)) | (GPF_ALT_0 << (3*9));
+    // set GPIO20, 21 to ALT0
+    GPFSEL2 = (GPFSEL2 & ~((7U << (3*0)) | (7U << (3*1))))
+        | (GPF_ALT_0 << (3*0)) | (GPF_ALT_0 << (3*1));
+    start_clock(src, div, 0, 0);
+
+    REG_WR(pcm->CS, CS_EN);
+    rx_dreq = (REG_RD(pcm->DREQ) >> DREQ_RX_SHFT) & 0x7f;
+    tx_dreq = (REG_RD(pcm->DREQ) >> DREQ_TX_SHFT) & 0x7f;
+}
+
+uint32_t pcm_set_format(pcm_t *pcm, uint32_t frame, uint32_t width) {
+    width = (width < 8) ? 8 : ((width > 32) ? 32 : width);
+    frame = (frame < width * 2 + 2) ? width * 2 + 2 : frame;
+    frame = (frame > 1024) ? 1024 : frame & ~1U;
+    frame_len = frame;
+
+    // width = WEX * 16 + WID + 8
+    uint32_t wex = (width - 8) >> 4;
+    uint32_t wid = (width - 8) & 0xf;
+    // I2S: data starts one clock after the edge of FS, FS low is channel 1
+    uint32_t ch = (wex << 31) | CH1EN | 1<<CH1POS_SHFT | wid<<CH1WID_SHFT \
+        | (wex << 15) | CH2EN | (frame/2 + 1)<<CH2POS_SHFT | wid;
+    uint32_t mode = MODE_CLKI | MODE_FSI | (frame - 1)<<MODE_FLEN_SHFT | frame/2;
+    if (width <= 16) {
+        mode |= MODE_FTXP | MODE_FRXP;
+        frame_words = 1;
+    } else {
+        frame_words = 2;
+    }
+    REG_WR(pcm->MODE, mode);
+    REG_WR(pcm->TXC, ch);
+    REG_WR(pcm->RXC, ch);
+    return frame_words;
+}
+
+uint64_t pcm_get_rate_mhz(void) {
+    if ((frame_len == 0) || (clk_div == 0)) {
+        return 0;
+    }
+    return (uint64_t) clk_freq * 4096 * 1000 / ((uint64_t) clk_div * frame_len);
+}
+
+uint32_t pcm_get_rate(void) {
+    return (pcm_get_rate_mhz() + 500) / 1000;
+}
+
+// clock planner
+
+#define PCM_MAX_BCLK  25000000
+
+static const uint32_t plan_src[] = {
+    CM_PCMCTL_SRC_OSC, CM_PCMCTL_SRC_PLLD, CM_PCMCTL_SRC_PLLC,
+};
+
+// bit clocks per frame, the minimum 2 * width + 2 is tried last
+static const uint32_t plan_frame[] = { 64, 48, 40, 50, 0 };
+
+static int64_t abs64(int64_t x) {
+    return (x < 0) ? -x : x;
+}
+
+int pcm_plan_clock(uint32_t rate, uint32_t width, pcm_clock_t *clk) {
+    int found = 0;
+
+    if (rate == 0) {
+        return -1;
+    }
+    width = (width < 8) ? 8 : ((width > 32) ? 32 : width);
+    for (int s = 0; s < sizeof(plan_src) / sizeof(plan_src[0]); s++) {
+        uint64_t freq = src_freq(plan_src[s]);
+        for (int f = 0; f < sizeof(plan_frame) / sizeof(plan_frame[0]); f++) {
+            uint32_t frame = plan_frame[f] ? plan_frame[f] : width * 2 + 2;
+            if ((frame < width * 2 + 2) || ((uint64_t) rate * frame > PCM_MAX_BCLK)) {
+                continue;
+            }
+            uint64_t bclk = (uint64_t) rate * frame;
+            uint64_t div = (freq * 4096 + bclk / 2) / bclk;
+            uint32_t divi = div >> 12;
+            uint32_t divf = div & 0xfff;
+            // MASH 1 needs DIVI of 2 or more
+            if ((divi < 2) || (divi > 4095)) {
+                continue;
+            }
+            uint64_t mhz = freq * 4096 * 1000 / (div * frame);
+            int64_t err = ((int64_t) mhz - (int64_t) rate * 1000) * 1000000 / rate;
+            uint32_t mash = divf ? 1 : 0;
+            int better;
+            if (!found) {
+                better = 1;
+            } else if (abs64(err) + 1000 < abs64(clk->ppb)) {
+                better = 1;
+            } else if (abs64(err) <= abs64(clk->ppb) + 1000) {
+                // a faster source has less jitter with MASH
+                better = (mash < clk->mash)
+                    || (mash && (mash == clk->mash) && (freq > src_freq(clk->src)));
+            } else {
+                better = 0;
+            }
+            if (better) {
+                clk->src = plan_src[s];
+                clk->divi = divi;
+                clk->divf = divf;
+                clk->mash = mash;
+                clk->frame = frame;
+                clk->rate_mhz = mhz;
+                clk->ppb = err;
+                found = 1;
+            }
+        }
+    }
+    return found ? 0 : -1;
+}
+
+void pcm_set_clock(pcm_t *pcm, const pcm_clock_t *clk) {
+    start_clock(clk->src, clk->divi, clk->divf, clk->mash);
+}
+
+int pcm_set_rate(pcm_t *pcm, uint32_t rate, uint32_t width) {
+    pcm_clock_t clk;
+
+    if (pcm_plan_clock(rate, width, &clk) < 0) {
+        return -1;
+    }
+    pcm_set_clock(pcm, &clk);
+    pcm_set_format(pcm, clk.frame, width);
+    return 0;
+}
+
+// CS without the bits which clear or start something when written as 1
+static uint32_t cs_bits(pcm_t *pcm) {
+    return REG_RD(pcm->CS) & ~(CS_RXERR | CS_TXERR | CS_RXCLR | CS_TXCLR | CS_SYNC);
+}
+
+void pcm_set_rx_threshold(pcm_t *pcm, uint32_t thr, uint32_t dreq) {
+    dreq = (dreq > PCM_FIFO_LEN - 2) ? PCM_FIFO_LEN - 2 : dreq;
+    // panic half way between the threshold and full
+    uint32_t panic = dreq + (PCM_FIFO_LEN - dreq) / 2;
+    REG_WR(pcm->CS, (cs_bits(pcm) & ~CS_RXTHR) | ((thr & 3) << CS_RXTHR_SHFT));
+    REG_WR(pcm->DREQ, (REG_RD(pcm->DREQ) & ~((0x7fU << DREQ_RX_PANIC_SHFT) | (0x7fU << DREQ_RX_SHFT)))
+           | (panic << DREQ_RX_PANIC_SHFT) | (dreq << DREQ_RX_SHFT));
+    rx_dreq = dreq;
+}
+
+void pcm_set_tx_threshold(pcm_t *pcm, uint32_t thr, uint32_t dreq) {
+    dreq = (dreq > PCM_FIFO_LEN - 2) ? PCM_FIFO_LEN - 2 : dreq;
+    dreq = (dreq < 2) ? 2 : dreq;
+    uint32_t panic = dreq / 2;
+    REG_WR(pcm->CS, (cs_bits(pcm) & ~CS_TXTHR) | ((thr & 3) << CS_TXTHR_SHFT));
+    REG_WR(pcm->DREQ, (REG_RD(pcm->DREQ) & ~((0x7fU << DREQ_TX_PANIC_SHFT) | (0x7fU << DREQ_TX_SHFT)))
+           | (panic << DREQ_TX_PANIC_SHFT) | (dreq << DREQ_TX_SHFT));
+    tx_dreq = dreq;
+}
+
+void pcm_ring_init(pcm_ring_t *r, int dir, int ch, uint32_t *buf,
+                   uint32_t len, uint32_t nbuf) {
+    uint32_t fifo = PERI_ADDR(&((pcm_t *) PCM)->FIFO);
+
+    nbuf = (nbuf > PCM_MAX_BUFS) ? PCM_MAX_BUFS : nbuf;
+    r->dir = dir;
+    r->ch = ch;
+    r->buf = buf;
+    r->len = len;
+    r->nbuf = nbuf;
+    // the control blocks make a loop of the buffers
+    for (uint32_t i = 0; i < nbuf; i++) {
+        dma_cb_t *cb = &r->cb[i];
+        if (dir == PCM_DIR_TX) {
+            cb->ti = DMA_TI_PERMAP(DREQ_PCM_TX) | DMA_TI_DEST_DREQ
+                | DMA_TI_SRC_INC | DMA_TI_WAIT_RESP;
+            cb->source_ad = BUS_ADDR(&buf[i * len]);
+            cb->dest_ad = fifo;
+        } else {
+            cb->ti = DMA_TI_PERMAP(DREQ_PCM_RX) | DMA_TI_SRC_DREQ
+                | DMA_TI_DEST_INC | DMA_TI_WAIT_RESP;
+            cb->source_ad = fifo;
+            cb->dest_ad = BUS_ADDR(&buf[i * len]);
+        }
+        cb->txfr_len = len * 4;
+        cb->stride = 0;
+        cb->nextconbk = BUS_ADDR(&r->cb[(i + 1 == nbuf) ? 0 : i + 1]);
+        r->stamp[i] = 0;
+    }
+    r->pos = 0;
+    r->done = 0;
+    // all the TX buffers are filled and waiting to be played
+    r->user = (dir == PCM_DIR_TX) ? nbuf : 0;
+    r->overrun = 0;
+    r->lag = 0;
+}
+
+void pcm_start(pcm_t *pcm, pcm_ring_t *tx, pcm_ring_t *rx) {
+    REG_WR(pcm->CS, cs_bits(pcm) & ~(CS_TXON | CS_RXON | CS_DMAEN));
+    // clear the FIFOs and wait for 2 PCM clocks
+    REG_WR(pcm->CS, cs_bits(pcm) | CS_TXCLR | CS_RXCLR);
+    REG_WR(pcm->CS, cs_bits(pcm) | CS_SYNC);
+    do {} while ((REG_RD(pcm->CS) & CS_SYNC) == 0);
+    REG_WR(pcm->CS, cs_bits(pcm) | CS_DMAEN);
+
+    uint32_t on = 0;
+    if (tx) {
+        // the TX FIFO is filled by DMA up to the threshold before TXON
+        tx->lag = -(int32_t) tx_dreq;
+        dma_init(tx->ch);
+        dma_start(tx->ch, &tx->cb[0]);
+        do {} while (REG_RD(pcm->CS) & CS_TXE);
+        on |= CS_TXON;
+    }
+    if (rx) {
+        rx->lag = rx_dreq;
+        dma_init(rx->ch);
+        dma_start(rx->ch, &rx->cb[0]);
+        on |= CS_RXON;
+    }
+    REG_WR(pcm->CS, cs_bits(pcm) | CS_TXERR | CS_RXERR);
+    uint64_t t = systime();
+    // TX and RX start at the same frame
+    REG_WR(pcm->CS, cs_bits(pcm) | on);
+    if (tx) {
+        tx->stamp[0] = t;
+    }
+    if (rx) {
+        rx->stamp[0] = t;
+    }
+}
+
+void pcm_stop(pcm_t *pcm, pcm_ring_t *tx, pcm_ring_t *rx) {
+    REG_WR(pcm->CS, cs_bits(pcm) & ~(CS_TXON | CS_RXON | CS_DMAEN));
+    if (tx) {
+        dma_abort(tx->ch);
+    }
+    if (rx) {
+        dma_abort(rx->ch);
+    }
+}
+
+static int64_t words_to_us(int64_t words) {
+    int64_t mhz = pcm_get_rate_mhz();
+    return (mhz == 0) ? 0 : words * 1000000000 / (mhz * frame_words);
+}
+
+void pcm_poll(pcm_ring_t *r) {
+    dma_t *dma = DMA_CH(r->ch);
+    // the DMA address tells both the buffer and the position in it
+    uint32_t addr = (r->dir == PCM_DIR_TX) ? REG_RD(dma->SOURCE_AD) : REG_RD(dma->DEST_AD);
+    uint64_t now = systime();
+    uint32_t size = r->len * 4;
+    uint32_t off = addr - BUS_ADDR(r->buf);
+    uint32_t idx = off / size;
+
+    if (idx >= r->nbuf) {
+        // at the end of the last buffer
+        idx = 0;
+        off = 0;
+    } else {
+        off = (off % size) / 4;
+    }
+    if (idx == r->pos) {
+        return;
+    }
+    while (r->pos != idx) {
+        uint32_t prev = r->pos;
+        r->pos = (r->pos + 1 == r->nbuf) ? 0 : r->pos + 1;
+        r->stamp[r->pos] = r->stamp[prev] + words_to_us(r->len);
+        r->done++;
+    }
+    r->stamp[idx] = now - words_to_us((int32_t) off + r->lag);
+
+    if (r->dir == PCM_DIR_RX) {
+        // the oldest buffers have been overwritten
+        if (r->done - r->user >= r->nbuf) {
+            uint32_t n = r->done - r->user - r->nbuf + 1;
+            r->overrun += n;
+            r->user += n;
+        }
+    } else {
+        // the buffer being played has not been refilled
+        if ((int32_t) (r->user - r->done) <= 0) {
+            r->overrun += r->done - r->user + 1;
+            r->user = r->done + 1;
+        }
+    }
+}
+
+uint32_t *pcm_get(pcm_ring_t *r) {
+    pcm_poll(r);
+    uint32_t avail = (r->dir == PCM_DIR_TX) ? r->done + r->nbuf : r->done;
+    if (r->user == avail) {
+        return NULL;
+    }
+    return &r->buf[(r->user % r->nbuf) * r->len];
+}
+
+void pcm_release(pcm_ring_t *r) {
+    // TX data must be in memory before DMA reads it
+    dmb();
+    r->user++;
+}
+
+uint32_t pcm_get_frame(pcm_ring_t *r) {
+    return r->user * (r->len / frame_words);
+}
+
+uint64_t pcm_get_stamp(pcm_ring_t *r) {
+    return r->stamp[r->user % r->nbuf];
+}
@@ -0,0 +1,212 @@
+#ifndef PCM_H
+#define PCM_H
+
+#include <stdint.h>
+#include "bsp.h"
+#include "dma.h"
+
+// PCM registers
+#define CM_PCMCTL  IOREG(0x20101098)
+#define CM_PCMDIV  IOREG(0x2010109C)
+
+#define CM_PASSWD           (0x5a000000)
+#define CM_PCMCTL_SRC_MASK  (0xfU)
+#define CM_PCMCTL_SRC_OSC   (1U)
+#define CM_PCMCTL_SRC_PLLA  (4U)
+#define CM_PCMCTL_SRC_PLLC  (5U)
+#define CM_PCMCTL_SRC_PLLD  (6U)
+#define CM_PCMCTL_SRC_HDMI  (7U)
+#define CM_PCMCTL_ENAB  (1U<<4)
+#define CM_PCMCTL_KILL  (1U<<5)
+#define CM_PCMCTL_BUSY  (1U<<7)
+#define CM_PCMCTL_BUSYD (1U<<8)
+#define CM_PCMCTL_MASH_NONE  (1U<<9)
+#define CM_PCMCTL_MASH_2STG  (2U<<9)
+#define CM_PCMCTL_MASH_3STG  (3U<<9)
+
+#define PCM        IOBASE(0x20203000)
+typedef volatile struct _pcm_t {
+    uint32_t CS;
+    uint32_t FIFO;
+    uint32_t MODE;
+    uint32_t RXC;
+    uint32_t TXC;
+    uint32_t DREQ;
+    uint32_t INTEN;
+    uint32_t INTSTC;
+    uint32_t GRAY;
+} pcm_t;
+
+#define CS_STBY   (1<<25)
+#define CS_SYNC   (1<<24)
+#define CS_RXSEX  (1<<23)
+#define CS_RXF    (1<<22)
+#define CS_TXE    (1<<21)
+#define CS_RXD    (1<<20)
+#define CS_TXD    (1<<19)
+#define CS_RXR    (1<<18)
+#define CS_TXW    (1<<17)
+#define CS_RXERR  (1<<16)
+#define CS_TXERR  (1<<15)
+#define CS_RXSYNC (1<<14)
+#define CS_TXSYNC (1<<13)
+#define CS_DMAEN  (1<<9)
+#define CS_RXTHR  (3<<7)
+#define CS_TXTHR  (3<<5)
+#define CS_RXCLR  (1<<4)
+#define CS_TXCLR  (1<<3)
+#define CS_TXON   (1<<2)
+#define CS_RXON   (1<<1)
+#define CS_EN     (1)
+
+#define CS_RXTHR_SHFT 7
+#define CS_TXTHR_SHFT 5
+
+#define MODE_CLK_DIS (1<<28)
+#define MODE_PDMN  (1<<27)
+#define MODE_PDME  (1<<26)
+#define MODE_FRXP  (1<<25)
+#define MODE_FTXP  (1<<24)
+#define MODE_CLKM  (1<<23)
+#define MODE_CLKI  (1<<22)
+#define MODE_FSM   (1<<21)
+#define MODE_FSI   (1<<20)
+#define MODE_FLEN  (0x1ff<<10)
+#define MODE_FSLEN (0x1ff)
+
+#define MODE_FLEN_SHFT 10
+
+#define CH1WEX     (1<<31)
+#define CH1EN      (1<<30)
+#define CH1POS     (0x1ff<<20)
+#define CH1WID     (0xf<<16)
+#define CH2WEX     (1<<15)
+#define CH2EN      (1<<14)
+#define CH2POS     (0x1ff<<4)
+#define CH2WID     (0xf)
+
+#define CH1POS_SHFT 20
+#define CH1WID_SHFT 16
+#define CH2POS_SHFT 4
+
+#define DREQ_TX_PANIC_SHFT 24
+#define DREQ_RX_PANIC_SHFT 16
+#define DREQ_TX_SHFT       8
+#define DREQ_RX_SHFT       0
+
+#define CM_OSC_FREQ   19200000
+#define CM_PLLD_FREQ  500000000
+#define CM_PLLC_FREQ  1000000000  // follows the core clock setting
+
+#define CM_PCMCTL_MASH_SHFT 9
+#define CM_DIVF_BITS        12
+
+#define PCM_FIFO_LEN  64
+
+// Full-duplex PCM/I2S engine
+//
+// Transmit and receive run from the same bit clock and frame sync and
+// are started by one write of CS, so frame n of the TX stream and frame
+// n of the RX stream always take the same frame period. The latency of
+// a loopback (DOUT to DIN) is a fixed number of frames.
+//
+// Each direction is a ring of buffers filled or drained by DMA. A
+// buffer holds len words: one word per frame when both channels are 16
+// bits or less (packed mode, channel 1 in bits 15:0), two words per
+// frame otherwise. When DMA moves to a buffer, pcm_poll() records the
+// system time of the first frame of the buffer, corrected by the
+// position of DMA in it. pcm_poll() must be called at least once per
+// buffer period; pcm_get() calls it.
+
+#define PCM_DIR_TX    0
+#define PCM_DIR_RX    1
+#define PCM_MAX_BUFS  8
+
+typedef struct _pcm_ring_t {
+    dma_cb_t cb[PCM_MAX_BUFS];
+    int dir;
+    int ch;                         // DMA channel
+    uint32_t *buf;                  // nbuf * len words
+    uint32_t len;                   // words per buffer
+    uint32_t nbuf;
+    uint32_t pos;                   // buffer DMA is working on
+    uint32_t done;                  // buffers completed by DMA
+    uint32_t user;                  // buffers taken by pcm_release()
+    uint32_t overrun;               // RX buffers lost, TX buffers replayed
+    int32_t lag;                    // words between DMA and the pins
+    uint64_t stamp[PCM_MAX_BUFS];   // systime of the first frame
+} pcm_ring_t;
+
+// set GPIO18-21 to PCM and start the clock: src / div
+void pcm_init(pcm_t *pcm, uint32_t src, uint32_t div);
+
+// Clock planner
+//
+// The bit clock is src / (divi + divf / 4096). A fractional divisor
+// needs the MASH filter which moves the edges by one src clock, so the
+// average frequency is exact but each period has jitter. The planner
+// tries OSC, PLLD and PLLC with the usual I2S frame lengths and picks
+// the lowest error. Errors within 1ppm are taken as equal, then an
+// integer divisor (no jitter) is preferred, or the fastest source for
+// a fractional divisor.
+
+typedef struct _pcm_clock_t {
+    uint32_t src;               // CM_PCMCTL_SRC_*
+    uint32_t divi;
+    uint32_t divf;              // in 1/4096
+    uint32_t mash;              // MASH stages, 0 for an integer divisor
+    uint32_t frame;             // bit clocks per frame
+    uint64_t rate_mhz;          // actual frame rate in mHz
+    int32_t ppb;                // error in parts per billion
+} pcm_clock_t;
+
+// plan the clock of rate frames per second with two channels of width
+// bits. returns -1 if the rate can not be made
+int pcm_plan_clock(uint32_t rate, uint32_t width, pcm_clock_t *clk);
+
+// start the clock of a plan, the format must be set by pcm_set_format()
+void pcm_set_clock(pcm_t *pcm, const pcm_clock_t *clk);
+
+// plan and set the clock and the format. returns -1 if the rate can not
+// be made
+int pcm_set_rate(pcm_t *pcm, uint32_t rate, uint32_t width);
+
+// I2S frame of frame bit clocks with two channels of width bits (8-32).
+// returns the number of words per frame
+uint32_t pcm_set_format(pcm_t *pcm, uint32_t frame, uint32_t width);
+
+// frames per second (and mHz) of the current clock and format
+uint32_t pcm_get_rate(void);
+uint64_t pcm_get_rate_mhz(void);
+
+// RX: thr is RXTHR (RXR flag), DMA is requested when the RX FIFO holds
+// more than dreq words. a low dreq gives a short and stable capture
+// latency, a high one fewer DMA bursts.
+void pcm_set_rx_threshold(pcm_t *pcm, uint32_t thr, uint32_t dreq);
+// TX: DMA is requested when the TX FIFO holds less than dreq words
+void pcm_set_tx_threshold(pcm_t *pcm, uint32_t thr, uint32_t dreq);
+
+// buf must hold nbuf (up to PCM_MAX_BUFS) * len words. TX buffers must
+// be filled before pcm_start()
+void pcm_ring_init(pcm_ring_t *r, int dir, int ch, uint32_t *buf,
+                   uint32_t len, uint32_t nbuf);
+
+// start the rings and then TX and RX at the same frame.
+// either ring may be NULL
+void pcm_start(pcm_t *pcm, pcm_ring_t *tx, pcm_ring_t *rx);
+void pcm_stop(pcm_t *pcm, pcm_ring_t *tx, pcm_ring_t *rx);
+
+void pcm_poll(pcm_ring_t *r);
+
+// next buffer for the CPU: a captured buffer (RX) or a buffer which
+// has been played and can be refilled (TX). returns NULL if none
+uint32_t *pcm_get(pcm_ring_t *r);
+// give the buffer back to DMA
+void pcm_release(pcm_ring_t *r);
+
+// of the buffer returned by pcm_get(): the index of its first frame in
+// the stream and its system time (TX: the time it was last played)
+uint32_t pcm_get_frame(pcm_ring_t *r);
+uint64_t pcm_get_stamp(pcm_ring_t *r);
+
+#endif
@@ -0,0 +1,121 @@
+// Host test of the PCM driver against the model of host.c
+//
+//   make test
+//
+// The clock planner and the register values of the I2S format, and the
+// FIFOs through the DOUT to DIN loopback of the model. DMA is not
+// simulated, so pcm_start() and the rings are not tested here.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bsp.h"
+#include "pcm.h"
+
+#define WORDS  48
+
+static int test_clock(pcm_t *pcm) {
+    pcm_clock_t clk;
+    int errors = 0;
+
+    // 48kHz: an integer divisor of the 19.2MHz oscillator
+    if ((pcm_set_rate(pcm, 48000, 16) < 0) || (pcm_get_rate() != 48000)) {
+        printf("48000: rate %u\n", pcm_get_rate());
+        errors++;
+    }
+    if ((pcm_plan_clock(48000, 16, &clk) < 0) || clk.mash || clk.ppb) {
+        printf("48000: divf %u, mash %u, %d ppb\n", clk.divf, clk.mash, clk.ppb);
+        errors++;
+    }
+    if ((CM_PCMDIV & 0xffffffU) != ((clk.divi << 12) | clk.divf)) {
+        printf("48000: CM_PCMDIV %08x\n", CM_PCMDIV);
+        errors++;
+    }
+
+    // 44.1kHz needs a fractional divisor, within 1ppm
+    if ((pcm_plan_clock(44100, 16, &clk) < 0) || !clk.mash
+        || (clk.ppb > 1000) || (clk.ppb < -1000)) {
+        printf("44100: mash %u, %d ppb\n", clk.mash, clk.ppb);
+        errors++;
+    }
+
+    // 16 bits, 64 bit clocks: packed channels, channel 2 from clock 33
+    if (pcm_set_format(pcm, 64, 16) != 1) {
+        printf("format: not packed\n");
+        errors++;
+    }
+    uint32_t mode = REG_RD(pcm->MODE);
+    uint32_t txc = REG_RD(pcm->TXC);
+    if ((((mode & MODE_FLEN) >> MODE_FLEN_SHFT) != 63) || ((mode & MODE_FSLEN) != 32)
+        || !(mode & MODE_FTXP) || (txc != REG_RD(pcm->RXC))
+        || (((txc & CH2POS) >> CH2POS_SHFT) != 33) || ((txc & CH2WID) != 8)) {
+        printf("format: MODE %08x TXC %08x\n", mode, txc);
+        errors++;
+    }
+
+    printf("clock: %d errors\n", errors);
+    return errors;
+}
+
+static int test_fifo(pcm_t *pcm) {
+    int errors = 0;
+    uint32_t n = 0;
+
+    REG_WR(pcm->CS, CS_EN | CS_TXCLR | CS_RXCLR);
+    // the same word twice must be 2 words in the FIFO
+    for (uint32_t i = 0; i < WORDS; i++) {
+        REG_WR(pcm->FIFO, 0x10001 * (i / 2));
+    }
+    REG_WR(pcm->CS, CS_EN | CS_TXON | CS_RXON);
+    while (!(REG_RD(pcm->CS) & CS_TXE)) {
+    }
+    REG_WR(pcm->CS, CS_EN);
+    while ((REG_RD(pcm->CS) & CS_RXD) && (n < WORDS + 1)) {
+        uint32_t v = REG_RD(pcm->FIFO);
+        if ((n < WORDS) && (v != 0x10001 * (n / 2))) {
+            printf("fifo: word %u is %08x\n", n, v);
+            errors++;
+        }
+        n++;
+    }
+    if (n != WORDS) {
+        printf("fifo: %u words received\n", n);
+        errors++;
+    }
+    if (REG_RD(pcm->CS) & (CS_TXERR | CS_RXERR)) {
+        printf("fifo: CS %08x\n", REG_RD(pcm->CS));
+        errors++;
+    }
+
+    // TX underflow, cleared by writing 1
+    REG_WR(pcm->CS, CS_EN | CS_TXON);
+    if (!(REG_RD(pcm->CS) & CS_TXERR)) {
+        printf("fifo: no TXERR on underflow\n");
+        errors++;
+    }
+    REG_WR(pcm->CS, CS_EN | CS_TXERR);
+    if (REG_RD(pcm->CS) & CS_TXERR) {
+        printf("fifo: TXERR not cleared\n");
+        errors++;
+    }
+
+    // SYNC reads back the written value
+    REG_WR(pcm->CS, CS_EN | CS_SYNC);
+    if (!(REG_RD(pcm->CS) & CS_SYNC)) {
+        printf("fifo: no SYNC\n");
+        errors++;
+    }
+
+    printf("fifo: %d errors\n", errors);
+    return errors;
+}
+
+int main(int argc, char **argv) {
+    pcm_t *pcm = (pcm_t *) PCM;
+
+    pcm_init(pcm, CM_PCMCTL_SRC_OSC, 10);
+    int errors = test_clock(pcm) + test_fifo(pcm);
+    printf("%s\n", errors ? "FAIL" : "OK");
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
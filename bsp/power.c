@@ -0,0 +1,17 @@
+#include <stdint.h>
+#ifdef HOST
+#include <stdlib.h>
+#endif
+#include "bsp.h"
+
+void power_reset(void) {
+#ifdef HOST
+    exit(0);
+#else
+    // full reset after 10 watchdog ticks (about 150us)
+    PM_WDOG = PM_PASSWORD | 10;
+    PM_RSTC = PM_PASSWORD | (PM_RSTC & PM_RSTC_WRCFG_CLR) | PM_RSTC_WRCFG_FULL;
+    for (;;) {
+    }
+#endif
+}
@@ -0,0 +1,18 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include <stdint.h>
+
+// Power management watchdog
+#define PM_RSTC IOREG(0x2010001C)
+#define PM_WDOG IOREG(0x20100024)
+
+#define PM_PASSWORD          0x5a000000
+#define PM_RSTC_WRCFG_CLR    0xffffffcf
+#define PM_RSTC_WRCFG_FULL   0x00000020
+
+// reset the board with the watchdog. QEMU with -no-reboot exits instead,
+// which ends a headless run. the host build calls exit(0).
+void power_reset(void);
+
+#endif
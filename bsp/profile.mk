@@ -0,0 +1,81 @@
+# Build profiles, include from the Makefile of an example after all:
+#
+#   include ../bsp/profile.mk
+#
+# and add $(POPT) to CFLAGS. Link with $(CC) $(CFLAGS) so that the
+# profile and LTO also apply to the link.
+#
+#   make                  release: -O2 with LTO, unused functions and data
+#                         removed
+#   make LTO=0            release without LTO
+#   make PROFILE=size     -Os, unused functions and data removed
+#   make PROFILE=debug    -Og with debug info (DEBUG=1 is the same)
+#   make LTO=1            link time optimization on top of any profile
+#   make VFP=1            hard float with the VFP unit, on top of the profile
+#   make size             per-symbol sizes from kernel.elf.map
+#   make hot              functions placed as hot/cold by the compiler
+#
+# objects are not rebuilt when the profile is changed, make clean first.
+
+ifeq ($(DEBUG), 1)
+PROFILE = debug
+endif
+PROFILE ?= release
+
+PROFILE_DIR := $(dir $(lastword $(MAKEFILE_LIST)))
+
+ifeq ($(PROFILE), release)
+POPT = -O2 -ffunction-sections -fdata-sections
+LDFLAGS += -Wl,--gc-sections
+# the host builds (HOST=1, make test) are not meant to be optimized
+ifneq ($(HOST), 1)
+LTO ?= 1
+endif
+else ifeq ($(PROFILE), size)
+POPT = -Os -ffunction-sections -fdata-sections
+LDFLAGS += -Wl,--gc-sections
+else ifeq ($(PROFILE), debug)
+POPT = -Og -gdwarf-2
+else
+$(error PROFILE must be release, size or debug)
+endif
+
+# VFP=1 replaces -msoft-float of CFLAGS_ARM1176JZF-S. the bsp startup
+# enables VFP, and libbsp_vfp.a and libgcc are taken with the same float
+# ABI (bsp.mk). nothing in the bsp saves the VFP registers: an example
+# sets VFP_CONTEXT = 1 when its interrupt (and task switch) code does
+# (vfp-bench), the others are refused
+ifeq ($(VFP), 1)
+ifneq ($(VFP_CONTEXT), 1)
+$(error VFP=1: this example does not save the VFP context in its handlers)
+endif
+CFLAGS_ARM1176JZF-S := $(filter-out -msoft-float,$(CFLAGS_ARM1176JZF-S)) \
+	-mfpu=vfp -mfloat-abi=hard -DUSE_VFP
+endif
+
+# with LTO a function called only from inline asm (bl _start in
+# Init_Machine) must be __attribute__((used)); calls from .S files are
+# seen by the linker. archives need the plugin of gcc-ar. the map has
+# the LTO partitions instead of the objects, make size and make hot
+# attribute the symbols per object with LTO=0
+ifeq ($(LTO), 1)
+POPT += -flto
+AR = $(CROSS_COMPILE)gcc-ar
+endif
+
+# do not turn clear/copy loops into memset/memcpy calls: the bss clear
+# runs before anything is set up, and string.c implements them with loops
+POPT += -fno-tree-loop-distribute-patterns
+
+.PHONY: size hot
+
+size: kernel.elf
+	awk -f $(PROFILE_DIR)mapsize.awk kernel.elf.map > kernel.elf.size
+	$(ECHO) "$(PROFILE) profile, report in kernel.elf.size"
+	@head -n 21 kernel.elf.size
+
+hot: kernel.elf
+	@awk -v mode=hot -f $(PROFILE_DIR)mapsize.awk kernel.elf.map
+
+clean ::
+	$(RM) -f kernel.elf.size
@@ -0,0 +1,121 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "bsp.h"
+#include "pwm.h"
+#include "dma.h"
+
+// DMA channel for the PWM FIFO
+#define PWM_DMA  6
+
+static dma_cb_t pwm_cb;
+static uint32_t *ring_buf;
+static uint32_t ring_len;
+static uint32_t ring_wr;
+static uint32_t ctl;
+
+void init_pwm(pwm_t *pwm, uint32_t src, uint32_t div) {
+    // set GPIO18, 19 to ALT5
+    GPFSEL1 = (GPFSEL1 & ~((7U << (3*8)) | (7U << (3*9))))
+        | (GPF_ALT_5 << (3*8)) | (GPF_ALT_5 << (3*9));
+    // set up pwm clock
+    CM_PWMCTL = CM_PASSWD | (CM_PWMCTL & (~CM_PWMCTL_ENAB)); // disable
+    do {} while(CM_PWMCTL & CM_PWMCTL_BUSY);
+    CM_PWMCTL = CM_PASSWD | CM_PWMCTL_MASH_NONE;
+    CM_PWMCTL |= CM_PASSWD | (src & CM_PWMCTL_SRC_MASK);
+    CM_PWMDIV = CM_PASSWD | (div << 12); // clock = src/div
+    CM_PWMCTL |= CM_PASSWD | CM_PWMCTL_ENAB;
+    ctl = 0;
+    pwm->CTL = 0;
+}
+
+uint32_t pwm_set_sample_rate(pwm_t *pwm, uint32_t rate, uint32_t range) {
+    uint32_t clk = rate * range;
+    uint32_t src;
+    uint32_t freq;
+
+    // oscillator if it is fast enough, otherwise PLLD
+    if (clk <= CM_OSC_FREQ / 2) {
+        src = CM_PWMCTL_SRC_OSC;
+        freq = CM_OSC_FREQ;
+    } else {
+        src = CM_PWMCTL_SRC_PLLD;
+        freq = CM_PLLD_FREQ;
+    }
+    uint32_t div = (freq + clk / 2) / clk;
+    div = (div < 2) ? 2 : div;
+    div = (div > 4095) ? 4095 : div;
+    init_pwm(pwm, src, div);
+    return freq / div / range;
+}
+
+void pwm_config(pwm_t *pwm, int ch, uint32_t range, int use_fifo) {
+    uint32_t bits = CTL_MSEN1 | CTL_PWEN1 | (use_fifo ? CTL_USEF1 : 0);
+
+    if (ch == PWM_CH1) {
+        pwm->RNG1 = range;
+        ctl = (ctl & ~(CTL_MSEN1 | CTL_USEF1 | CTL_PWEN1)) | bits;
+    } else {
+        pwm->RNG2 = range;
+        ctl = (ctl & ~(CTL_MSEN2 | CTL_USEF2 | CTL_PWEN2)) | (bits << 8);
+    }
+    pwm->CTL = ctl;
+}
+
+void pwm_set_duty(pwm_t *pwm, int ch, uint32_t duty) {
+    if (ch == PWM_CH1) {
+        pwm->DAT1 = duty;
+    } else {
+        pwm->DAT2 = duty;
+    }
+}
+
+void pwm_start(pwm_t *pwm, uint32_t *ring, uint32_t len) {
+    ring_buf = ring;
+    ring_len = len;
+    // the whole ring is waiting to be played
+    ring_wr = len - 1;
+
+    // the control block points to itself: the ring is read forever
+    pwm_cb.ti = DMA_TI_PERMAP(DREQ_PWM) | DMA_TI_DEST_DREQ
+        | DMA_TI_SRC_INC | DMA_TI_WAIT_RESP;
+    pwm_cb.source_ad = BUS_ADDR(ring);
+    pwm_cb.dest_ad = PERI_ADDR(&pwm->FIF1);
+    pwm_cb.txfr_len = len * 4;
+    pwm_cb.stride = 0;
+    pwm_cb.nextconbk = BUS_ADDR(&pwm_cb);
+
+    pwm->CTL = ctl | CTL_CLRF1;
+    pwm->STA = STA_BERR | STA_GAPO1 | STA_GAPO2 | STA_RERR1 | STA_WERR1;
+    pwm->DMAC = DMAC_ENAB | (7 << 8) | 7;   // PANIC and DREQ thresholds
+    dma_init(PWM_DMA);
+    dma_start(PWM_DMA, &pwm_cb);
+}
+
+void pwm_stop(pwm_t *pwm) {
+    dma_abort(PWM_DMA);
+    pwm->DMAC = 0;
+    pwm->CTL = ctl | CTL_CLRF1;
+}
+
+// index of the word the DMA reads next
+static uint32_t ring_rd(void) {
+    uint32_t src = DMA_CH(PWM_DMA)->SOURCE_AD;
+    uint32_t rd = (src - BUS_ADDR(ring_buf)) / 4;
+    return (rd >= ring_len) ? 0 : rd;
+}
+
+uint32_t pwm_writable(pwm_t *pwm) {
+    uint32_t rd = ring_rd();
+    // keep one word free to tell full from empty
+    return (rd + ring_len - ring_wr - 1) % ring_len;
+}
+
+uint32_t pwm_write(pwm_t *pwm, const uint32_t *data, uint32_t len) {
+    uint32_t n = pwm_writable(pwm);
+    n = (n > len) ? len : n;
+    for (uint32_t i = 0; i < n; i++) {
+        ring_buf[ring_wr] = data[i];
+        ring_wr = (ring_wr + 1 == ring_len) ? 0 : ring_wr + 1;
+    }
+    return n;
+}
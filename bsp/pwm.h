@@ -0,0 +1,118 @@
+#ifndef PWM_H
+#define PWM_H
+
+#include <stdint.h>
+#include "bsp.h"
+
+// PWM registers
+
+#define CM_PWMCTL  IOREG(0x201010a0)
+#define CM_PWMDIV  IOREG(0x201010a4)
+
+#define CM_PASSWD           (0x5a000000)
+#define CM_PWMCTL_SRC_MASK  (0xfU)
+#define CM_PWMCTL_SRC_OSC   (1U)
+#define CM_PWMCTL_SRC_PLLA  (4U)
+#define CM_PWMCTL_SRC_PLLC  (5U)
+#define CM_PWMCTL_SRC_PLLD  (6U)
+#define CM_PWMCTL_SRC_HDMI  (7U)
+#define CM_PWMCTL_ENAB  (1U<<4)
+#define CM_PWMCTL_KILL  (1U<<5)
+#define CM_PWMCTL_BUSY  (1U<<7)
+#define CM_PWMCTL_BUSYD (1U<<8)
+#define CM_PWMCTL_MASH_NONE  (1U<<9)
+#define CM_PWMCTL_MASH_2STG  (2U<<9)
+#define CM_PWMCTL_MASH_3STG  (3U<<9)
+
+#define PWM        IOBASE(0x2020c000)
+typedef volatile struct _pwm_t {
+    uint32_t CTL;
+    uint32_t STA;
+    uint32_t DMAC;
+    uint32_t undef1;
+    uint32_t RNG1;
+    uint32_t DAT1;
+    uint32_t FIF1;
+    uint32_t undef2;
+    uint32_t RNG2;
+    uint32_t DAT2;
+} pwm_t;
+
+#define CTL_MSEN2 (1<<15)
+#define CTL_USEF2 (1<<13)
+#define CTL_POLA2 (1<<12)
+#define CTL_SBIT2 (1<<11)
+#define CTL_RPTL2 (1<<10)
+#define CTL_MODE2 (1<<9)
+#define CTL_PWEN2 (1<<8)
+#define CTL_MSEN1 (1<<7)
+#define CTL_CLRF1 (1<<6)
+#define CTL_USEF1 (1<<5)
+#define CTL_POLA1 (1<<4)
+#define CTL_SBIT1 (1<<3)
+#define CTL_RPTL1 (1<<2)
+#define CTL_MODE1 (1<<1)
+#define CTL_PWEN1 (1)
+
+#define STA_STA4  (1<<12)
+#define STA_STA3  (1<<11)
+#define STA_STA2  (1<<10)
+#define STA_STA1  (1<<9)
+#define STA_BERR  (1<<8)
+#define STA_GAPO4 (1<<7)
+#define STA_GAPO3 (1<<6)
+#define STA_GAPO2 (1<<5)
+#define STA_GAPO1 (1<<4)
+#define STA_RERR1 (1<<3)
+#define STA_WERR1 (1<<2)
+#define STA_EMPT1 (1<<1)
+#define STA_FULL1 (1)
+
+#define DMAC_ENAB  (1<<31)
+#define DMAC_PANIC (255<<8)
+#define DMAC_DREQ  (255)
+
+#define CM_OSC_FREQ   19200000
+#define CM_PLLD_FREQ  500000000
+
+// PWM engine
+//
+// Both channels can be fed from the FIFO by DMA. When both use the
+// FIFO the words are taken alternately (channel 1, channel 2, ...) and
+// both must have the same range. A channel which does not use the FIFO
+// is a plain PWM output with its own range and DAT register.
+//
+// The sample rate of a FIFO channel is the PWM clock / range. The clock
+// source and divisor are chosen by pwm_set_sample_rate().
+//
+// The DMA reads a ring buffer over and over. The ring can hold a fixed
+// waveform which plays without the CPU, or it can be refilled with
+// pwm_write() for streaming output such as PCM audio.
+
+#define PWM_CH1  0
+#define PWM_CH2  1
+
+// set GPIO18, GPIO19 to PWM and start the clock: src / div
+void init_pwm(pwm_t *pwm, uint32_t src, uint32_t div);
+
+// choose the clock source and the divisor for rate * range and start
+// the clock. returns the actual sample rate
+uint32_t pwm_set_sample_rate(pwm_t *pwm, uint32_t rate, uint32_t range);
+
+// mark:space mode. use_fifo 0: the duty is set by pwm_set_duty()
+void pwm_config(pwm_t *pwm, int ch, uint32_t range, int use_fifo);
+void pwm_set_duty(pwm_t *pwm, int ch, uint32_t duty);
+
+// start DMA from the ring of len words (interleaved if both channels
+// use the FIFO). the ring must be filled before.
+void pwm_start(pwm_t *pwm, uint32_t *ring, uint32_t len);
+void pwm_stop(pwm_t *pwm);
+
+// append samples to the ring without overwriting the words not read
+// yet. returns the number of words written
+uint32_t pwm_write(pwm_t *pwm, const uint32_t *data, uint32_t len);
+
+// number of words which can be written now
+uint32_t pwm_writable(pwm_t *pwm);
+
+#endif
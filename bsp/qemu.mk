@@ -0,0 +1,42 @@
+# QEMU targets, included by bsp.mk
+#
+#   make qemu     boot kernel.img on the raspi0 machine, mini UART on stdio
+#   make bench    boot it headless, save the serial output to kernel.serial
+#                 and the BENCH lines to kernel.bench
+#   make bench BENCH_REF=file
+#                 also compare with the results of an earlier run, fails if
+#                 a result is more than BENCH_TOL percent lower
+#
+# kernel.img is loaded at 0x8000 with -bios as by the firmware. the first
+# serial port of QEMU is the PL011, the mini UART is the second one.
+# with HOST=1, bench runs the native kernel.elf instead.
+
+QEMU = qemu-system-arm
+QEMU_MACHINE = raspi0
+QEMU_FLAGS = -M $(QEMU_MACHINE) -bios kernel.img -display none -no-reboot \
+	-serial null -serial stdio
+BENCH_TIMEOUT = 60
+BENCH_TOL = 10
+
+ifeq ($(HOST), 1)
+BENCH_IMAGE = kernel.elf
+BENCH_RUN = ./kernel.elf
+else
+BENCH_IMAGE = kernel.img
+BENCH_RUN = $(QEMU) $(QEMU_FLAGS) -monitor none
+endif
+
+.PHONY: qemu bench
+
+qemu: kernel.img
+	$(QEMU) $(QEMU_FLAGS) -monitor null
+
+# the kernel ends the run with power_reset() after "BENCH end"; the
+# timeout stops the images that run forever
+bench: $(BENCH_IMAGE)
+	-timeout $(BENCH_TIMEOUT) $(BENCH_RUN) < /dev/null > kernel.serial
+	awk -v ref="$(BENCH_REF)" -v tol=$(BENCH_TOL) -f $(BSP)/bench.awk kernel.serial > kernel.bench; \
+	status=$$?; cat kernel.bench; exit $$status
+
+clean ::
+	$(RM) -f kernel.serial kernel.bench
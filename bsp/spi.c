@@ -0,0 +1,78 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "bsp.h"
+#include "spi.h"
+
+void spi_init(spi_t *spi, int polarity, int phase, uint32_t div) {
+    // set GPIO7-11 to alternate function 0
+    GPFSEL0 = (GPFSEL0 & ~((7U << (3*7)) | (7U << (3*8)) | (7U << (3*9))))
+        | (GPF_ALT_0 << (3*7)) | (GPF_ALT_0 << (3*8)) | (GPF_ALT_0 << (3*9));
+    GPFSEL1 = (GPFSEL1 & ~((7U << (3*0)) | (7U << (3*1))))
+        | (GPF_ALT_0 << (3*0)) | (GPF_ALT_0 << (3*1));
+    uint32_t reg = 0;
+    if (polarity != 0) {
+        reg |= CS_CPOL;
+    }
+    if (phase != 0) {
+        reg |= CS_CPHA;
+    }
+    REG_WR(spi->CS, reg | CLEAR_TX | CLEAR_RX);
+    REG_WR(spi->CLK, div);
+}
+
+void spi_chip_select(spi_t *spi, int cs) {
+    REG_WR(spi->CS, (REG_RD(spi->CS) & ~(CS_CS)) | (cs & 0x3U));
+}
+
+void spi_begin(spi_t *spi) {
+    REG_WR(spi->CS, REG_RD(spi->CS) | CLEAR_TX | CLEAR_RX | CS_TA);
+}
+
+// up to SPI_FIFO_LEN bytes are in flight, so TX FIFO is written in a
+// burst without reading CS for each byte
+void spi_xfer(spi_t *spi, const uint8_t *tx, uint8_t *rx, uint32_t len) {
+    uint32_t txcnt = 0;
+    uint32_t rxcnt = 0;
+
+    while (rxcnt < len) {
+        uint32_t cs = REG_RD(spi->CS);
+        if (cs & CS_TXD) {
+            uint32_t n = SPI_FIFO_LEN - (txcnt - rxcnt);
+            if (n > len - txcnt) {
+                n = len - txcnt;
+            }
+            while (n--) {
+                REG_WR(spi->FIFO, tx ? tx[txcnt] : 0);
+                txcnt++;
+            }
+        }
+        while ((cs & CS_RXD) && (rxcnt < len)) {
+            uint8_t data = REG_RD(spi->FIFO);
+            if (rx) {
+                rx[rxcnt] = data;
+            }
+            rxcnt++;
+            cs = REG_RD(spi->CS);
+        }
+    }
+}
+
+void spi_end(spi_t *spi) {
+    while (!(REG_RD(spi->CS) & CS_DONE));
+    REG_WR(spi->CS, REG_RD(spi->CS) & ~CS_TA);
+}
+
+void spi_transfer(spi_t *spi, int cs, const uint8_t *tx, uint8_t *rx, uint32_t len) {
+    spi_chip_select(spi, cs);
+    spi_begin(spi);
+    spi_xfer(spi, tx, rx, len);
+    spi_end(spi);
+}
+
+void spi_read_reg(spi_t *spi, int cs, uint8_t reg, uint8_t *buf, uint32_t len) {
+    spi_chip_select(spi, cs);
+    spi_begin(spi);
+    spi_xfer(spi, &reg, NULL, 1);
+    spi_xfer(spi, NULL, buf, len);
+    spi_end(spi);
+}
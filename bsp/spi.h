@@ -0,0 +1,70 @@
+#ifndef SPI_H
+#define SPI_H
+
+#include <stdint.h>
+#include "bsp.h"
+
+// SPI registers
+
+#define SPI0 IOBASE(0x20204000)
+
+typedef volatile struct _spi_t {
+    uint32_t CS;
+    uint32_t FIFO;
+    uint32_t CLK;
+    uint32_t DLEN;
+    uint32_t LTOH;
+    uint32_t DC;
+} spi_t;
+
+#define CS_LEN_LONG (1<<25)
+#define CS_DMA_LEN  (1<<24)
+#define CS_CSPOL2   (1<<23)
+#define CS_CSPOL1   (1<<22)
+#define CS_CSPOL0   (1<<21)
+#define CS_RXF      (1<<20)
+#define CS_RXR      (1<<19)
+#define CS_TXD      (1<<18)
+#define CS_RXD      (1<<17)
+#define CS_DONE     (1<<16)
+#define CS_TE_EN    (1<<15)
+#define CS_LMONO    (1<<14)
+#define CS_LEN      (1<<13)
+#define CS_REN      (1<<12)
+#define CS_ADCS     (1<<11)
+#define CS_INTR     (1<<10)
+#define CS_INTD     (1<<9)
+#define CS_DMAEN    (1<<8)
+#define CS_TA       (1<<7)
+#define CS_CSPOL    (1<<6)
+#define CS_CLEAR    (3<<4)
+#define CS_CPOL     (1<<3)
+#define CS_CPHA     (1<<2)
+#define CS_CS       (3<<0)
+
+#define CLEAR_TX    (1<<4)
+#define CLEAR_RX    (2<<4)
+
+#define SPI_FIFO_LEN 16
+
+// set SPI0 pins (GPIO7-11), mode and clock divisor (250MHz / div)
+void spi_init(spi_t *spi, int polarity, int phase, uint32_t div);
+void spi_chip_select(spi_t *spi, int cs);
+
+// spi_begin() asserts the chip select, spi_xfer() can be called any
+// times and spi_end() deasserts the chip select after the last byte.
+// tx or rx of spi_xfer() can be NULL (0x00 is sent, received data is
+// discarded)
+void spi_begin(spi_t *spi);
+void spi_xfer(spi_t *spi, const uint8_t *tx, uint8_t *rx, uint32_t len);
+void spi_end(spi_t *spi);
+
+// full duplex transfer of len bytes in one chip select cycle of cs.
+// tx or rx can be NULL as for spi_xfer()
+void spi_transfer(spi_t *spi, int cs, const uint8_t *tx, uint8_t *rx, uint32_t len);
+
+// send reg and read len bytes in one chip select cycle.
+// the read bit of reg depends on the device (usually 0x80)
+void spi_read_reg(spi_t *spi, int cs, uint8_t reg, uint8_t *buf, uint32_t len);
+
+#endif
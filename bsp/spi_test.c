@@ -0,0 +1,116 @@
+// Host test of the SPI0 driver against the model of host.c
+//
+//   make test
+//
+// Full duplex transfers through the loopback slave, longer than the
+// FIFO and with runs of the same byte (each FIFO write must be seen by
+// the model), and register reads from a slave that answers with its
+// register file after the address byte.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bsp.h"
+#include "spi.h"
+
+#define XFER_LEN  100
+
+static int check(const char *name, const uint8_t *buf, const uint8_t *expected, uint32_t len) {
+    for (uint32_t i = 0; i < len; i++) {
+        if (buf[i] != expected[i]) {
+            printf("%s: byte %u is %02x, expected %02x\n", name, i, buf[i], expected[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int test_loopback(spi_t *spi) {
+    uint8_t tx[XFER_LEN];
+    uint8_t rx[XFER_LEN];
+    uint8_t zero[XFER_LEN] = {0};
+    int errors = 0;
+
+    for (int i = 0; i < XFER_LEN; i++) {
+        // runs of 4 equal bytes
+        tx[i] = (i / 4) * 7;
+    }
+    memset(rx, 0xee, sizeof(rx));
+    spi_transfer(spi, 0, tx, rx, XFER_LEN);
+    errors += check("loopback", rx, tx, XFER_LEN);
+
+    // tx NULL sends 0x00
+    memset(rx, 0xee, sizeof(rx));
+    spi_transfer(spi, 0, NULL, rx, XFER_LEN);
+    errors += check("loopback tx NULL", rx, zero, XFER_LEN);
+
+    // rx NULL, nothing is left in the RX FIFO
+    spi_transfer(spi, 0, tx, NULL, XFER_LEN);
+    if (REG_RD(spi->CS) & (CS_RXD | CS_TA)) {
+        printf("loopback rx NULL: CS %08x\n", REG_RD(spi->CS));
+        errors++;
+    }
+    printf("loopback: %d errors\n", errors);
+    return errors;
+}
+
+// register file of a slave on CE1: the first byte is the address with
+// bit 7 set for a read, the following bytes read or write from there
+static uint8_t dev_regs[64];
+static uint8_t dev_addr;
+static int dev_read;
+static int dev_cs;
+
+static uint8_t dev(int cs, uint8_t mosi, int first) {
+    uint8_t miso = 0xff;
+
+    dev_cs = cs;
+    if (first) {
+        dev_read = mosi & 0x80;
+        dev_addr = mosi & 0x3f;
+    } else if (dev_read) {
+        miso = dev_regs[dev_addr++ & 0x3f];
+    } else {
+        dev_regs[dev_addr++ & 0x3f] = mosi;
+    }
+    return miso;
+}
+
+static int test_read_reg(spi_t *spi) {
+    uint8_t buf[40];
+    uint8_t wr[33];
+    int errors = 0;
+
+    host_spi_attach(dev);
+    for (int i = 0; i < 64; i++) {
+        dev_regs[i] = 0x80 + i;
+    }
+    spi_read_reg(spi, 1, 0x80 | 0x32, buf, 6);
+    errors += check("read_reg", buf, &dev_regs[0x32], 6);
+    if (dev_cs != 1) {
+        printf("read_reg: chip select %d\n", dev_cs);
+        errors++;
+    }
+
+    // write 32 equal bytes from register 8 and read them back
+    wr[0] = 8;
+    memset(&wr[1], 0x5a, 32);
+    spi_transfer(spi, 1, wr, NULL, sizeof(wr));
+    spi_read_reg(spi, 1, 0x80 | 8, buf, 32);
+    errors += check("write/read_reg", buf, &wr[1], 32);
+
+    host_spi_attach(NULL);
+    printf("read_reg: %d errors\n", errors);
+    return errors;
+}
+
+int main(int argc, char **argv) {
+    spi_t *spi = (spi_t *) SPI0;
+
+    spi_init(spi, 0, 0, 250);
+    int errors = test_loopback(spi) + test_read_reg(spi);
+    printf("%s\n", errors ? "FAIL" : "OK");
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,74 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "bsp.h"
+
+#define STR(x)   #x
+#define XSTR(x)  STR(x)
+
+int main(int argc, char **argv);
+
+// placed at 0x8000 by KEEP(*(.startup)) in rpi.ld.
+// written in assembly only: there is no stack until sp is set, and the
+// compiler may use one for the .bss loop in C. used: it is referenced
+// only by -u Init_Machine (bsp.mk) and the linker script.
+__attribute__((used)) __attribute__((naked)) __attribute__((section(".startup"))) \
+void Init_Machine(void) {
+    __asm volatile(
+        // set CPSR (PSR_IRQ_MODE|PSR_FIQ_DIS|PSR_IRQ_DIS)
+        "ldr r0, =0x000000d2 \n"
+        "msr cpsr_c, r0 \n"
+        "ldr sp, =" XSTR(BSP_IRQ_STACK) " \n"
+#ifdef USE_VFP
+        // set CPSR (PSR_UND_MODE|PSR_FIQ_DIS|PSR_IRQ_DIS)
+        "ldr r0, =0x000000db \n"
+        "msr cpsr_c, r0 \n"
+        "ldr sp, =" XSTR(BSP_UND_STACK) " \n"
+#endif
+        // set CPSR (PSR_FIQ_MODE|PSR_FIQ_DIS|PSR_IRQ_DIS)
+        "ldr r0, =0x000000d1 \n"
+        "msr cpsr_c, r0 \n"
+        "ldr sp, =" XSTR(BSP_FIQ_STACK) " \n"
+        // set CPSR (PSR_SVC_MODE|PSR_FIQ_DIS|PSR_IRQ_DIS)
+        "ldr r0, =0x000000d3 \n"
+        "msr cpsr_c, r0 \n"
+        "ldr sp, =" XSTR(BSP_SVC_STACK) " \n"
+#ifdef USE_VFP
+        // enable VFP before any C code may use it, as the
+        // .free_to_enable_fpu1 path of usb_kbd2/SmartStart32.S does. the
+        // ARM1176 runs in the secure state here, so NSACR is left alone.
+        // full access to cp10 and cp11 (CPACR)
+        "mrc p15, 0, r0, c1, c0, 2 \n"
+        "orr r0, r0, #0xf00000 \n"
+        "mcr p15, 0, r0, c1, c0, 2 \n"
+        "mov r0, #0 \n"
+        "mcr p15, 0, r0, c7, c5, 4 \n"     // flush prefetch buffer
+        // FPEXC.EN, and RunFast mode (flush to zero, default NaN)
+        "mov r0, #0x40000000 \n"
+        "vmsr fpexc, r0 \n"
+        "mov r0, #0x03000000 \n"
+        "vmsr fpscr, r0 \n"
+#endif
+        // zero out .bss section
+        "ldr r0, =__bss_start \n"
+        "ldr r1, =__bss_end \n"
+        "mov r2, #0 \n"
+        "1: \n"
+        "cmp r0, r1 \n"
+        "strlo r2, [r0], #4 \n"
+        "blo 1b \n"
+        "bl _start \n"
+        "b . \n"
+        ".ltorg \n");
+}
+
+// called from Init_Machine only, keep it with LTO
+__attribute__((used)) void _start(void) {
+    // when we get here: stack is initialised, bss is clear, data is copied
+
+    // now that we have a basic system up and running we can call main
+    main(0, NULL);
+
+    // we must not return
+    for (;;) {
+    }
+}
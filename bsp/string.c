@@ -0,0 +1,95 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// memcpy/memset/memmove/memcmp for the target, there is no libc.
+// the compiler also calls them for struct copies and large initializers.
+// aligned blocks are moved 32 bytes at a time, which -O2 turns into
+// ldm/stm of 8 registers.
+
+void *memcpy(void *dst, const void *src, size_t n) {
+    uint8_t *d = dst;
+    const uint8_t *s = src;
+
+    if ((((uintptr_t) d ^ (uintptr_t) s) & 3) == 0) {
+        while (((uintptr_t) d & 3) && n) {
+            *d++ = *s++;
+            n--;
+        }
+        uint32_t *dw = (uint32_t *) d;
+        const uint32_t *sw = (const uint32_t *) s;
+        while (n >= 32) {
+            uint32_t a0 = sw[0], a1 = sw[1], a2 = sw[2], a3 = sw[3];
+            uint32_t a4 = sw[4], a5 = sw[5], a6 = sw[6], a7 = sw[7];
+            dw[0] = a0; dw[1] = a1; dw[2] = a2; dw[3] = a3;
+            dw[4] = a4; dw[5] = a5; dw[6] = a6; dw[7] = a7;
+            dw += 8;
+            sw += 8;
+            n -= 32;
+        }
+        while (n >= 4) {
+            *dw++ = *sw++;
+            n -= 4;
+        }
+        d = (uint8_t *) dw;
+        s = (const uint8_t *) sw;
+    }
+    while (n--) {
+        *d++ = *s++;
+    }
+    return dst;
+}
+
+void *memset(void *dst, int c, size_t n) {
+    uint8_t *d = dst;
+    uint32_t w = (uint8_t) c * 0x01010101U;
+
+    while (((uintptr_t) d & 3) && n) {
+        *d++ = c;
+        n--;
+    }
+    uint32_t *dw = (uint32_t *) d;
+    while (n >= 32) {
+        dw[0] = w; dw[1] = w; dw[2] = w; dw[3] = w;
+        dw[4] = w; dw[5] = w; dw[6] = w; dw[7] = w;
+        dw += 8;
+        n -= 32;
+    }
+    while (n >= 4) {
+        *dw++ = w;
+        n -= 4;
+    }
+    d = (uint8_t *) dw;
+    while (n--) {
+        *d++ = c;
+    }
+    return dst;
+}
+
+void *memmove(void *dst, const void *src, size_t n) {
+    uint8_t *d = dst;
+    const uint8_t *s = src;
+
+    if ((d <= s) || (d >= s + n)) {
+        return memcpy(dst, src, n);
+    }
+    // overlapping with dst above src: copy backward
+    d += n;
+    s += n;
+    while (n--) {
+        *--d = *--s;
+    }
+    return dst;
+}
+
+int memcmp(const void *a, const void *b, size_t n) {
+    const uint8_t *p = a;
+    const uint8_t *q = b;
+
+    for (; n; n--, p++, q++) {
+        if (*p != *q) {
+            return *p - *q;
+        }
+    }
+    return 0;
+}
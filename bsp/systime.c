@@ -0,0 +1,30 @@
+#include <stdint.h>
+#include "bsp.h"
+
+uint64_t systime(void) {
+    uint32_t chi;
+    uint32_t clo;
+
+    chi = SYST_CHI;
+    clo = SYST_CLO;
+    if (chi != SYST_CHI) {
+        // CLO has wrapped around between the reads
+        chi = SYST_CHI;
+        clo = SYST_CLO;
+    }
+    return ((uint64_t) chi << 32) | clo;
+}
+
+void delay_us(uint32_t duration) {
+    uint32_t start = SYST_CLO;
+    while ((SYST_CLO - start) < duration);
+}
+
+void delay_ms(uint32_t duration) {
+    // split so that duration * 1000 does not overflow
+    while (duration > 1000000) {
+        delay_us(1000000000);
+        duration -= 1000000;
+    }
+    delay_us(duration * 1000);
+}
@@ -0,0 +1,23 @@
+#ifndef SYSTIME_H
+#define SYSTIME_H
+
+#include <stdint.h>
+
+// System timer counter (1MHz)
+#define SYST_CS  IOREG(0x20003000)
+#define SYST_CLO IOREG(0x20003004)
+#define SYST_CHI IOREG(0x20003008)
+#define SYST_C0  IOREG(0x2000300C)
+#define SYST_C1  IOREG(0x20003010)
+#define SYST_C2  IOREG(0x20003014)
+#define SYST_C3  IOREG(0x20003018)
+
+// 64bit time in us since power on
+uint64_t systime(void);
+
+// busy wait. these only read CLO and compare the elapsed time, so they
+// are cheap and safe across the wrap around of the counter
+void delay_us(uint32_t duration);
+void delay_ms(uint32_t duration);
+
+#endif
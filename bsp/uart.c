@@ -0,0 +1,65 @@
+#include <stdint.h>
+#include "bsp.h"
+
+void uart_init(uint32_t baud) {
+    // set GPIO14, GPIO15 to alternate function 5
+    gpio_set_function(14, GPF_ALT_5);
+    gpio_set_function(15, GPF_ALT_5);
+
+    // UART basic settings
+    AUX_ENABLES |= 1;
+    MU_CNTL = 0;   // mini uart disable
+    MU_IER = 0;    // disable receive/transmit interrupts
+    MU_IIR = 0xC6; // enable FIFO(0xC0), clear FIFO(0x06)
+    MU_MCR = 0;    // set RTS to High
+
+    // data and speed (mini uart is always parity none, 1 start bit 1 stop bit)
+    MU_LCR = 3;    // 8 bits
+    MU_BAUD = (UART_CORE_CLOCK / 8 + baud / 2) / baud - 1; // 270 at 115200bps
+
+    // enable transmit and receive
+    MU_CNTL = 3;
+}
+
+void uart_putc(const unsigned char c) {
+    // TX_EMPTY: the FIFO can accept at least one byte
+    while (!(MU_LSR & MU_LSR_TX_EMPTY));
+    REG_WR(MU_IO, 0xffU & c);
+}
+
+void uart_print(const char *s) {
+    while(*s) {
+        uart_putc(*s++);
+    }
+}
+
+#define TO_HEX(c)  (((c) < 10) ? (c) + 0x30 : (c) - 10 + 0x61)
+
+void uart_put_hex(const unsigned char c) {
+    uart_putc(TO_HEX(c >> 4));
+    uart_putc(TO_HEX(c & 0xfU));
+}
+
+void uart_put_hex32(uint32_t x) {
+    for (int i = 24; i >= 0; i -= 8) {
+        uart_put_hex((x >> i) & 0xffU);
+    }
+}
+
+void uart_put_dec(uint32_t x) {
+    char buf[10];
+    int n = 0;
+
+    do {
+        buf[n++] = 0x30 + x % 10;
+        x /= 10;
+    } while (x);
+    while (n) {
+        uart_putc(buf[--n]);
+    }
+}
+
+unsigned char uart_getc(void) {
+    while (!uart_rx_ready());
+    return REG_RD(MU_IO) & 0xffU;
+}
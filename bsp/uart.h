@@ -0,0 +1,57 @@
+#ifndef UART_H
+#define UART_H
+
+#include <stdint.h>
+
+// Mini UART registers
+#define AUX_IRQ     IOREG(0x20215000)
+#define AUX_ENABLES IOREG(0x20215004)
+
+#define MU_IO   IOREG(0x20215040)
+#define MU_IER  IOREG(0x20215044)
+#define MU_IIR  IOREG(0x20215048)
+#define MU_LCR  IOREG(0x2021504C)
+#define MU_MCR  IOREG(0x20215050)
+#define MU_LSR  IOREG(0x20215054)
+#define MU_MSR  IOREG(0x20215058)
+#define MU_SCRATCH  IOREG(0x2021505C)
+#define MU_CNTL IOREG(0x20215060)
+#define MU_STAT IOREG(0x20215064)
+#define MU_BAUD IOREG(0x20215068)
+
+#define MU_LSR_TX_IDLE  (1U << 6)
+#define MU_LSR_TX_EMPTY (1U << 5)
+#define MU_LSR_RX_RDY   (1U)
+
+// the mini UART is clocked by the core clock
+#define UART_CORE_CLOCK 250000000
+#define UART_BAUD       115200
+
+// set GPIO14 (TXD), GPIO15 (RXD) to alternate function 5 and enable
+// the mini UART with 8 bits, no parity, 1 stop bit
+void uart_init(uint32_t baud);
+
+// blocks while the transmit FIFO is full
+void uart_putc(const unsigned char c);
+#define uart_putchar(c) uart_putc(c)
+
+void uart_print(const char *s);
+
+// print a byte in 2 hex digits
+void uart_put_hex(const unsigned char c);
+
+// print a 32bit value in 8 hex digits
+void uart_put_hex32(uint32_t x);
+
+// print an unsigned value in decimal
+void uart_put_dec(uint32_t x);
+
+// returns 1 if a received byte is in the FIFO
+static inline int uart_rx_ready(void) {
+    return MU_LSR & MU_LSR_RX_RDY;
+}
+
+// blocks until a byte is received
+unsigned char uart_getc(void);
+
+#endif
@@ -0,0 +1,238 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bsp.h"
+#include "i2c.h"
+
+// ldr pc, [pc, #24]
+#define	JMP_PC_24	0xe59ff018
+
+typedef void (*exception_hander_t)(void);
+
+typedef struct __attribute__((aligned(32))) _vector_table_t {
+    const unsigned int vector[8]; // all elements shoud be JMP_PC_24
+    exception_hander_t reset;
+    exception_hander_t undef;
+    exception_hander_t svc;
+    exception_hander_t prefetch_abort;
+    exception_hander_t data_abort;
+    exception_hander_t hypervisor_trap;
+    exception_hander_t irq;
+    exception_hander_t fiq;
+} vector_table_t;
+
+static void __attribute__((interrupt("IRQ"))) irq_handler(void);
+static void __attribute__((naked)) hangup(void);
+
+static vector_table_t exception_vector = { \
+    .vector = { JMP_PC_24, JMP_PC_24, JMP_PC_24, JMP_PC_24, \
+                JMP_PC_24, JMP_PC_24, JMP_PC_24, JMP_PC_24 },
+    .reset = Init_Machine,
+    .undef = hangup,
+    .svc = hangup,
+    .prefetch_abort = hangup,
+    .data_abort = hangup,
+    .hypervisor_trap = hangup,
+    .irq = irq_handler,
+    .fiq = hangup
+};
+
+void set_vbar(vector_table_t *base) {
+    __asm volatile ("mcr p15, 0, %[base], c12, c0, 0"
+                    :: [base] "r" (base));
+}
+
+#define IRQ_BASIC         IOREG(0x2000B200)
+#define IRQ_PEND1         IOREG(0x2000B204)
+#define IRQ_PEND2         IOREG(0x2000B208)
+#define IRQ_ENABLE2       IOREG(0x2000B214)
+#define IRQ_DISABLE_BASIC IOREG(0x2000B224)
+
+// I2C interrupt is IRQ 53 (shared by BSC0, BSC1 and BSC2)
+#define IRQ_I2C  (1 << (53 - 32))
+
+static i2c_bus_t bus0;
+static i2c_bus_t bus1;
+
+static void __attribute__((interrupt("IRQ"))) irq_handler(void) {
+    if (IRQ_PEND2 & IRQ_I2C) {
+        i2c_isr(&bus0);
+        i2c_isr(&bus1);
+    }
+}
+
+static void __attribute__((naked)) hangup(void) {
+  while(1) {
+  }
+}
+
+#define ADDR_START  0x08
+#define ADDR_END    0x77
+#define NUM_ADDR    (ADDR_END - ADDR_START + 1)
+
+static i2c_xfer_t probe[NUM_ADDR];
+static uint8_t probe_buf[NUM_ADDR];
+static volatile uint32_t completed;
+
+static void probe_done(i2c_xfer_t *xfer) {
+    completed++;
+}
+
+// queue one probe transaction for each address, linked in one list
+static void scan_submit(i2c_bus_t *bus) {
+    completed = 0;
+    for (int i = 0; i < NUM_ADDR; i++) {
+        uint8_t addr = ADDR_START + i;
+        i2c_xfer_t *x = &probe[i];
+        x->addr = addr;
+        x->wbuf = &probe_buf[i];
+        x->wlen = 0;
+        x->rbuf = &probe_buf[i];
+        // some EEPROMs do not ack the quick write (same as i2cdetect)
+        if (((0x30 <= addr) && (addr <= 0x37))
+            || ((0x50 <= addr) && (addr <= 0x5f))) {
+            x->rlen = 1;
+        } else {
+            x->rlen = 0;
+        }
+        x->callback = probe_done;
+        x->arg = NULL;
+        x->next = (i < NUM_ADDR - 1) ? &probe[i + 1] : NULL;
+    }
+    i2c_submit(bus, &probe[0]);
+}
+
+static void scan_print(void) {
+  uart_print("     0  1  2  3  4  5  6  7  8  9  a  b  c  d  e  f\r\n");
+  for (uint32_t addr = 0; addr <= 0x7f; addr++) {
+      if ((addr % 16) == 0) {
+          uart_put_hex(addr);
+          uart_putchar(':');
+      }
+
+      if ((addr >= ADDR_START) && (addr <= ADDR_END)) {
+          if (probe[addr - ADDR_START].status == I2C_OK) {
+              uart_putchar(' ');
+              uart_put_hex(addr);
+          } else {
+              uart_print(" --");
+          }
+      } else {
+          // I2C reserved addresses
+          uart_print("   ");
+      }
+
+      if ((addr % 16) == 15) {
+          uart_print("\r\n");
+      }
+  }
+}
+
+// read 2 bytes from register 0 of every device found, in one pass
+#define BLOCK_LEN  2
+
+static i2c_reg_block_t blocks[NUM_ADDR];
+static uint8_t block_buf[NUM_ADDR][BLOCK_LEN];
+static i2c_batch_t batch;
+
+static void regs_submit(i2c_bus_t *bus) {
+    uint32_t n = 0;
+    for (int i = 0; i < NUM_ADDR; i++) {
+        if (probe[i].status == I2C_OK) {
+            blocks[n].addr = probe[i].addr;
+            blocks[n].reg = 0x00;
+            blocks[n].buf = block_buf[n];
+            blocks[n].len = BLOCK_LEN;
+            n++;
+        }
+    }
+    batch.blocks = blocks;
+    batch.count = n;
+    batch.callback = NULL;
+    i2c_read_blocks(bus, &batch);
+}
+
+static void regs_print(void) {
+    for (uint32_t i = 0; i < batch.count; i++) {
+        uart_put_hex(blocks[i].addr);
+        uart_putchar(':');
+        if (blocks[i].xfer.status == I2C_OK) {
+            for (uint32_t j = 0; j < BLOCK_LEN; j++) {
+                uart_putchar(' ');
+                uart_put_hex(block_buf[i][j]);
+            }
+        } else {
+            uart_print(" --");
+        }
+        uart_print("\r\n");
+    }
+}
+
+int main(int argc, char **argv) {
+  const char msg[] = "\r\nScanning I2C bus by interrupt...\r\n";
+
+  // disable IRQ
+  IRQ_DISABLE_BASIC = 1;
+
+  uart_init(UART_BAUD);
+
+  uart_print(msg);
+
+  // BSC0 (ID EEPROM of HATs) at Standard-mode,
+  // BSC1 at Fast-mode with 10ms clock stretch timeout
+  i2c_init(&bus0, 0);
+  i2c_set_clock_speed(&bus0, I2C_STANDARD);
+  i2c_init(&bus1, 1);
+  i2c_set_clock_speed(&bus1, I2C_FAST);
+  i2c_set_timeout(&bus1, I2C_FAST / 100);
+
+  // enable IRQ
+  set_vbar(&exception_vector);
+  IRQ_ENABLE2 = IRQ_I2C;
+  __asm volatile("cpsie i");
+
+  i2c_bus_t *buses[] = { &bus0, &bus1 };
+  int n = 0;
+  while (1) {
+    i2c_bus_t *bus = buses[n];
+    uint32_t start = SYST_CLO;
+    uint32_t loops = 0;
+
+    uart_print("BSC");
+    uart_put_dec(bus->id);
+    uart_print(" ");
+    uart_put_dec(i2c_get_clock_speed(bus));
+    uart_print("Hz\r\n");
+
+    scan_submit(bus);
+    // the CPU is free while the bus is scanned
+    while (!i2c_idle(bus)) {
+      loops++;
+    }
+    uint32_t elapsed = SYST_CLO - start;
+
+    scan_print();
+    uart_put_dec(completed);
+    uart_print(" transactions in ");
+    uart_put_dec(elapsed);
+    uart_print("us, main loop ran ");
+    uart_put_dec(loops);
+    uart_print(" times\r\n");
+
+    start = SYST_CLO;
+    regs_submit(bus);
+    while (batch.remaining != 0);
+    elapsed = SYST_CLO - start;
+
+    regs_print();
+    uart_put_dec(batch.count);
+    uart_print(" register blocks in ");
+    uart_put_dec(elapsed);
+    uart_print("us\r\n");
+
+    n = (n + 1) % 2;
+    delay_ms(5000);
+  }
+
+  return 0;
+}
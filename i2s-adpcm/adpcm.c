@@ -0,0 +1,224 @@
+#include <stdint.h>
+#include "adpcm.h"
+
+static const int16_t step_table[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767,
+};
+
+static const int8_t index_table[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8,
+};
+
+static inline int32_t decode_nibble(adpcm_state_t *c, uint32_t nib) {
+    int32_t step = step_table[c->index];
+    int32_t diff = step >> 3;
+
+    if (nib & 4) {
+        diff += step;
+    }
+    if (nib & 2) {
+        diff += step >> 1;
+    }
+    if (nib & 1) {
+        diff += step >> 2;
+    }
+    int32_t pred = (nib & 8) ? c->pred - diff : c->pred + diff;
+    pred = (pred > 32767) ? 32767 : ((pred < -32768) ? -32768 : pred);
+    int32_t index = c->index + index_table[nib];
+    index = (index < 0) ? 0 : ((index > 88) ? 88 : index);
+    c->pred = pred;
+    c->index = index;
+    return pred;
+}
+
+static uint32_t rd16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t rd32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+int adpcm_open(adpcm_stream_t *s, const uint8_t *data, uint32_t size,
+               uint32_t rate, uint32_t channels, uint32_t block_align) {
+    if ((channels < 1) || (channels > 2)
+        || (block_align < 8 * channels) || (block_align % (4 * channels))) {
+        return -1;
+    }
+    s->data = data;
+    s->size = size;
+    s->rate = rate;
+    s->channels = channels;
+    s->block_align = block_align;
+    s->block_frames = ADPCM_BLOCK_FRAMES(block_align, channels);
+    adpcm_rewind(s);
+    return 0;
+}
+
+int adpcm_open_wav(adpcm_stream_t *s, const uint8_t *wav, uint32_t size) {
+    uint32_t rate = 0;
+    uint32_t channels = 0;
+    uint32_t block_align = 0;
+    int fmt = 0;
+
+    if ((size < 12) || (rd32(wav) != 0x46464952) || (rd32(wav + 8) != 0x45564157)) {
+        return -1;              // not "RIFF" ... "WAVE"
+    }
+    // walk the chunks
+    for (uint32_t pos = 12; pos + 8 <= size;) {
+        uint32_t id = rd32(wav + pos);
+        uint32_t len = rd32(wav + pos + 4);
+        const uint8_t *body = wav + pos + 8;
+        if (len > size - pos - 8) {
+            len = size - pos - 8;
+        }
+        if ((id == 0x20746d66) && (len >= 16)) {            // "fmt "
+            if (rd16(body) != ADPCM_WAVE_FORMAT_IMA) {
+                return -1;
+            }
+            channels = rd16(body + 2);
+            rate = rd32(body + 4);
+            block_align = rd16(body + 12);
+            fmt = 1;
+        } else if ((id == 0x61746164) && fmt) {             // "data"
+            return adpcm_open(s, body, len, rate, channels, block_align);
+        }
+        pos += 8 + len + (len & 1);
+    }
+    return -1;
+}
+
+// load the block at s->offset
+static int start_block(adpcm_stream_t *s) {
+    uint32_t bytes = s->size - s->offset;
+    uint32_t head = 4 * s->channels;
+
+    if ((s->offset >= s->size) || (bytes < head)) {
+        return 0;
+    }
+    if (bytes >= s->block_align) {
+        s->frames = s->block_frames;
+    } else {
+        // the last block may be short, only whole groups are decoded
+        s->frames = (bytes - head) / head * 8 + 1;
+    }
+    s->frame = 0;
+    return 1;
+}
+
+void adpcm_rewind(adpcm_stream_t *s) {
+    s->offset = 0;
+    s->frames = 0;
+    s->frame = 0;
+    start_block(s);
+}
+
+uint32_t adpcm_decode(adpcm_stream_t *s, uint32_t *out, uint32_t n) {
+    uint32_t ch = s->channels;
+    uint32_t i = 0;
+
+    while (i < n) {
+        if (s->frame == s->frames) {
+            s->offset += s->block_align;
+            if (!start_block(s)) {
+                break;
+            }
+        }
+        const uint8_t *blk = s->data + s->offset;
+        if (s->frame == 0) {
+            // the header holds the first sample
+            for (uint32_t c = 0; c < ch; c++) {
+                const uint8_t *h = blk + 4 * c;
+                s->ch[c].pred = (int16_t) rd16(h);
+                s->ch[c].index = (h[2] > 88) ? 88 : h[2];
+            }
+            s->frame = 1;
+        } else {
+            // 8 samples of a channel are in 4 bytes, channels interleaved
+            uint32_t smp = s->frame - 1;
+            const uint8_t *p = blk + 4 * ch + (smp >> 3) * 4 * ch + ((smp & 7) >> 1);
+            uint32_t shift = (smp & 1) * 4;
+            for (uint32_t c = 0; c < ch; c++) {
+                decode_nibble(&s->ch[c], (p[4 * c] >> shift) & 0xf);
+            }
+            s->frame++;
+        }
+        uint32_t l = s->ch[0].pred & 0xffff;
+        uint32_t r = (ch == 2) ? (s->ch[1].pred & 0xffff) : l;
+        out[i++] = (r << 16) | l;
+    }
+    return i;
+}
+
+// encoder
+
+void adpcm_encoder_init(adpcm_encoder_t *e, uint32_t channels, uint32_t block_align) {
+    e->channels = channels;
+    e->block_align = block_align;
+    e->block_frames = ADPCM_BLOCK_FRAMES(block_align, channels);
+    for (int c = 0; c < 2; c++) {
+        e->ch[c].pred = 0;
+        e->ch[c].index = 0;
+    }
+}
+
+static uint32_t encode_nibble(adpcm_state_t *c, int32_t x) {
+    int32_t step = step_table[c->index];
+    int32_t diff = x - c->pred;
+    uint32_t nib = 0;
+
+    if (diff < 0) {
+        nib = 8;
+        diff = -diff;
+    }
+    if (diff >= step) {
+        nib |= 4;
+        diff -= step;
+    }
+    if (diff >= (step >> 1)) {
+        nib |= 2;
+        diff -= step >> 1;
+    }
+    if (diff >= (step >> 2)) {
+        nib |= 1;
+    }
+    // follow the decoder
+    decode_nibble(c, nib);
+    return nib;
+}
+
+static inline int32_t sample(uint32_t frame, uint32_t c) {
+    return c ? (int16_t) (frame >> 16) : (int16_t) (frame & 0xffff);
+}
+
+void adpcm_encode_block(adpcm_encoder_t *e, const uint32_t *in, uint8_t *out) {
+    uint32_t ch = e->channels;
+
+    for (uint32_t c = 0; c < ch; c++) {
+        int32_t x = sample(in[0], c);
+        e->ch[c].pred = x;
+        out[4 * c] = x & 0xff;
+        out[4 * c + 1] = (x >> 8) & 0xff;
+        out[4 * c + 2] = e->ch[c].index;
+        out[4 * c + 3] = 0;
+    }
+    uint8_t *p = out + 4 * ch;
+    for (uint32_t g = 1; g < e->block_frames; g += 8) {
+        for (uint32_t c = 0; c < ch; c++) {
+            for (uint32_t j = 0; j < 8; j += 2) {
+                uint32_t lo = encode_nibble(&e->ch[c], sample(in[g + j], c));
+                uint32_t hi = encode_nibble(&e->ch[c], sample(in[g + j + 1], c));
+                *p++ = lo | (hi << 4);
+            }
+        }
+    }
+}
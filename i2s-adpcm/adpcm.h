@@ -0,0 +1,70 @@
+#ifndef ADPCM_H
+#define ADPCM_H
+
+// IMA ADPCM streaming decoder
+//
+// Decodes the block layout of IMA ADPCM WAV files (format tag 0x11):
+// each block starts with a 4 byte header per channel (predictor and
+// step index), followed by groups of 4 bytes (8 samples) per channel,
+// interleaved for stereo. 16bit samples are stored in 4 bits, so the
+// data is about a quarter of raw PCM.
+//
+// adpcm_decode() writes packed stereo frames (channel 1 in bits 15:0,
+// a mono stream is sent to both channels) directly into the output
+// buffer, a PCM TX buffer for example. Blocks are decoded as far as
+// they are needed, so a call can start and end anywhere in a block.
+// Only integer arithmetic is used.
+
+#include <stdint.h>
+
+#define ADPCM_WAVE_FORMAT_IMA  0x0011
+
+typedef struct _adpcm_state_t {
+    int32_t pred;               // last sample
+    int32_t index;              // of the step table, 0 - 88
+} adpcm_state_t;
+
+typedef struct _adpcm_stream_t {
+    const uint8_t *data;        // first block
+    uint32_t size;              // bytes of all the blocks
+    uint32_t rate;
+    uint32_t channels;          // 1 or 2
+    uint32_t block_align;       // bytes per block
+    uint32_t block_frames;      // frames per full block
+    uint32_t offset;            // of the current block
+    uint32_t frames;            // frames of the current block
+    uint32_t frame;             // next frame of the current block
+    adpcm_state_t ch[2];
+} adpcm_stream_t;
+
+// frames in a block of block_align bytes
+#define ADPCM_BLOCK_FRAMES(block_align, channels) \
+    (((block_align) - 4 * (channels)) * 2 / (channels) + 1)
+
+// raw blocks. returns -1 if the parameters are not valid
+int adpcm_open(adpcm_stream_t *s, const uint8_t *data, uint32_t size,
+               uint32_t rate, uint32_t channels, uint32_t block_align);
+
+// a WAV file image. returns -1 if it is not IMA ADPCM
+int adpcm_open_wav(adpcm_stream_t *s, const uint8_t *wav, uint32_t size);
+
+// decode up to n frames. returns the number of frames, less than n at
+// the end of the stream
+uint32_t adpcm_decode(adpcm_stream_t *s, uint32_t *out, uint32_t n);
+
+// back to the first frame
+void adpcm_rewind(adpcm_stream_t *s);
+
+// Encoder, for making assets. in holds block_frames packed stereo
+// frames (channel 1 only for mono), block_align bytes are written
+typedef struct _adpcm_encoder_t {
+    uint32_t channels;
+    uint32_t block_align;
+    uint32_t block_frames;
+    adpcm_state_t ch[2];
+} adpcm_encoder_t;
+
+void adpcm_encoder_init(adpcm_encoder_t *e, uint32_t channels, uint32_t block_align);
+void adpcm_encode_block(adpcm_encoder_t *e, const uint32_t *in, uint8_t *out);
+
+#endif
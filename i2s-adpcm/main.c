@@ -0,0 +1,137 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bsp.h"
+#include "dma.h"
+#include "pcm.h"
+#include "adpcm.h"
+
+static void enable_icache(void) {
+    uint32_t c1;
+    __asm volatile("mrc p15, 0, %0, c1, c0, 0" : "=r" (c1));
+    c1 |= (1 << 12) | (1 << 11);    // I-cache, branch prediction
+    __asm volatile("mcr p15, 0, %0, c1, c0, 0" :: "r" (c1));
+}
+
+// Asset: 10 seconds of 44.1kHz stereo, made at startup
+
+#define ASSET_RATE    44100
+#define ASSET_SEC     10
+#define BLOCK_ALIGN   1024
+#define BLOCK_FRAMES  ADPCM_BLOCK_FRAMES(BLOCK_ALIGN, 2)
+#define ASSET_BLOCKS  ((ASSET_RATE * ASSET_SEC + BLOCK_FRAMES - 1) / BLOCK_FRAMES)
+
+static uint8_t asset[ASSET_BLOCKS * BLOCK_ALIGN];
+static uint32_t block[BLOCK_FRAMES];
+
+// C major scale, 1/4 second each (Hz)
+static const uint32_t melody[] = { 262, 294, 330, 349, 392, 440, 494, 523 };
+
+static uint32_t make_asset(void) {
+    adpcm_encoder_t enc;
+    uint32_t phase[2] = { 0, 0 };
+    uint32_t t = 0;
+
+    adpcm_encoder_init(&enc, 2, BLOCK_ALIGN);
+    for (uint32_t b = 0; b < ASSET_BLOCKS; b++) {
+        for (uint32_t i = 0; i < BLOCK_FRAMES; i++, t++) {
+            uint32_t f = melody[(t / (ASSET_RATE / 4)) % 8];
+            int32_t v[2];
+            // triangle waves, the melody and a fifth above
+            phase[0] += (uint32_t) (((uint64_t) f << 32) / ASSET_RATE);
+            phase[1] += (uint32_t) (((uint64_t) f * 3 / 2 << 32) / ASSET_RATE);
+            for (int c = 0; c < 2; c++) {
+                int32_t x = (int32_t) (phase[c] >> 15) - 65536;
+                v[c] = (((x < 0) ? -x : x) - 32768) >> 2;
+            }
+            block[i] = ((uint32_t) v[1] << 16) | ((uint32_t) v[0] & 0xffff);
+        }
+        adpcm_encode_block(&enc, block, &asset[b * BLOCK_ALIGN]);
+    }
+    return ASSET_BLOCKS * BLOCK_ALIGN;
+}
+
+// decode the whole asset and print the speed against real time
+void adpcm_benchmark(adpcm_stream_t *s) {
+    uint32_t frames = 0;
+    uint32_t n;
+
+    adpcm_rewind(s);
+    uint64_t start = systime();
+    while ((n = adpcm_decode(s, block, 256)) != 0) {
+        frames += n;
+    }
+    uint32_t us = systime() - start;
+    uint32_t play_us = (uint64_t) frames * 1000000 / s->rate;
+    uart_print("decoded ");
+    uart_put_dec(frames);
+    uart_print(" frames in ");
+    uart_put_dec(us / 1000);
+    uart_print("ms, ");
+    uart_put_dec(play_us / us);
+    uart_print(" times real time, load ");
+    uart_put_dec((uint64_t) us * 1000 / play_us / 10);
+    uart_putc('.');
+    uart_put_dec((uint64_t) us * 1000 / play_us % 10);
+    uart_print("%\r\n");
+    adpcm_rewind(s);
+}
+
+#define NBUF          4
+#define BUF_LEN       256
+#define TX_DMA        4
+
+static uint32_t tx_buf[NBUF * BUF_LEN];
+static pcm_ring_t tx;
+static adpcm_stream_t stream;
+
+// decode the next buffer, the stream loops
+static void fill(uint32_t *buf) {
+    uint32_t n = 0;
+    while (n < BUF_LEN) {
+        uint32_t k = adpcm_decode(&stream, &buf[n], BUF_LEN - n);
+        if (k == 0) {
+            adpcm_rewind(&stream);
+        }
+        n += k;
+    }
+}
+
+int main(int argc, char **argv) {
+  pcm_t* pcm = (pcm_t*) (PCM);
+
+  uart_init(UART_BAUD);
+  enable_icache();
+  uart_print("\r\nI2S ADPCM player. Signal is on GPIO18(CLK)/19(FS)/21(DATA).\r\n");
+
+  uint32_t size = make_asset();
+  adpcm_open(&stream, asset, size, ASSET_RATE, 2, BLOCK_ALIGN);
+  uart_print("asset ");
+  uart_put_dec(size);
+  uart_print(" bytes, raw PCM ");
+  uart_put_dec(ASSET_BLOCKS * BLOCK_FRAMES * 4);
+  uart_print(" bytes\r\n");
+  adpcm_benchmark(&stream);
+
+  pcm_init(pcm, CM_PCMCTL_SRC_OSC, 10);
+  pcm_set_rate(pcm, stream.rate, 16);
+  pcm_set_tx_threshold(pcm, 1, 32);
+  for (int i = 0; i < NBUF; i++) {
+      fill(&tx_buf[i * BUF_LEN]);
+  }
+  pcm_ring_init(&tx, PCM_DIR_TX, TX_DMA, tx_buf, BUF_LEN, NBUF);
+  pcm_start(pcm, &tx, NULL);
+
+  while(1) {
+      uint32_t *b = pcm_get(&tx);
+      if (b) {
+          fill(b);
+          pcm_release(&tx);
+      }
+      if (tx.overrun) {
+          uart_print("underrun\r\n");
+          tx.overrun = 0;
+      }
+  }
+  return 0;
+}
@@ -0,0 +1,161 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bsp.h"
+#include "dsp.h"
+#include "pcm.h"
+
+// Cycle counter of ARM1176 (Performance Monitor Control Register)
+
+static inline void ccnt_start(void) {
+    // enable counters (E), reset count registers (P) and cycle counter (C)
+    __asm volatile("mcr p15, 0, %0, c15, c12, 0" :: "r" (7));
+}
+
+static inline uint32_t ccnt_read(void) {
+    uint32_t c;
+    __asm volatile("mrc p15, 0, %0, c15, c12, 1" : "=r" (c));
+    return c;
+}
+
+static void enable_icache(void) {
+    uint32_t c1;
+    __asm volatile("mrc p15, 0, %0, c1, c0, 0" : "=r" (c1));
+    c1 |= (1 << 12) | (1 << 11);    // I-cache, branch prediction
+    __asm volatile("mcr p15, 0, %0, c1, c0, 0" :: "r" (c1));
+}
+
+// DSP chain
+
+#define SAMPLE_RATE  48000
+#define CPU_CLOCK    700000000
+#define BLOCK_LEN    256
+#define BENCH_LOOPS  16
+
+// 2nd order Butterworth lowpass, fc = 3kHz (Q14)
+#define LPF_B0  491
+#define LPF_B1  982
+#define LPF_B2  491
+#define LPF_A1  (-23826)
+#define LPF_A2  9405
+
+// 16 taps lowpass, fc = 4kHz (Q15)
+static const int16_t fir_taps[] = {
+    -82, -52, 119, 684, 1775, 3253, 4701, 5603,
+    5603, 4701, 3253, 1775, 684, 119, -52, -82,
+};
+
+static dsp_biquad_t lpf;
+static dsp_fir_t fir;
+static uint32_t block[BLOCK_LEN];
+static uint32_t tone[BLOCK_LEN];
+
+// two detuned saw waves: 375Hz on the left, 562.5Hz on the right
+static void fill_saw(uint32_t *buf, uint32_t n, uint32_t *phase) {
+    for (uint32_t i = 0; i < n; i++) {
+        buf[i] = dsp_pack((int16_t) (phase[0] >> 16), (int16_t) (phase[1] >> 16));
+        phase[0] += 0x02000000;
+        phase[1] += 0x03000000;
+    }
+}
+
+// a quiet square wave of 1.5kHz mixed into the saw
+static void fill_square(uint32_t *buf, uint32_t n, uint32_t *count) {
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t v = (*count & 16) ? 0x08000800 : 0xf800f800;
+        buf[i] = v;
+        (*count)++;
+    }
+}
+
+static void process(uint32_t *buf, uint32_t n) {
+    dsp_gain(buf, n, 2048, 2048);
+    dsp_mix(buf, tone, n);
+    dsp_biquad(&lpf, buf, n);
+    dsp_fir(&fir, buf, n);
+    dsp_gain(buf, n, 12288, 12288);
+    dsp_soft_clip(buf, n);
+}
+
+static void print_result(const char *name, uint32_t cycles) {
+    // cycles per frame and the load at 48kHz in 0.1%
+    uint32_t per_frame = cycles / (BENCH_LOOPS * BLOCK_LEN);
+    uint32_t load = (uint64_t) cycles * SAMPLE_RATE * 1000
+        / ((uint64_t) CPU_CLOCK * BENCH_LOOPS * BLOCK_LEN);
+    uart_print(name);
+    uart_putc(' ');
+    uart_put_dec(per_frame);
+    uart_putc(' ');
+    uart_put_dec(load / 10);
+    uart_putc('.');
+    uart_put_dec(load % 10);
+    uart_print("%\r\n");
+}
+
+#define BENCH(name, stmt)                           \
+    do {                                            \
+        ccnt_start();                               \
+        for (int l = 0; l < BENCH_LOOPS; l++) {     \
+            stmt;                                   \
+        }                                           \
+        print_result(name, ccnt_read());            \
+    } while (0)
+
+void dsp_benchmark(void) {
+    uint32_t phase[2] = { 0, 0 };
+    uint32_t count = 0;
+
+    fill_saw(block, BLOCK_LEN, phase);
+    fill_square(tone, BLOCK_LEN, &count);
+    uart_print("\r\nkernel cycles/frame load@48kHz\r\n");
+    BENCH("gain     ", dsp_gain(block, BLOCK_LEN, 4096, 4096));
+    BENCH("mix      ", dsp_mix(block, tone, BLOCK_LEN));
+    BENCH("biquad   ", dsp_biquad(&lpf, block, BLOCK_LEN));
+    BENCH("fir16    ", dsp_fir(&fir, block, BLOCK_LEN));
+    BENCH("soft_clip", dsp_soft_clip(block, BLOCK_LEN));
+    BENCH("chain    ", process(block, BLOCK_LEN));
+}
+
+int main(int argc, char **argv) {
+  pcm_t* pcm = (pcm_t*) PCM;
+
+  uart_init(UART_BAUD);
+  enable_icache();
+  uart_print("\r\nI2S DSP test. Signal is on GPIO18(CLK)/19(FS)/21(DATA).\r\n");
+
+  dsp_biquad_init(&lpf, LPF_B0, LPF_B1, LPF_B2, LPF_A1, LPF_A2);
+  dsp_fir_init(&fir, fir_taps, sizeof(fir_taps) / sizeof(fir_taps[0]));
+  dsp_benchmark();
+
+  // set BCLK to 19.2MHz/10 = 1.92MHz, 40 clocks per frame = 48kHz
+  pcm_init(pcm, CM_PCMCTL_SRC_OSC, 10);
+  pcm_set_format(pcm, 40, 16);
+
+  pcm->CS |= CS_TXCLR;
+  pcm->CS |= CS_SYNC;
+  do {} while ((pcm->CS & CS_SYNC) == 0);
+  pcm_set_tx_threshold(pcm, 3, PCM_FIFO_LEN / 2);
+  for (int i = 0; i < PCM_FIFO_LEN; i++) {
+      pcm->FIFO = 0;
+  }
+  pcm->CS |= CS_TXERR;
+  pcm->CS |= CS_TXON;
+
+  // the FIFO (64 frames) keeps playing while the next block is rendered
+  uint32_t phase[2] = { 0, 0 };
+  uint32_t count = 0;
+  while(1) {
+      fill_saw(block, BLOCK_LEN, phase);
+      fill_square(tone, BLOCK_LEN, &count);
+      process(block, BLOCK_LEN);
+      for (int i = 0; i < BLOCK_LEN; i++) {
+          do {} while ((pcm->CS & CS_TXW) == 0);
+          pcm->FIFO = block[i];
+      }
+      if (pcm->CS & CS_TXERR) {
+          uart_print("underrun\r\n");
+          pcm->CS |= CS_TXERR;
+      }
+  }
+  return 0;
+}
@@ -0,0 +1,97 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bsp.h"
+#include "dma.h"
+#include "pcm.h"
+
+// Loopback latency
+
+#define NBUF      4
+#define BUF_LEN   96            // 2ms at 48kHz
+#define PULSE     0x40004000
+#define TX_DMA    4
+#define RX_DMA    5
+
+static uint32_t tx_buf[NBUF * BUF_LEN];
+static uint32_t rx_buf[NBUF * BUF_LEN];
+static pcm_ring_t tx;
+static pcm_ring_t rx;
+
+int main(int argc, char **argv) {
+  pcm_t* pcm = (pcm_t*) (PCM);
+
+  uart_init(UART_BAUD);
+  uart_print("\r\nI2S full duplex test. Connect GPIO21(DOUT) to GPIO20(DIN).\r\n");
+  delay_ms(1000);
+
+  // set BCLK to 19.2MHz/10 = 1.92MHz, 40 clocks per frame = 48kHz
+  pcm_init(pcm, CM_PCMCTL_SRC_OSC, 10);
+  pcm_set_format(pcm, 40, 16);
+  uint32_t rate = pcm_get_rate();
+  // DMA moves the captured frames as soon as 8 words are in the FIFO
+  pcm_set_rx_threshold(pcm, 1, 8);
+  pcm_set_tx_threshold(pcm, 1, 32);
+
+  pcm_ring_init(&tx, PCM_DIR_TX, TX_DMA, tx_buf, BUF_LEN, NBUF);
+  pcm_ring_init(&rx, PCM_DIR_RX, RX_DMA, rx_buf, BUF_LEN, NBUF);
+  pcm_start(pcm, &tx, &rx);
+  uint64_t start = rx.stamp[0];
+
+  int pending = 0;
+  uint32_t pulse_frame = 0;
+  uint32_t stamp_err = 0;
+  uint64_t next = systime() + 1000000;
+  while(1) {
+      uint32_t *b = pcm_get(&tx);
+      if (b) {
+          for (int i = 0; i < BUF_LEN; i++) {
+              b[i] = 0;
+          }
+          if (!pending && (systime() >= next)) {
+              // one pulse at the first frame of this buffer
+              b[0] = PULSE;
+              pulse_frame = pcm_get_frame(&tx);
+              pending = 1;
+              next += 1000000;
+          }
+          pcm_release(&tx);
+      }
+
+      b = pcm_get(&rx);
+      if (b) {
+          uint32_t frame = pcm_get_frame(&rx);
+          // the stamp against the time given by the frame count
+          uint64_t expect = start + (uint64_t) frame * 1000000 / rate;
+          int32_t err = (int32_t) (pcm_get_stamp(&rx) - expect);
+          err = (err < 0) ? -err : err;
+          stamp_err = ((uint32_t) err > stamp_err) ? (uint32_t) err : stamp_err;
+
+          for (int i = 0; pending && (i < BUF_LEN); i++) {
+              int16_t v = b[i] & 0xffff;
+              if ((frame + i >= pulse_frame) && ((v > 0x2000) || (v < -0x2000))) {
+                  uint32_t latency = frame + i - pulse_frame;
+                  uart_print("latency ");
+                  uart_put_dec(latency);
+                  uart_print(" frames ");
+                  uart_put_dec(latency * 1000000 / rate);
+                  uart_print("us, stamp error ");
+                  uart_put_dec(stamp_err);
+                  uart_print("us, overrun ");
+                  uart_put_dec(rx.overrun);
+                  uart_putc('/');
+                  uart_put_dec(tx.overrun);
+                  uart_print("\r\n");
+                  pending = 0;
+                  stamp_err = 0;
+              }
+          }
+          if (pending && (frame > pulse_frame + rate)) {
+              uart_print("no pulse on DIN\r\n");
+              pending = 0;
+          }
+          pcm_release(&rx);
+      }
+  }
+  return 0;
+}
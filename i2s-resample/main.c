@@ -0,0 +1,165 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bsp.h"
+#include "dma.h"
+#include "pcm.h"
+#include "resample.h"
+
+static void print_mhz(uint64_t mhz) {
+    uart_put_dec(mhz / 1000);
+    uart_putc('.');
+    uint32_t f = mhz % 1000;
+    uart_putc('0' + f / 100);
+    uart_putc('0' + (f / 10) % 10);
+    uart_putc('0' + f % 10);
+}
+
+static const char *src_name(uint32_t src) {
+    switch (src) {
+    case CM_PCMCTL_SRC_PLLD:
+        return "PLLD";
+    case CM_PCMCTL_SRC_PLLC:
+        return "PLLC";
+    default:
+        return "OSC ";
+    }
+}
+
+void print_plans(void) {
+    const uint32_t rates[] = { 8000, 11025, 16000, 22050, 32000, 44100, 48000, 96000 };
+
+    uart_print("\r\nrate   src  divi.divf mash frame actual(Hz) error(ppb)\r\n");
+    for (int i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        pcm_clock_t clk;
+        uart_put_dec(rates[i]);
+        uart_putc(' ');
+        if (pcm_plan_clock(rates[i], 16, &clk) < 0) {
+            uart_print("none\r\n");
+            continue;
+        }
+        uart_print(src_name(clk.src));
+        uart_putc(' ');
+        uart_put_dec(clk.divi);
+        uart_putc('.');
+        uart_put_dec(clk.divf);
+        uart_putc(' ');
+        uart_put_dec(clk.mash);
+        uart_putc(' ');
+        uart_put_dec(clk.frame);
+        uart_putc(' ');
+        print_mhz(clk.rate_mhz);
+        uart_putc(' ');
+        if (clk.ppb < 0) {
+            uart_putc('-');
+        }
+        uart_put_dec((clk.ppb < 0) ? -clk.ppb : clk.ppb);
+        uart_print("\r\n");
+    }
+}
+
+// 44.1kHz content: a 1kHz triangle wave
+
+#define CONTENT_RATE  44100
+#define NBUF          4
+#define BUF_LEN       256
+#define TX_DMA        4
+
+static uint32_t tx_buf[NBUF * BUF_LEN];
+static pcm_ring_t tx;
+static resample_t rs;
+static uint32_t src_buf[BUF_LEN];
+static uint32_t src_len;
+static uint32_t src_pos;
+static uint32_t phase;
+
+static void render_content(uint32_t *buf, uint32_t n) {
+    const uint32_t inc = (uint32_t) ((1000ULL << 32) / CONTENT_RATE);
+    for (uint32_t i = 0; i < n; i++) {
+        int32_t v = (int32_t) (phase >> 15) - 65536;
+        v = ((v < 0) ? -v : v) - 32768;     // triangle of -32768 .. 32767
+        v >>= 2;
+        buf[i] = ((uint32_t) v << 16) | ((uint32_t) v & 0xffff);
+        phase += inc;
+    }
+}
+
+// fill a TX buffer at the output rate from the content
+static void fill(uint32_t *buf, int convert) {
+    if (!convert) {
+        render_content(buf, BUF_LEN);
+        return;
+    }
+    uint32_t n = 0;
+    while (n < BUF_LEN) {
+        if (src_pos == src_len) {
+            render_content(src_buf, BUF_LEN);
+            src_len = BUF_LEN;
+            src_pos = 0;
+        }
+        uint32_t used;
+        n += resample_process(&rs, &src_buf[src_pos], src_len - src_pos,
+                              &buf[n], BUF_LEN - n, &used);
+        src_pos += used;
+    }
+}
+
+// play the content for sec seconds with PCM at rate, and print the
+// frame rate measured by the system timer
+void play(pcm_t *pcm, uint32_t rate, uint32_t sec) {
+    int convert = (rate != CONTENT_RATE);
+
+    pcm_set_rate(pcm, rate, 16);
+    uart_print(convert ? "resampled to " : "native ");
+    print_mhz(pcm_get_rate_mhz());
+    uart_print("Hz\r\n");
+
+    resample_init(&rs, CONTENT_RATE, rate);
+    src_len = 0;
+    src_pos = 0;
+    for (int i = 0; i < NBUF; i++) {
+        fill(&tx_buf[i * BUF_LEN], convert);
+    }
+    pcm_ring_init(&tx, PCM_DIR_TX, TX_DMA, tx_buf, BUF_LEN, NBUF);
+    pcm_start(pcm, &tx, NULL);
+    uint64_t start = tx.stamp[0];
+    uint64_t end = systime() + sec * 1000000ULL;
+
+    while (systime() < end) {
+        uint32_t *b = pcm_get(&tx);
+        if (b) {
+            fill(b, convert);
+            pcm_release(&tx);
+        }
+    }
+    // the buffer returned by pcm_get() was played nbuf buffers ago
+    pcm_get(&tx);
+    uint32_t frames = pcm_get_frame(&tx) - NBUF * BUF_LEN;
+    uint64_t us = pcm_get_stamp(&tx) - start;
+    pcm_stop(pcm, &tx, NULL);
+    uart_print("measured ");
+    print_mhz((uint64_t) frames * 1000000000ULL / us);
+    uart_print("Hz, underrun ");
+    uart_put_dec(tx.overrun);
+    uart_print("\r\n");
+}
+
+int main(int argc, char **argv) {
+  pcm_t* pcm = (pcm_t*) (PCM);
+
+  uart_init(UART_BAUD);
+  uart_print("\r\nI2S clock planner and resampler. Signal is on GPIO18(CLK)/19(FS)/21(DATA).\r\n");
+  delay_ms(1000);
+
+  print_plans();
+
+  pcm_init(pcm, CM_PCMCTL_SRC_OSC, 10);
+  pcm_set_tx_threshold(pcm, 1, 32);
+  while(1) {
+      // 44.1kHz content at 44.1kHz (fractional divisor with MASH) and
+      // converted to 48kHz (integer divisor)
+      play(pcm, CONTENT_RATE, 10);
+      play(pcm, 48000, 10);
+  }
+  return 0;
+}
@@ -0,0 +1,105 @@
+#include <stdint.h>
+#include "resample.h"
+
+// Kaiser windowed sinc (beta 7), cutoff 0.45 * input rate, Q15.
+// phase p interpolates at p / RS_PHASES after tap RS_TAPS / 2 - 1;
+// the last row is the first one shifted by one tap
+static const int16_t rs_coef[RS_PHASES + 1][RS_TAPS] = {
+    { 48, -192, 511, -1047, 1755, -2496, 3063, 29489, 3063, -2496, 1755, -1047, 511, -192, 48, -5 },
+    { 49, -191, 496, -990, 1603, -2135, 2145, 29445, 4021, -2852, 1900, -1097, 523, -192, 47, -4 },
+    { 49, -187, 478, -928, 1443, -1773, 1270, 29325, 5015, -3200, 2034, -1139, 530, -190, 45, -4 },
+    { 48, -183, 456, -861, 1278, -1412, 440, 29129, 6042, -3538, 2157, -1174, 533, -186, 43, -4 },
+    { 47, -177, 432, -790, 1110, -1056, -341, 28853, 7097, -3862, 2268, -1201, 532, -180, 39, -3 },
+    { 46, -170, 405, -716, 940, -706, -1073, 28502, 8178, -4169, 2363, -1219, 526, -173, 36, -2 },
+    { 44, -162, 376, -639, 768, -365, -1752, 28077, 9278, -4455, 2443, -1226, 514, -163, 31, -1 },
+    { 42, -152, 346, -560, 598, -36, -2378, 27575, 10395, -4718, 2506, -1224, 498, -150, 26, 0 },
+    { 40, -143, 314, -480, 429, 280, -2949, 27007, 11523, -4954, 2550, -1211, 477, -136, 20, 1 },
+    { 38, -132, 281, -400, 264, 581, -3464, 26369, 12657, -5160, 2575, -1188, 450, -119, 13, 3 },
+    { 35, -121, 248, -320, 104, 864, -3924, 25671, 13792, -5333, 2579, -1153, 418, -101, 5, 4 },
+    { 32, -110, 214, -241, -51, 1129, -4328, 24912, 14923, -5471, 2562, -1107, 381, -80, -3, 6 },
+    { 30, -98, 181, -163, -199, 1374, -4676, 24092, 16045, -5569, 2523, -1049, 338, -57, -12, 8 },
+    { 27, -87, 147, -88, -339, 1597, -4968, 23223, 17154, -5626, 2461, -980, 290, -33, -21, 11 },
+    { 24, -75, 115, -16, -471, 1799, -5206, 22305, 18243, -5639, 2375, -900, 238, -6, -31, 13 },
+    { 21, -64, 83, 54, -594, 1978, -5391, 21344, 19307, -5605, 2266, -809, 181, 22, -41, 16 },
+    { 18, -52, 52, 119, -706, 2134, -5523, 20343, 20341, -5523, 2134, -706, 119, 52, -52, 18 },
+    { 16, -41, 22, 181, -809, 2266, -5605, 19307, 21344, -5391, 1978, -594, 54, 83, -64, 21 },
+    { 13, -31, -6, 238, -900, 2375, -5639, 18243, 22305, -5206, 1799, -471, -16, 115, -75, 24 },
+    { 11, -21, -33, 290, -980, 2461, -5626, 17154, 23223, -4968, 1597, -339, -88, 147, -87, 27 },
+    { 8, -12, -57, 338, -1049, 2523, -5569, 16045, 24092, -4676, 1374, -199, -163, 181, -98, 30 },
+    { 6, -3, -80, 381, -1107, 2562, -5471, 14923, 24912, -4328, 1129, -51, -241, 214, -110, 32 },
+    { 4, 5, -101, 418, -1153, 2579, -5333, 13792, 25671, -3924, 864, 104, -320, 248, -121, 35 },
+    { 3, 13, -119, 450, -1188, 2575, -5160, 12657, 26369, -3464, 581, 264, -400, 281, -132, 38 },
+    { 1, 20, -136, 477, -1211, 2550, -4954, 11523, 27007, -2949, 280, 429, -480, 314, -143, 40 },
+    { 0, 26, -150, 498, -1224, 2506, -4718, 10395, 27575, -2378, -36, 598, -560, 346, -152, 42 },
+    { -1, 31, -163, 514, -1226, 2443, -4455, 9278, 28077, -1752, -365, 768, -639, 376, -162, 44 },
+    { -2, 36, -173, 526, -1219, 2363, -4169, 8178, 28502, -1073, -706, 940, -716, 405, -170, 46 },
+    { -3, 39, -180, 532, -1201, 2268, -3862, 7097, 28853, -341, -1056, 1110, -790, 432, -177, 47 },
+    { -4, 43, -186, 533, -1174, 2157, -3538, 6042, 29129, 440, -1412, 1278, -861, 456, -183, 48 },
+    { -4, 45, -190, 530, -1139, 2034, -3200, 5015, 29325, 1270, -1773, 1443, -928, 478, -187, 49 },
+    { -4, 47, -192, 523, -1097, 1900, -2852, 4021, 29445, 2145, -2135, 1603, -990, 496, -191, 49 },
+    { -5, 48, -192, 511, -1047, 1755, -2496, 3063, 29489, 3063, -2496, 1755, -1047, 511, -192, 48 },
+};
+
+void resample_set_ratio(resample_t *rs, uint64_t in_rate, uint64_t out_rate) {
+    uint64_t step = (in_rate << 32) / out_rate;
+    rs->step_int = step >> 32;
+    rs->step_frac = (uint32_t) step;
+}
+
+void resample_init(resample_t *rs, uint32_t in_rate, uint32_t out_rate) {
+    for (int i = 0; i < RS_TAPS * 2; i++) {
+        rs->hist[i] = 0;
+    }
+    rs->wr = 0;
+    rs->frac = 0;
+    rs->need = 0;
+    resample_set_ratio(rs, in_rate, out_rate);
+}
+
+static uint32_t interpolate(resample_t *rs) {
+    // the oldest of the last RS_TAPS frames first
+    const uint32_t *x = &rs->hist[rs->wr];
+    uint32_t p = rs->frac >> (32 - RS_PHASE_BITS);
+    int32_t f = (rs->frac >> (17 - RS_PHASE_BITS)) & 0x7fff;
+    const int16_t *c0 = rs_coef[p];
+    const int16_t *c1 = rs_coef[p + 1];
+    int32_t l = 0;
+    int32_t r = 0;
+
+    for (int k = 0; k < RS_TAPS; k++) {
+        int32_t c = c0[k] + (((c1[k] - c0[k]) * f) >> 15);
+        l += c * (int16_t) (x[k] & 0xffff);
+        r += c * (int16_t) (x[k] >> 16);
+    }
+    l >>= 15;
+    r >>= 15;
+    l = (l > 32767) ? 32767 : ((l < -32768) ? -32768 : l);
+    r = (r > 32767) ? 32767 : ((r < -32768) ? -32768 : r);
+    return ((uint32_t) r << 16) | ((uint32_t) l & 0xffff);
+}
+
+uint32_t resample_process(resample_t *rs, const uint32_t *in, uint32_t nin,
+                          uint32_t *out, uint32_t nout, uint32_t *used) {
+    uint32_t n = 0;
+    uint32_t i = 0;
+
+    while (n < nout) {
+        while (rs->need > 0) {
+            if (i == nin) {
+                *used = i;
+                return n;
+            }
+            rs->hist[rs->wr] = in[i];
+            rs->hist[rs->wr + RS_TAPS] = in[i];
+            rs->wr = (rs->wr + 1 == RS_TAPS) ? 0 : rs->wr + 1;
+            rs->need--;
+            i++;
+        }
+        out[n++] = interpolate(rs);
+        uint32_t frac = rs->frac + rs->step_frac;
+        rs->need = rs->step_int + (frac < rs->frac);
+        rs->frac = frac;
+    }
+    *used = i;
+    return n;
+}
@@ -0,0 +1,41 @@
+#ifndef RESAMPLE_H
+#define RESAMPLE_H
+
+// Polyphase sample rate converter
+//
+// Converts packed stereo frames (channel 1 in bits 15:0) from one rate
+// to another with a 16 taps windowed sinc filter. The filter has
+// RS_PHASES phases and the coefficients between two phases are
+// linearly interpolated, so any ratio can be used. The cutoff is 0.45
+// of the input rate, which suits conversions between the standard
+// rates of 0.9 to 1.1 and up-sampling. Down-sampling further than that
+// aliases.
+
+#include <stdint.h>
+
+#define RS_TAPS         16
+#define RS_PHASE_BITS   5
+#define RS_PHASES       (1 << RS_PHASE_BITS)
+
+typedef struct _resample_t {
+    uint32_t hist[RS_TAPS * 2];     // written twice: a window is contiguous
+    uint32_t wr;                    // next position in hist
+    uint32_t frac;                  // position between two inputs (Q32)
+    uint32_t step_int;              // input frames per output frame
+    uint32_t step_frac;
+    uint32_t need;                  // input frames to read before next output
+} resample_t;
+
+void resample_init(resample_t *rs, uint32_t in_rate, uint32_t out_rate);
+
+// the ratio can be changed while running, for example to follow a
+// clock which drifts. rates can be in any unit (Hz, mHz)
+void resample_set_ratio(resample_t *rs, uint64_t in_rate, uint64_t out_rate);
+
+// convert up to nin input frames into up to nout output frames.
+// returns the number of output frames, *used is set to the number of
+// input frames consumed
+uint32_t resample_process(resample_t *rs, const uint32_t *in, uint32_t nin,
+                          uint32_t *out, uint32_t nout, uint32_t *used);
+
+#endif
@@ -0,0 +1,145 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bsp.h"
+#include "dsp.h"
+#include "pcm.h"
+#include "synth.h"
+
+// Cycle counter of ARM1176 (Performance Monitor Control Register)
+
+static inline void ccnt_start(void) {
+    // enable counters (E), reset count registers (P) and cycle counter (C)
+    __asm volatile("mcr p15, 0, %0, c15, c12, 0" :: "r" (7));
+}
+
+static inline uint32_t ccnt_read(void) {
+    uint32_t c;
+    __asm volatile("mrc p15, 0, %0, c15, c12, 1" : "=r" (c));
+    return c;
+}
+
+static void enable_icache(void) {
+    uint32_t c1;
+    __asm volatile("mrc p15, 0, %0, c1, c0, 0" : "=r" (c1));
+    c1 |= (1 << 12) | (1 << 11);    // I-cache, branch prediction
+    __asm volatile("mcr p15, 0, %0, c1, c0, 0" :: "r" (c1));
+}
+
+// Synthesizer
+
+#define SAMPLE_RATE  48000
+#define CPU_CLOCK    700000000
+#define BLOCK_LEN    256
+#define BENCH_LOOPS  16
+
+static synth_t synth;
+static synth_table_t sine;
+static synth_table_t saw;
+static uint32_t block[BLOCK_LEN];
+
+// cycles of one block at SAMPLE_RATE
+#define BLOCK_BUDGET  ((uint32_t) ((uint64_t) CPU_CLOCK * BLOCK_LEN / SAMPLE_RATE))
+
+void synth_benchmark(void) {
+    const uint32_t voices[] = { 1, 4, 8, 16, 32 };
+    uint32_t per_voice = 0;
+
+    uart_print("\r\nvoices cycles/frame load@48kHz\r\n");
+    for (int i = 0; i < sizeof(voices) / sizeof(voices[0]); i++) {
+        synth_init(&synth, SAMPLE_RATE);
+        // long sustain so that all the voices keep sounding
+        synth_set_adsr(&synth, 1, 1000, 32768, 100);
+        for (uint32_t v = 0; v < voices[i]; v++) {
+            synth_note_on(&synth, saw, 36 + v, 16, v * 4);
+        }
+        ccnt_start();
+        for (int l = 0; l < BENCH_LOOPS; l++) {
+            synth_render(&synth, block, BLOCK_LEN);
+        }
+        uint32_t cycles = ccnt_read() / BENCH_LOOPS;
+        uint32_t load = (uint64_t) cycles * 1000 / BLOCK_BUDGET;
+        uart_put_dec(voices[i]);
+        uart_putc(' ');
+        uart_put_dec(cycles / BLOCK_LEN);
+        uart_putc(' ');
+        uart_put_dec(load / 10);
+        uart_putc('.');
+        uart_put_dec(load % 10);
+        uart_print("%\r\n");
+        per_voice = cycles / voices[i];
+    }
+    uart_print("max voices at 48kHz: ");
+    uart_put_dec(BLOCK_BUDGET / per_voice);
+    uart_print("\r\n");
+    synth_init(&synth, SAMPLE_RATE);
+}
+
+// chords of C - Am - F - G, played every 500ms
+static const uint8_t chords[4][4] = {
+    { 48, 60, 64, 67 },
+    { 45, 57, 60, 64 },
+    { 41, 57, 60, 65 },
+    { 43, 55, 59, 62 },
+};
+
+static void play_chord(int c, int on) {
+    for (int i = 0; i < 4; i++) {
+        if (on) {
+            const int16_t *t = (i == 0) ? saw : sine;
+            synth_note_on(&synth, t, chords[c][i], 40, 32 + i * 20);
+        } else {
+            synth_note_off(&synth, chords[c][i]);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+  pcm_t* pcm = (pcm_t*) PCM;
+
+  uart_init(UART_BAUD);
+  enable_icache();
+  uart_print("\r\nI2S synthesizer. Signal is on GPIO18(CLK)/19(FS)/21(DATA).\r\n");
+
+  synth_make_sine(sine);
+  synth_make_saw(saw);
+  synth_benchmark();
+  synth_set_adsr(&synth, 10, 200, 16384, 300);
+
+  // set BCLK to 19.2MHz/10 = 1.92MHz, 40 clocks per frame = 48kHz
+  pcm_init(pcm, CM_PCMCTL_SRC_OSC, 10);
+  pcm_set_format(pcm, 40, 16);
+
+  pcm->CS |= CS_TXCLR;
+  pcm->CS |= CS_SYNC;
+  do {} while ((pcm->CS & CS_SYNC) == 0);
+  pcm_set_tx_threshold(pcm, 3, PCM_FIFO_LEN / 2);
+  for (int i = 0; i < PCM_FIFO_LEN; i++) {
+      pcm->FIFO = 0;
+  }
+  pcm->CS |= CS_TXERR;
+  pcm->CS |= CS_TXON;
+
+  int chord = 0;
+  uint64_t next = systime();
+  while(1) {
+      if (systime() >= next) {
+          play_chord(chord, 0);
+          chord = (chord + 1) % 4;
+          play_chord(chord, 1);
+          next += 500000;
+      }
+      // the FIFO (64 frames) keeps playing while the next block is rendered
+      synth_render(&synth, block, BLOCK_LEN);
+      dsp_soft_clip(block, BLOCK_LEN);
+      for (int i = 0; i < BLOCK_LEN; i++) {
+          do {} while ((pcm->CS & CS_TXW) == 0);
+          pcm->FIFO = block[i];
+      }
+      if (pcm->CS & CS_TXERR) {
+          uart_print("underrun\r\n");
+          pcm->CS |= CS_TXERR;
+      }
+  }
+  return 0;
+}
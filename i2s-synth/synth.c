@@ -0,0 +1,224 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "synth.h"
+#include "dsp.h"
+
+// wavetables
+
+void synth_make_sine(synth_table_t table) {
+    // rotate (c, s) by 2*pi/SYNTH_TABLE_LEN each step (Q30)
+    const int64_t cos_d = 1073418433;   // cos(2*pi/256) * 2^30
+    const int64_t sin_d = 26350943;     // sin(2*pi/256) * 2^30
+    int64_t c = 1 << 30;
+    int64_t s = 0;
+
+    for (int i = 0; i < SYNTH_TABLE_LEN; i++) {
+        table[i] = dsp_sat16((int32_t) (s >> 15));
+        int64_t c1 = (c * cos_d - s * sin_d) >> 30;
+        int64_t s1 = (s * cos_d + c * sin_d) >> 30;
+        c = c1;
+        s = s1;
+    }
+    table[SYNTH_TABLE_LEN] = table[0];
+}
+
+void synth_make_saw(synth_table_t table) {
+    for (int i = 0; i < SYNTH_TABLE_LEN; i++) {
+        table[i] = (int16_t) ((i << (16 - SYNTH_TABLE_BITS)) - 32768);
+    }
+    table[SYNTH_TABLE_LEN] = table[0];
+}
+
+void synth_make_square(synth_table_t table) {
+    for (int i = 0; i < SYNTH_TABLE_LEN; i++) {
+        table[i] = (i < SYNTH_TABLE_LEN / 2) ? 32767 : -32767;
+    }
+    table[SYNTH_TABLE_LEN] = table[0];
+}
+
+void synth_make_triangle(synth_table_t table) {
+    const int32_t q = SYNTH_TABLE_LEN / 4;
+    for (int i = 0; i < SYNTH_TABLE_LEN; i++) {
+        int32_t v;
+        if (i < q) {
+            v = i;
+        } else if (i < 3 * q) {
+            v = 2 * q - i;
+        } else {
+            v = i - 4 * q;
+        }
+        table[i] = dsp_sat16(v * 32768 / q);
+    }
+    table[SYNTH_TABLE_LEN] = table[0];
+}
+
+// phase increments of MIDI note 120-131 are calculated from these
+// frequencies (mHz), lower octaves are shifted down
+static const uint32_t top_octave[12] = {
+    8372018, 8869844, 9397273, 9956063, 10548082, 11175303,
+    11839822, 12543854, 13289750, 14080000, 14917240, 15804266,
+};
+
+static uint32_t note_inc(synth_t *s, uint32_t note) {
+    uint64_t inc = ((uint64_t) top_octave[note % 12] << 32) / (s->rate * 1000ULL);
+    inc >>= 10 - note / 12;
+    // above Nyquist frequency
+    return (inc > 0x7fffffffU) ? 0x7fffffffU : (uint32_t) inc;
+}
+
+static int32_t env_step(synth_t *s, int32_t range, uint32_t ms) {
+    uint32_t samples = s->rate / 1000 * ms;
+    return (samples == 0) ? ENV_FULL : (int32_t) (range / samples) + 1;
+}
+
+void synth_init(synth_t *s, uint32_t rate) {
+    s->rate = rate;
+    s->age = 0;
+    for (int i = 0; i < SYNTH_MAX_VOICES; i++) {
+        s->voice[i].stage = ENV_OFF;
+        s->voice[i].level = 0;
+        s->voice[i].age = 0;
+    }
+    synth_set_adsr(s, 5, 100, 24576, 200);
+}
+
+void synth_set_adsr(synth_t *s, uint32_t attack, uint32_t decay,
+                    uint32_t sustain, uint32_t release) {
+    sustain = (sustain > 32768) ? 32768 : sustain;
+    s->sustain = sustain << 15;
+    s->attack_step = env_step(s, ENV_FULL, attack);
+    s->decay_step = env_step(s, ENV_FULL - s->sustain, decay);
+    s->release_step = env_step(s, ENV_FULL, release);
+}
+
+static synth_voice_t *find_voice(synth_t *s) {
+    synth_voice_t *oldest = &s->voice[0];
+    synth_voice_t *released = NULL;
+
+    for (int i = 0; i < SYNTH_MAX_VOICES; i++) {
+        synth_voice_t *v = &s->voice[i];
+        if (v->stage == ENV_OFF) {
+            return v;
+        }
+        if ((v->stage == ENV_RELEASE)
+            && ((released == NULL) || ((int32_t) (v->age - released->age) < 0))) {
+            released = v;
+        }
+        if ((int32_t) (v->age - oldest->age) < 0) {
+            oldest = v;
+        }
+    }
+    return released ? released : oldest;
+}
+
+int synth_note_on(synth_t *s, const int16_t *table, uint32_t note,
+                  uint32_t velocity, uint32_t pan) {
+    synth_voice_t *v = find_voice(s);
+
+    note &= 0x7f;
+    velocity = (velocity > 127) ? 127 : velocity;
+    pan = (pan > 127) ? 127 : pan;
+    int32_t g = velocity * 258;     // 127 * 258 = 32766
+    v->table = table;
+    v->phase = 0;
+    v->inc = note_inc(s, note);
+    v->gain_l = g * (int32_t) (127 - pan) / 127;
+    v->gain_r = g * (int32_t) pan / 127;
+    v->age = s->age++;
+    v->note = note;
+    // a stolen voice starts from its current level to avoid a click
+    v->stage = ENV_ATTACK;
+    return v - s->voice;
+}
+
+void synth_note_off(synth_t *s, uint32_t note) {
+    for (int i = 0; i < SYNTH_MAX_VOICES; i++) {
+        synth_voice_t *v = &s->voice[i];
+        if ((v->note == note) && (v->stage != ENV_OFF)) {
+            v->stage = ENV_RELEASE;
+        }
+    }
+}
+
+uint32_t synth_active(synth_t *s) {
+    uint32_t n = 0;
+    for (int i = 0; i < SYNTH_MAX_VOICES; i++) {
+        if (s->voice[i].stage != ENV_OFF) {
+            n++;
+        }
+    }
+    return n;
+}
+
+// advance the envelope by one sample
+static inline int32_t envelope(synth_t *s, synth_voice_t *v) {
+    int32_t level = v->level;
+
+    switch (v->stage) {
+    case ENV_ATTACK:
+        level += s->attack_step;
+        if (level >= ENV_FULL) {
+            level = ENV_FULL;
+            v->stage = ENV_DECAY;
+        }
+        break;
+    case ENV_DECAY:
+        level -= s->decay_step;
+        if (level <= s->sustain) {
+            level = s->sustain;
+            v->stage = ENV_SUSTAIN;
+        }
+        break;
+    case ENV_RELEASE:
+        level -= s->release_step;
+        if (level <= 0) {
+            level = 0;
+            v->stage = ENV_OFF;
+        }
+        break;
+    default:
+        break;
+    }
+    v->level = level;
+    return level;
+}
+
+static void render_voice(synth_t *s, synth_voice_t *v, uint32_t n) {
+    int32_t *l = s->mix[0];
+    int32_t *r = s->mix[1];
+    const int16_t *t = v->table;
+    uint32_t phase = v->phase;
+    uint32_t inc = v->inc;
+    int32_t gl = v->gain_l;
+    int32_t gr = v->gain_r;
+
+    for (uint32_t i = 0; i < n; i++) {
+        int32_t env = envelope(s, v) >> 15;
+        uint32_t idx = phase >> (32 - SYNTH_TABLE_BITS);
+        int32_t frac = (phase >> (17 - SYNTH_TABLE_BITS)) & 0x7fff;
+        int32_t a = t[idx];
+        int32_t x = a + (((t[idx + 1] - a) * frac) >> 15);
+        x = (x * env) >> 15;
+        l[i] += (x * gl) >> 15;
+        r[i] += (x * gr) >> 15;
+        phase += inc;
+    }
+    v->phase = phase;
+}
+
+void synth_render(synth_t *s, uint32_t *buf, uint32_t n) {
+    n = (n > SYNTH_BLOCK_MAX) ? SYNTH_BLOCK_MAX : n;
+    for (uint32_t i = 0; i < n; i++) {
+        s->mix[0][i] = 0;
+        s->mix[1][i] = 0;
+    }
+    for (int i = 0; i < SYNTH_MAX_VOICES; i++) {
+        synth_voice_t *v = &s->voice[i];
+        if (v->stage != ENV_OFF) {
+            render_voice(s, v, n);
+        }
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        buf[i] = dsp_pack(dsp_sat16(s->mix[0][i]), dsp_sat16(s->mix[1][i]));
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef SYNTH_H
+#define SYNTH_H
+
+// Polyphonic wavetable synthesizer
+//
+// Each voice plays a wavetable of SYNTH_TABLE_LEN samples with a 32-bit
+// phase accumulator and linear interpolation, shaped by an ADSR
+// envelope. synth_render() mixes all the active voices into a block of
+// packed stereo frames (left in bits 15:0, right in bits 31:16).
+
+#include <stdint.h>
+
+#define SYNTH_MAX_VOICES   32
+#define SYNTH_BLOCK_MAX    256
+#define SYNTH_TABLE_BITS   8
+#define SYNTH_TABLE_LEN    (1 << SYNTH_TABLE_BITS)
+
+// a wavetable has one guard sample at the end, a copy of the first one
+typedef int16_t synth_table_t[SYNTH_TABLE_LEN + 1];
+
+void synth_make_sine(synth_table_t table);
+void synth_make_saw(synth_table_t table);
+void synth_make_square(synth_table_t table);
+void synth_make_triangle(synth_table_t table);
+
+#define ENV_OFF      0
+#define ENV_ATTACK   1
+#define ENV_DECAY    2
+#define ENV_SUSTAIN  3
+#define ENV_RELEASE  4
+
+#define ENV_FULL     (1 << 30)
+
+typedef struct _synth_voice_t {
+    const int16_t *table;
+    uint32_t phase;
+    uint32_t inc;               // phase increment per sample
+    int32_t level;              // envelope, 0 .. ENV_FULL
+    int32_t gain_l;             // velocity and pan (Q15)
+    int32_t gain_r;
+    uint32_t age;               // note on order, for voice stealing
+    uint8_t note;
+    uint8_t stage;
+} synth_voice_t;
+
+typedef struct _synth_t {
+    synth_voice_t voice[SYNTH_MAX_VOICES];
+    uint32_t rate;
+    uint32_t age;
+    int32_t attack_step;        // envelope steps per sample
+    int32_t decay_step;
+    int32_t sustain;
+    int32_t release_step;
+    int32_t mix[2][SYNTH_BLOCK_MAX];
+} synth_t;
+
+void synth_init(synth_t *s, uint32_t rate);
+
+// times in ms, sustain level in Q15 (32768 = 1.0).
+// release is the time from the full level to 0
+void synth_set_adsr(synth_t *s, uint32_t attack, uint32_t decay,
+                    uint32_t sustain, uint32_t release);
+
+// start a MIDI note (0-127) with velocity (1-127) and pan (0: left -
+// 64: center - 127: right). a free voice is used if there is one,
+// otherwise the oldest releasing voice or the oldest voice is stolen.
+// returns the voice number
+int synth_note_on(synth_t *s, const int16_t *table, uint32_t note,
+                  uint32_t velocity, uint32_t pan);
+
+// release all the voices playing the note
+void synth_note_off(synth_t *s, uint32_t note);
+
+// returns the number of voices sounding
+uint32_t synth_active(synth_t *s);
+
+// render n (up to SYNTH_BLOCK_MAX) frames
+void synth_render(synth_t *s, uint32_t *buf, uint32_t n);
+
+#endif
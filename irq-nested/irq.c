@@ -0,0 +1,276 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "bsp.h"
+#include "irq.h"
+
+#define IRQ_BASIC         IOREG(0x2000B200)
+#define IRQ_PEND1         IOREG(0x2000B204)
+#define IRQ_PEND2         IOREG(0x2000B208)
+#define IRQ_FIQ_CONTROL   IOREG(0x2000B20C)
+#define IRQ_ENABLE1       IOREG(0x2000B210)
+#define IRQ_ENABLE2       IOREG(0x2000B214)
+#define IRQ_ENABLE_BASIC  IOREG(0x2000B218)
+#define IRQ_DISABLE1      IOREG(0x2000B21C)
+#define IRQ_DISABLE2      IOREG(0x2000B220)
+#define IRQ_DISABLE_BASIC IOREG(0x2000B224)
+
+// only the ARM specific bits of IRQ_BASIC are sources of their own,
+// bits 8 and above are shortcuts of IRQ_PEND1/IRQ_PEND2.
+#define IRQ_BASIC_ARM_MASK  (0xffU)
+
+// bank 0: IRQ_PEND1, bank 1: IRQ_PEND2, bank 2: IRQ_BASIC
+#define IRQ_BANKS   3
+#define IRQ_BANK(n) ((n) >> 5)
+#define IRQ_BIT(n)  (1U << ((n) & 31))
+
+// ldr pc, [pc, #24]
+#define	JMP_PC_24	0xe59ff018
+
+typedef void (*exception_hander_t)(void);
+
+typedef struct __attribute__((aligned(32))) _vector_table_t {
+    const unsigned int vector[8]; // all elements shoud be JMP_PC_24
+    exception_hander_t reset;
+    exception_hander_t undef;
+    exception_hander_t svc;
+    exception_hander_t prefetch_abort;
+    exception_hander_t data_abort;
+    exception_hander_t hypervisor_trap;
+    exception_hander_t irq;
+    exception_hander_t fiq;
+} vector_table_t;
+
+extern void _irq_handler_stub(void);
+static void __attribute__((naked)) hangup(void);
+
+static vector_table_t exception_vector = { \
+    .vector = { JMP_PC_24, JMP_PC_24, JMP_PC_24, JMP_PC_24, \
+                JMP_PC_24, JMP_PC_24, JMP_PC_24, JMP_PC_24 },
+    .reset = Init_Machine,
+    .undef = hangup,
+    .svc = hangup,
+    .prefetch_abort = hangup,
+    .data_abort = hangup,
+    .hypervisor_trap = hangup,
+    .irq = _irq_handler_stub,
+    .fiq = hangup
+};
+
+static void __attribute__((naked)) hangup(void) {
+    while(1) {
+    }
+}
+
+static void set_vbar(vector_table_t *base) {
+    __asm volatile ("mcr p15, 0, %[base], c12, c0, 0"
+                  :: [base] "r" (base));
+}
+
+typedef struct _irq_entry_t {
+    irq_handler_t handler;
+    void *arg;
+    uint32_t prio;
+} irq_entry_t;
+
+static irq_entry_t irq_table[IRQ_COUNT];
+
+// sources of each priority level
+static uint32_t level_sources[IRQ_PRIO_LEVELS][IRQ_BANKS];
+// sources masked while a handler of each level is running
+// (the level itself and all the lower levels)
+static uint32_t level_mask[IRQ_PRIO_LEVELS][IRQ_BANKS];
+
+// sources enabled by irq_enable()
+static uint32_t enabled[IRQ_BANKS];
+// sources temporarily masked by the running handlers
+static uint32_t masked[IRQ_BANKS];
+
+static volatile uint32_t current_level = IRQ_PRIO_THREAD;
+static volatile uint32_t nesting;
+static irq_hook_t exit_hook;
+
+static void hw_enable(const uint32_t *bits) {
+    if (bits[0]) IRQ_ENABLE1 = bits[0];
+    if (bits[1]) IRQ_ENABLE2 = bits[1];
+    if (bits[2]) IRQ_ENABLE_BASIC = bits[2];
+}
+
+static void hw_disable(const uint32_t *bits) {
+    if (bits[0]) IRQ_DISABLE1 = bits[0];
+    if (bits[1]) IRQ_DISABLE2 = bits[1];
+    if (bits[2]) IRQ_DISABLE_BASIC = bits[2];
+}
+
+static void update_level_mask(void) {
+    for (int b = 0; b < IRQ_BANKS; b++) {
+        uint32_t m = 0;
+        for (int lv = IRQ_PRIO_LOWEST; lv >= 0; lv--) {
+            m |= level_sources[lv][b];
+            level_mask[lv][b] = m;
+        }
+    }
+}
+
+void irq_init(void) {
+    irq_cpu_disable();
+    IRQ_DISABLE1 = 0xffffffffU;
+    IRQ_DISABLE2 = 0xffffffffU;
+    IRQ_DISABLE_BASIC = IRQ_BASIC_ARM_MASK;
+    IRQ_FIQ_CONTROL = 0;
+
+    for (int i = 0; i < IRQ_COUNT; i++) {
+        irq_table[i].handler = NULL;
+        irq_table[i].arg = NULL;
+        irq_table[i].prio = IRQ_PRIO_LOWEST;
+    }
+    for (int lv = 0; lv < IRQ_PRIO_LEVELS; lv++) {
+        for (int b = 0; b < IRQ_BANKS; b++) {
+            level_sources[lv][b] = 0;
+        }
+    }
+    for (int b = 0; b < IRQ_BANKS; b++) {
+        enabled[b] = 0;
+        masked[b] = 0;
+    }
+    update_level_mask();
+    current_level = IRQ_PRIO_THREAD;
+    nesting = 0;
+    exit_hook = NULL;
+
+    set_vbar(&exception_vector);
+}
+
+int irq_attach(uint32_t irq, uint32_t prio, irq_handler_t handler, void *arg) {
+    if ((irq >= IRQ_COUNT) || (prio >= IRQ_PRIO_LEVELS)) {
+        return -1;
+    }
+    if ((IRQ_BANK(irq) == 2) && !(IRQ_BIT(irq) & IRQ_BASIC_ARM_MASK)) {
+        return -1;
+    }
+
+    uint32_t cpsr = irq_save();
+    irq_entry_t *e = &irq_table[irq];
+    level_sources[e->prio][IRQ_BANK(irq)] &= ~IRQ_BIT(irq);
+    e->handler = handler;
+    e->arg = arg;
+    e->prio = prio;
+    level_sources[prio][IRQ_BANK(irq)] |= IRQ_BIT(irq);
+    update_level_mask();
+    irq_restore(cpsr);
+    return 0;
+}
+
+void irq_enable(uint32_t irq) {
+    if (irq >= IRQ_COUNT) {
+        return;
+    }
+    uint32_t bits[IRQ_BANKS] = {0, 0, 0};
+    uint32_t cpsr = irq_save();
+    enabled[IRQ_BANK(irq)] |= IRQ_BIT(irq);
+    // a source masked by a running handler is enabled on its exit
+    bits[IRQ_BANK(irq)] = IRQ_BIT(irq) & ~masked[IRQ_BANK(irq)];
+    hw_enable(bits);
+    irq_restore(cpsr);
+}
+
+void irq_disable(uint32_t irq) {
+    if (irq >= IRQ_COUNT) {
+        return;
+    }
+    uint32_t bits[IRQ_BANKS] = {0, 0, 0};
+    uint32_t cpsr = irq_save();
+    enabled[IRQ_BANK(irq)] &= ~IRQ_BIT(irq);
+    bits[IRQ_BANK(irq)] = IRQ_BIT(irq);
+    hw_disable(bits);
+    irq_restore(cpsr);
+}
+
+uint32_t irq_current_level(void) {
+    return current_level;
+}
+
+uint32_t irq_nesting(void) {
+    return nesting;
+}
+
+void irq_set_exit_hook(irq_hook_t hook) {
+    uint32_t cpsr = irq_save();
+    exit_hook = hook;
+    irq_restore(cpsr);
+}
+
+// find the highest priority pending source, or -1 if none
+static int irq_pending(void) {
+    uint32_t pend[IRQ_BANKS];
+    pend[0] = IRQ_PEND1 & enabled[0] & ~masked[0];
+    pend[1] = IRQ_PEND2 & enabled[1] & ~masked[1];
+    pend[2] = IRQ_BASIC & enabled[2] & ~masked[2] & IRQ_BASIC_ARM_MASK;
+    if ((pend[0] | pend[1] | pend[2]) == 0) {
+        return -1;
+    }
+
+    for (int lv = 0; lv < IRQ_PRIO_LEVELS; lv++) {
+        for (int b = 0; b < IRQ_BANKS; b++) {
+            uint32_t p = pend[b] & level_sources[lv][b];
+            if (p) {
+                return (b << 5) + __builtin_ctz(p);
+            }
+        }
+    }
+    // pending but no handler attached
+    return (pend[0]) ? __builtin_ctz(pend[0]) :
+        (pend[1]) ? 32 + __builtin_ctz(pend[1]) : 64 + __builtin_ctz(pend[2]);
+}
+
+// Called from _irq_handler_stub in SVC mode with CPU IRQ disabled.
+// The handler runs with CPU IRQ enabled while the sources at or below
+// its level are masked in the interrupt controller, so only the higher
+// priority sources can preempt it.
+void irq_dispatch(void) {
+    int irq = irq_pending();
+    if (irq < 0) {
+        return;
+    }
+
+    irq_entry_t *e = &irq_table[irq];
+    if (e->handler == NULL) {
+        // nobody clears this source: disable it to avoid an IRQ storm
+        irq_disable(irq);
+        return;
+    }
+
+    // mask the sources of this level and below which are not masked yet
+    uint32_t newly[IRQ_BANKS];
+    uint32_t bits[IRQ_BANKS];
+    for (int b = 0; b < IRQ_BANKS; b++) {
+        newly[b] = level_mask[e->prio][b] & ~masked[b];
+        masked[b] |= newly[b];
+        bits[b] = newly[b] & enabled[b];
+    }
+    hw_disable(bits);
+
+    uint32_t saved_level = current_level;
+    current_level = e->prio;
+    nesting++;
+
+    irq_cpu_enable();
+    e->handler(e->arg);
+    irq_cpu_disable();
+
+    nesting--;
+    current_level = saved_level;
+
+    // unmask them again (the handler may have changed the enabled set)
+    for (int b = 0; b < IRQ_BANKS; b++) {
+        masked[b] &= ~newly[b];
+        bits[b] = newly[b] & enabled[b];
+    }
+    hw_enable(bits);
+}
+
+// Called from _irq_handler_stub after irq_dispatch() with CPU IRQ disabled.
+void irq_exit(void) {
+    if ((nesting == 0) && (exit_hook != NULL)) {
+        exit_hook();
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef IRQ_H
+#define IRQ_H
+
+#include <stdint.h>
+
+// IRQ numbers
+// 0..63 are the GPU peripheral interrupts (IRQ_PEND1/IRQ_PEND2),
+// 64..71 are the ARM specific interrupts (IRQ_BASIC bits 0..7).
+#define IRQ_SYSTIMER_C1   1
+#define IRQ_SYSTIMER_C3   3
+#define IRQ_USB           9
+#define IRQ_AUX           29
+#define IRQ_I2C           53
+#define IRQ_SPI           54
+#define IRQ_PCM           55
+#define IRQ_UART          57
+#define IRQ_ARM_TIMER     64
+#define IRQ_ARM_MAILBOX   65
+
+#define IRQ_COUNT         72
+
+// Software priority levels. 0 is the highest priority.
+// While a handler of level N is running, every source of level N or
+// lower (N..IRQ_PRIO_LOWEST) is masked and only the sources of higher
+// levels (0..N-1) can preempt it.
+#define IRQ_PRIO_LEVELS   8
+#define IRQ_PRIO_HIGHEST  0
+#define IRQ_PRIO_LOWEST   (IRQ_PRIO_LEVELS - 1)
+#define IRQ_PRIO_THREAD   IRQ_PRIO_LEVELS  // no handler is running
+
+typedef void (*irq_handler_t)(void *arg);
+typedef void (*irq_hook_t)(void);
+
+// install the vector table and clear all handlers.
+// CPU IRQ stays disabled until irq_cpu_enable() is called.
+void irq_init(void);
+
+// register a handler and its priority level.
+// the handler must clear the interrupt condition of its source.
+int irq_attach(uint32_t irq, uint32_t prio, irq_handler_t handler, void *arg);
+
+void irq_enable(uint32_t irq);
+void irq_disable(uint32_t irq);
+
+// priority level of the running handler (IRQ_PRIO_THREAD if none)
+uint32_t irq_current_level(void);
+
+// current nesting depth (0 if no handler is running)
+uint32_t irq_nesting(void);
+
+// set the function called when the outermost handler returns.
+// it is called with CPU IRQ disabled and may enable it (soft-IRQ).
+void irq_set_exit_hook(irq_hook_t hook);
+
+static inline void irq_cpu_enable(void) {
+    __asm volatile("cpsie i" ::: "memory");
+}
+
+static inline void irq_cpu_disable(void) {
+    __asm volatile("cpsid i" ::: "memory");
+}
+
+// disable CPU IRQ and return the previous CPSR
+static inline uint32_t irq_save(void) {
+    uint32_t cpsr;
+    __asm volatile("mrs %0, cpsr \n"
+                   "cpsid i \n" : "=r" (cpsr) :: "memory");
+    return cpsr;
+}
+
+static inline void irq_restore(uint32_t cpsr) {
+    __asm volatile("msr cpsr_c, %0" :: "r" (cpsr) : "memory");
+}
+
+#endif
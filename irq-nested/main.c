@@ -0,0 +1,126 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bsp.h"
+#include "irq.h"
+#include "workq.h"
+
+#define SYST_CS_M1  (1 << 1)
+#define SYST_CS_M3  (1 << 3)
+
+#define ARM_TIMER_LOD IOREG(0x2000B400)
+#define ARM_TIMER_VAL IOREG(0x2000B404)
+#define ARM_TIMER_CTL IOREG(0x2000B408)
+#define ARM_TIMER_CLI IOREG(0x2000B40C)
+#define ARM_TIMER_RLD IOREG(0x2000B418)
+#define ARM_TIMER_DIV IOREG(0x2000B41C)
+
+// interrupt periods in usec
+#define AUDIO_PERIOD  1000
+#define TICK_PERIOD   10000
+#define USB_PERIOD    100000
+#define USB_BUSY      5000
+
+static volatile uint32_t audio_count;
+static volatile uint32_t audio_max_latency;
+static volatile uint32_t tick_count;
+static volatile uint32_t usb_count;
+static volatile uint32_t usb_work_count;
+static volatile uint32_t max_nesting;
+
+// highest priority: must never wait for the slow handler
+static void audio_handler(void *arg) {
+    uint32_t latency = SYST_CLO - SYST_C1;
+    if (latency > audio_max_latency) {
+        audio_max_latency = latency;
+    }
+    if (irq_nesting() > max_nesting) {
+        max_nesting = irq_nesting();
+    }
+    SYST_C1 = SYST_C1 + AUDIO_PERIOD;
+    SYST_CS = SYST_CS_M1;
+    audio_count++;
+}
+
+static void tick_handler(void *arg) {
+    ARM_TIMER_CLI = 0;
+    tick_count++;
+}
+
+// bottom half of the USB interrupt: runs with all the sources enabled
+static void usb_work(void *arg, uint32_t data) {
+    uint32_t start = SYST_CLO;
+    while (SYST_CLO - start < USB_BUSY);
+    usb_work_count++;
+}
+
+// lowest priority: only acknowledges the interrupt and defers the
+// slow USB processing to the work queue
+static void usb_handler(void *arg) {
+    SYST_C3 = SYST_C3 + USB_PERIOD;
+    SYST_CS = SYST_CS_M3;
+    workq_post(usb_work, NULL, SYST_CLO);
+    usb_count++;
+}
+
+int main(int argc, char **argv) {
+  const char msg[] = "Nested interrupt test.\012\015\000";
+
+  irq_init();
+  workq_init();
+
+  uart_init(UART_BAUD);
+
+  uart_print(msg);
+
+  // priority 0: audio, 2: timer tick, 5: usb
+  irq_attach(IRQ_SYSTIMER_C1, 0, audio_handler, NULL);
+  irq_attach(IRQ_ARM_TIMER, 2, tick_handler, NULL);
+  irq_attach(IRQ_SYSTIMER_C3, 5, usb_handler, NULL);
+
+  // set timers
+  ARM_TIMER_CTL = 0x003E0002; // timer and irq disabled, 23-bit counter
+  ARM_TIMER_LOD = TICK_PERIOD - 1;
+  ARM_TIMER_RLD = TICK_PERIOD - 1;
+  ARM_TIMER_DIV = 0x000000F9; // 250MHz / (249 + 1) = 1 MHz
+  ARM_TIMER_CLI = 0;
+  ARM_TIMER_CTL = 0x003E00A2; // timer and irq enabled, 23-bit counter
+
+  uint32_t now = SYST_CLO;
+  SYST_C1 = now + AUDIO_PERIOD;
+  SYST_C3 = now + USB_PERIOD;
+  SYST_CS = SYST_CS_M1 | SYST_CS_M3;
+
+  irq_enable(IRQ_SYSTIMER_C1);
+  irq_enable(IRQ_ARM_TIMER);
+  irq_enable(IRQ_SYSTIMER_C3);
+  // execute the deferred work on the way out of the interrupt
+  workq_softirq(1);
+  irq_cpu_enable();
+
+  uart_print("audio tick usb usb_work dropped max_latency(us) max_nesting\012\015");
+  uint64_t next = systime();
+  while (1) {
+    // idle loop: execute the deferred work until the next report
+    next += 1000000;
+    while (systime() < next) {
+      workq_run();
+    }
+    uart_put_dec(audio_count);
+    uart_putchar(' ');
+    uart_put_dec(tick_count);
+    uart_putchar(' ');
+    uart_put_dec(usb_count);
+    uart_putchar(' ');
+    uart_put_dec(usb_work_count);
+    uart_putchar(' ');
+    uart_put_dec(workq_dropped());
+    uart_putchar(' ');
+    uart_put_dec(audio_max_latency);
+    uart_putchar(' ');
+    uart_put_dec(max_nesting);
+    uart_print("\012\015");
+  }
+
+  return 0;
+}
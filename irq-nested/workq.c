@@ -0,0 +1,113 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "atomic.h"
+#include "irq.h"
+#include "workq.h"
+
+// Bounded MPSC queue. Each slot has a sequence number which tells
+// whether the slot is free for the producer of position `seq` or
+// holds an item published for the consumer of position `seq - 1`.
+// Producers reserve a slot by advancing `head` with ldrex/strex,
+// so a producer preempted by a nested interrupt never blocks it.
+
+typedef struct _work_t {
+    volatile uint32_t seq;
+    work_fn_t fn;
+    void *arg;
+    uint32_t data;
+} work_t;
+
+#define WORKQ_MASK  (WORKQ_LEN - 1)
+
+static work_t queue[WORKQ_LEN];
+static volatile uint32_t head;      // next position to reserve
+static uint32_t tail;               // next position to execute
+static volatile uint32_t draining;  // a context is executing items
+static volatile uint32_t dropped;
+
+void workq_init(void) {
+    for (uint32_t i = 0; i < WORKQ_LEN; i++) {
+        queue[i].seq = i;
+        queue[i].fn = NULL;
+    }
+    head = 0;
+    tail = 0;
+    draining = 0;
+    dropped = 0;
+}
+
+int workq_post(work_fn_t fn, void *arg, uint32_t data) {
+    work_t *w;
+    uint32_t pos = head;
+    for (;;) {
+        w = &queue[pos & WORKQ_MASK];
+        int32_t dif = (int32_t) (w->seq - pos);
+        if (dif == 0) {
+            if (cas32(&head, pos, pos + 1)) {
+                break;
+            }
+            pos = head;
+        } else if (dif < 0) {
+            // the consumer has not executed this slot yet
+            atomic_inc(&dropped);
+            return -1;
+        } else {
+            // another producer took this slot
+            pos = head;
+        }
+    }
+
+    w->fn = fn;
+    w->arg = arg;
+    w->data = data;
+    dmb();
+    w->seq = pos + 1;
+    return 0;
+}
+
+int workq_run(void) {
+    if (!cas32(&draining, 0, 1)) {
+        return 0;
+    }
+
+    int n = 0;
+    for (;;) {
+        work_t *w = &queue[tail & WORKQ_MASK];
+        if (w->seq != tail + 1) {
+            // empty, or a preempted producer has not published yet
+            break;
+        }
+        dmb();
+        work_fn_t fn = w->fn;
+        void *arg = w->arg;
+        uint32_t data = w->data;
+        dmb();
+        w->seq = tail + WORKQ_LEN;
+        tail++;
+
+        fn(arg, data);
+        n++;
+    }
+
+    dmb();
+    draining = 0;
+    return n;
+}
+
+// called on interrupt exit with CPU IRQ disabled
+static void workq_softirq_hook(void) {
+    if (draining || (queue[tail & WORKQ_MASK].seq != tail + 1)) {
+        return;
+    }
+    irq_cpu_enable();
+    workq_run();
+    irq_cpu_disable();
+}
+
+void workq_softirq(int enable) {
+    irq_set_exit_hook(enable ? workq_softirq_hook : NULL);
+}
+
+uint32_t workq_dropped(void) {
+    return dropped;
+}
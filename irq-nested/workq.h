@@ -0,0 +1,36 @@
+#ifndef WORKQ_H
+#define WORKQ_H
+
+#include <stdint.h>
+
+// Deferred work queue (bottom half)
+//
+// Interrupt handlers post small work items with workq_post() and return
+// at once. The items are executed later with CPU IRQ enabled, either by
+// workq_run() called from the idle loop or by the soft-IRQ which runs
+// on the way out of _irq_handler_stub when the outermost handler returns.
+//
+// workq_post() is lock-free and can be called from any context and any
+// priority level. Only one context drains the queue at a time.
+
+// queue length, must be a power of 2
+#define WORKQ_LEN  64
+
+typedef void (*work_fn_t)(void *arg, uint32_t data);
+
+void workq_init(void);
+
+// returns 0 on success, -1 if the queue is full (the item is dropped)
+int workq_post(work_fn_t fn, void *arg, uint32_t data);
+
+// execute all the posted items, returns the number of items executed.
+// returns 0 if another context is draining the queue.
+int workq_run(void);
+
+// enable/disable draining the queue on interrupt exit
+void workq_softirq(int enable);
+
+// number of items dropped because the queue was full
+uint32_t workq_dropped(void);
+
+#endif
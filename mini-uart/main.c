@@ -2,117 +2,13 @@
 #include <stdio.h>
 #include <string.h>
 
-#define IOREG(X)  (*(volatile uint32_t *) (X))
-
-// GPIO registers
-#define GPFSEL0 IOREG(0x20200000)
-#define GPFSEL1 IOREG(0x20200004)
-#define GPFSEL2 IOREG(0x20200008)
-#define GPFSEL3 IOREG(0x2020000C)
-#define GPFSEL4 IOREG(0x20200010)
-#define GPFSEL5 IOREG(0x20200014)
-
-#define GPF_INPUT  0U
-#define GPF_OUTPUT 1U
-#define GPF_ALT_0  4U
-#define GPF_ALT_1  5U
-#define GPF_ALT_2  6U
-#define GPF_ALT_3  7U
-#define GPF_ALT_4  3U
-#define GPF_ALT_5  2U
-
-// Mini UART registers
-#define AUX_IRQ     IOREG(0x20215000)
-#define AUX_ENABLES IOREG(0x20215004)
-
-#define MU_IO   IOREG(0x20215040)
-#define MU_IER  IOREG(0x20215044)
-#define MU_IIR  IOREG(0x20215048)
-#define MU_LCR  IOREG(0x2021504C)
-#define MU_MCR  IOREG(0x20215050)
-#define MU_LSR  IOREG(0x20215054)
-#define MU_MSR  IOREG(0x20215058)
-#define MU_SCRATCH  IOREG(0x2021505C)
-#define MU_CNTL IOREG(0x20215060)
-#define MU_STAT IOREG(0x20215064)
-#define MU_BAUD IOREG(0x20215068)
-
-#define MU_LSR_TX_IDLE  (1U << 6)
-#define MU_LSR_TX_EMPTY (1U << 5)
-#define MU_LSR_RX_RDY   (1U)
-
-// System timer counter
-#define SYST_CLO IOREG(0x20003004)
-#define SYST_CHI IOREG(0x20003008)
-
-extern uint32_t __bss_start, __bss_end;
-
-__attribute__((naked)) __attribute__((section(".startup"))) \
-void Init_Machine(void) {
-  // set CPSR
-  __asm volatile("ldr r0, =0x000000d3");
-  __asm volatile("msr cpsr, r0");
-  // set stack pointer
-  __asm volatile("ldr sp, =0x06400000");
-  // zero out .bss section
-  for (uint32_t *dest = &__bss_start; dest < &__bss_end;) {
-    *dest++ = 0;
-  }
-  __asm volatile("bl _start");
-  __asm volatile("b .");
-}
-
-volatile uint64_t systime(void) {
-  uint64_t t;
-  uint32_t chi;
-  uint32_t clo;
-
-  chi = SYST_CHI;
-  clo = SYST_CLO;
-  if (chi != SYST_CHI) {
-    chi = SYST_CHI;
-    clo = SYST_CLO;
-  }
-  t = chi;
-  t = t << 32;
-  t += clo;
-  return t;
-}
-
-void delay_ms(uint32_t duration){
-  uint64_t end_time;
-
-  end_time = systime() + duration * 1000;
-  while(systime() < end_time);
-  
-  return;
-}
-
-void uart_putchar(unsigned char c) {
-    while (!(MU_LSR & MU_LSR_TX_IDLE) && !(MU_LSR & MU_LSR_TX_EMPTY));
-    MU_IO = 0xffU & c;
-}
+#include "bsp.h"
 
 int main(int argc, char **argv) {
   const char msg[] = "Echo back test.\012\015";
   const int msglen = 17;
   
-  // set GPIO14, GPIO15 to pull down, alternate function 0
-  GPFSEL1 = (GPF_ALT_5 << (3*4)) | (GPF_ALT_5 << (3*5));
-
-  // UART basic settings
-  AUX_ENABLES = 1;
-  MU_CNTL = 0;   // mini uart disable
-  MU_IER = 0;    // disable receive/transmit interrupts
-  MU_IIR = 0xC6; // enable FIFO(0xC0), clear FIFO(0x06)
-  MU_MCR = 0;    // set RTS to High
-
-  // data and speed (mini uart is always parity none, 1 start bit 1 stop bit)
-  MU_LCR = 3;    // 8 bits
-  MU_BAUD = 270; // 1115200 bps
-
-  // enable transmit and receive
-  MU_CNTL = 3;
+  uart_init(UART_BAUD);
 
   // type message
   for(int i = 0; i < msglen; i++) {
@@ -124,9 +20,7 @@ int main(int argc, char **argv) {
 
   // echo back
   while (1) {
-    uint32_t c;
-    while (!(MU_LSR & MU_LSR_RX_RDY));
-    c = MU_IO;
+    uint32_t c = uart_getc();
     if (c) {
       uart_putchar(c);
       if (c == 0x0D)
@@ -136,16 +30,3 @@ int main(int argc, char **argv) {
 
   return 0;
 }
-
-void _start(void) {
-  // when we get here: stack is initialised, bss is clear, data is copied
-
-  // initialise the cpu and peripherals
-
-  // now that we have a basic system up and running we can call main
-  main(0, NULL);
-
-  // we must not return
-  for (;;) {
-  }
-}
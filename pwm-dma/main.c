@@ -0,0 +1,84 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bsp.h"
+#include "pwm.h"
+
+#define SAMPLE_RATE 48000
+#define RANGE       1024
+
+// fixed waveform: 500Hz triangle on channel 1, 1kHz sawtooth on channel 2
+#define WAVE_LEN    96
+static uint32_t wave[WAVE_LEN * 2] __attribute__((aligned(32)));
+
+// streaming ring
+#define RING_LEN    2048
+static uint32_t ring[RING_LEN] __attribute__((aligned(32)));
+
+int main(int argc, char **argv) {
+  pwm_t* pwm = (pwm_t*) (PWM);
+
+  uart_init(UART_BAUD);
+  uart_print("\r\nPWM DMA test. Output is on GPIO18 and GPIO19.\r\n");
+
+  uint32_t rate = pwm_set_sample_rate(pwm, SAMPLE_RATE, RANGE);
+  uart_print("sample rate ");
+  uart_put_dec(rate);
+  uart_print("Hz\r\n");
+  pwm_config(pwm, PWM_CH1, RANGE, 1);
+  pwm_config(pwm, PWM_CH2, RANGE, 1);
+
+  for (int i = 0; i < WAVE_LEN; i++) {
+      uint32_t tri = (i < WAVE_LEN / 2) ? i * 2 * RANGE / WAVE_LEN
+                                        : (WAVE_LEN - i) * 2 * RANGE / WAVE_LEN;
+      uint32_t saw = (i % (WAVE_LEN / 2)) * 2 * RANGE / WAVE_LEN;
+      wave[i * 2] = tri;
+      wave[i * 2 + 1] = saw;
+  }
+  pwm_start(pwm, wave, WAVE_LEN * 2);
+
+  // the waveform plays while the CPU does nothing with PWM
+  uart_print("playing the fixed waveform for 5 seconds\r\n");
+  delay_ms(5000);
+  pwm_stop(pwm);
+
+  // stream a sawtooth sweeping from 100Hz to 2kHz on both channels,
+  // channel 2 an octave higher
+  uart_print("streaming a sweep\r\n");
+  for (int i = 0; i < RING_LEN; i++) {
+      ring[i] = RANGE / 2;
+  }
+  pwm_start(pwm, ring, RING_LEN);
+
+  uint32_t phase = 0;
+  uint32_t freq = 100;
+  uint32_t samples = 0;
+  uint32_t idle = 0;
+  uint32_t start = SYST_CLO;
+  while (1) {
+      if (pwm_writable(pwm) >= 2) {
+          // 32-bit phase accumulator
+          uint32_t data[2];
+          phase += (uint32_t) (((uint64_t) freq << 32) / rate);
+          data[0] = (uint32_t) (((uint64_t) phase * RANGE) >> 32);
+          data[1] = (uint32_t) (((uint64_t) (phase << 1) * RANGE) >> 32);
+          pwm_write(pwm, data, 2);
+          if (++samples == rate / 10) {
+              samples = 0;
+              freq = (freq >= 2000) ? 100 : freq + 100;
+          }
+      } else {
+          idle++;
+      }
+      if (SYST_CLO - start >= 1000000) {
+          uart_print(" freq ");
+          uart_put_dec(freq);
+          uart_print("Hz, idle loops ");
+          uart_put_dec(idle);
+          uart_print("\r\n");
+          idle = 0;
+          start = SYST_CLO;
+      }
+  }
+  return 0;
+}
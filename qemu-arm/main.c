@@ -64,7 +64,9 @@ void uart_print(const char *s) {
 
 extern uint32_t __bss_start, __bss_end;
 
-__attribute__((naked)) __attribute__((section(".startup"))) \
+// used: no code refers to it, KEEP(*(.startup)) of the linker script
+// places it at the load address
+__attribute__((used)) __attribute__((naked)) __attribute__((section(".startup"))) \
 void Init_Machine(void) {
   // set CPSR
   __asm volatile("ldr r0, =0x000000d3");
@@ -98,7 +100,8 @@ int main(int argc, char **argv) {
   return 0;
 }
 
-void _start(void) {
+// called from Init_Machine only, keep it with LTO
+__attribute__((used)) void _start(void) {
   // when we get here: stack is initialised, bss is clear, data is copied
 
   // initialise the cpu and peripherals
@@ -0,0 +1,142 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "atomic.h"
+#include "acq.h"
+
+// one outstanding batch for each I2C bus
+typedef struct _acq_job_t {
+    i2c_bus_t *bus;
+    i2c_batch_t batch;
+    i2c_reg_block_t blocks[ACQ_MAX_ENTRIES];
+    acq_entry_t *entry[ACQ_MAX_ENTRIES];
+} acq_job_t;
+
+static acq_entry_t *entries[ACQ_MAX_ENTRIES];
+static uint32_t num_entries;
+static acq_job_t jobs[2];
+static spi_t *spi_bus;
+
+static inline acq_sample_t *back_slot(acq_entry_t *e) {
+    return &e->slot[(e->seq + 1) & 1];
+}
+
+static void publish(acq_entry_t *e, int status, uint64_t time) {
+    acq_sample_t *s = back_slot(e);
+    s->time = time;
+    s->status = status;
+    dmb();
+    e->seq++;
+}
+
+static void job_done(i2c_batch_t *batch) {
+    acq_job_t *job = batch->arg;
+    uint64_t now = systime();
+
+    for (uint32_t i = 0; i < batch->count; i++) {
+        acq_entry_t *e = job->entry[i];
+        publish(e, job->blocks[i].xfer.status, now);
+        e->busy = 0;
+    }
+}
+
+void acq_init(i2c_bus_t *i2c0, i2c_bus_t *i2c1, spi_t *spi) {
+    num_entries = 0;
+    jobs[0].bus = i2c0;
+    jobs[1].bus = i2c1;
+    for (int i = 0; i < 2; i++) {
+        jobs[i].batch.blocks = jobs[i].blocks;
+        jobs[i].batch.count = 0;
+        jobs[i].batch.callback = job_done;
+        jobs[i].batch.arg = &jobs[i];
+        jobs[i].batch.remaining = 0;
+    }
+    spi_bus = spi;
+}
+
+int acq_add(acq_entry_t *e) {
+    if ((num_entries >= ACQ_MAX_ENTRIES)
+        || (e->bus < 0) || (e->bus >= ACQ_NUM_BUS)
+        || (e->len == 0) || (e->len > ACQ_MAX_LEN) || (e->period == 0)) {
+        return -1;
+    }
+    e->next = systime();
+    e->busy = 0;
+    e->seq = 0;
+    e->missed = 0;
+    entries[num_entries++] = e;
+    return 0;
+}
+
+void acq_poll(void) {
+    uint64_t now = systime();
+    int free[2];
+
+    for (int i = 0; i < 2; i++) {
+        free[i] = (jobs[i].bus != NULL) && (jobs[i].batch.remaining == 0);
+        if (free[i]) {
+            jobs[i].batch.count = 0;
+        }
+    }
+
+    for (uint32_t i = 0; i < num_entries; i++) {
+        acq_entry_t *e = entries[i];
+        if (now < e->next) {
+            continue;
+        }
+        if (e->busy) {
+            // previous read is not completed yet
+            e->missed++;
+            e->next += e->period;
+            continue;
+        }
+        if (now >= e->next + e->period) {
+            // skip the whole periods which have passed
+            uint32_t late = (uint32_t) (now - e->next) / e->period;
+            e->missed += late;
+            e->next += (uint64_t) late * e->period;
+        }
+
+        if (e->bus == ACQ_BUS_SPI0) {
+            if (spi_bus) {
+                acq_sample_t *s = back_slot(e);
+                spi_read_reg(spi_bus, e->dev, e->reg, s->data, e->len);
+                publish(e, I2C_OK, systime());
+            }
+            e->next += e->period;
+        } else if (free[e->bus]) {
+            acq_job_t *job = &jobs[e->bus];
+            uint32_t n = job->batch.count++;
+            job->blocks[n].addr = e->dev;
+            job->blocks[n].reg = e->reg;
+            job->blocks[n].buf = back_slot(e)->data;
+            job->blocks[n].len = e->len;
+            job->entry[n] = e;
+            e->busy = 1;
+            e->next += e->period;
+        }
+        // else: the bus is still busy, retry on the next poll
+    }
+
+    for (int i = 0; i < 2; i++) {
+        if (free[i] && (jobs[i].batch.count != 0)) {
+            i2c_read_blocks(jobs[i].bus, &jobs[i].batch);
+        }
+    }
+}
+
+uint32_t acq_read(acq_entry_t *e, acq_sample_t *sample) {
+    uint32_t seq;
+    do {
+        seq = e->seq;
+        dmb();
+        const acq_sample_t *s = &e->slot[seq & 1];
+        sample->time = s->time;
+        sample->status = s->status;
+        for (int i = 0; i < e->len; i++) {
+            sample->data[i] = s->data[i];
+        }
+        dmb();
+        // retry if the slot has been rewritten while it was copied
+    } while (seq != e->seq);
+    return seq;
+}
@@ -0,0 +1,66 @@
+#ifndef ACQ_H
+#define ACQ_H
+
+#include <stdint.h>
+#include "bsp.h"
+#include "i2c.h"
+#include "spi.h"
+
+// Periodic sensor acquisition scheduler
+//
+// Each entry reads a register block of a device on a bus at its own
+// period. acq_poll() is called from a periodic timer interrupt; the due
+// entries of each I2C bus are queued as one batch (i2c_read_blocks()),
+// those of the SPI bus are read at once by polling.
+//
+// Each entry has two sample slots. The scheduler writes the slot which
+// is not the latest one and then publishes it by incrementing seq, so
+// acq_read() always returns a consistent sample without disabling IRQ.
+//
+// An entry misses its deadline if it is still being read when it is due
+// again, or if its bus is busy for a whole period.
+
+#define ACQ_BUS_I2C0  0
+#define ACQ_BUS_I2C1  1
+#define ACQ_BUS_SPI0  2
+#define ACQ_NUM_BUS   3
+
+#define ACQ_MAX_ENTRIES 32
+#define ACQ_MAX_LEN     16
+
+typedef struct _acq_sample_t {
+    uint64_t time;              // systime() when the read completed
+    int status;                 // I2C_OK or I2C_ERR_*
+    uint8_t data[ACQ_MAX_LEN];
+} acq_sample_t;
+
+typedef struct _acq_entry_t {
+    // set by the user
+    const char *name;
+    int bus;                    // ACQ_BUS_*
+    uint8_t dev;                // I2C slave address or SPI chip select
+    uint8_t reg;                // first register (with the read bit for SPI)
+    uint8_t len;                // up to ACQ_MAX_LEN
+    uint32_t period;            // usec
+
+    // owned by the scheduler
+    uint64_t next;              // next deadline
+    volatile uint32_t busy;     // queued in an I2C batch
+    volatile uint32_t seq;      // number of samples, slot[seq & 1] is the latest
+    volatile uint32_t missed;   // number of missed deadlines
+    acq_sample_t slot[2];
+} acq_entry_t;
+
+// any bus can be NULL if it is not used
+void acq_init(i2c_bus_t *i2c0, i2c_bus_t *i2c1, spi_t *spi);
+
+// returns -1 if the table is full or the entry is not valid
+int acq_add(acq_entry_t *entry);
+
+// call periodically, e.g. from a 1ms timer interrupt
+void acq_poll(void);
+
+// copy the latest sample, returns its sequence number (0: no sample yet)
+uint32_t acq_read(acq_entry_t *entry, acq_sample_t *sample);
+
+#endif
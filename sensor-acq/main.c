@@ -0,0 +1,165 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bsp.h"
+#include "acq.h"
+
+// ldr pc, [pc, #24]
+#define	JMP_PC_24	0xe59ff018
+
+typedef void (*exception_hander_t)(void);
+
+typedef struct __attribute__((aligned(32))) _vector_table_t {
+    const unsigned int vector[8]; // all elements shoud be JMP_PC_24
+    exception_hander_t reset;
+    exception_hander_t undef;
+    exception_hander_t svc;
+    exception_hander_t prefetch_abort;
+    exception_hander_t data_abort;
+    exception_hander_t hypervisor_trap;
+    exception_hander_t irq;
+    exception_hander_t fiq;
+} vector_table_t;
+
+static void __attribute__((interrupt("IRQ"))) irq_handler(void);
+static void __attribute__((naked)) hangup(void);
+
+static vector_table_t exception_vector = { \
+    .vector = { JMP_PC_24, JMP_PC_24, JMP_PC_24, JMP_PC_24, \
+                JMP_PC_24, JMP_PC_24, JMP_PC_24, JMP_PC_24 },
+    .reset = Init_Machine,
+    .undef = hangup,
+    .svc = hangup,
+    .prefetch_abort = hangup,
+    .data_abort = hangup,
+    .hypervisor_trap = hangup,
+    .irq = irq_handler,
+    .fiq = hangup
+};
+
+void set_vbar(vector_table_t *base) {
+    __asm volatile ("mcr p15, 0, %[base], c12, c0, 0"
+                    :: [base] "r" (base));
+}
+
+#define IRQ_BASIC         IOREG(0x2000B200)
+#define IRQ_PEND1         IOREG(0x2000B204)
+#define IRQ_PEND2         IOREG(0x2000B208)
+#define IRQ_ENABLE1       IOREG(0x2000B210)
+#define IRQ_ENABLE2       IOREG(0x2000B214)
+#define IRQ_DISABLE_BASIC IOREG(0x2000B224)
+
+#define SYST_CS_M1  (1 << 1)
+
+#define IRQ_TIMER_C1  (1 << 1)
+// I2C interrupt is IRQ 53 (shared by BSC0, BSC1 and BSC2)
+#define IRQ_I2C  (1 << (53 - 32))
+
+// period of the acquisition scheduler in usec
+#define ACQ_TICK  1000
+
+static i2c_bus_t bus0;
+static i2c_bus_t bus1;
+
+static void __attribute__((interrupt("IRQ"))) irq_handler(void) {
+    if (IRQ_PEND2 & IRQ_I2C) {
+        i2c_isr(&bus0);
+        i2c_isr(&bus1);
+    }
+    if (IRQ_PEND1 & IRQ_TIMER_C1) {
+        SYST_C1 = SYST_C1 + ACQ_TICK;
+        SYST_CS = SYST_CS_M1;
+        acq_poll();
+    }
+}
+
+static void __attribute__((naked)) hangup(void) {
+  while(1) {
+  }
+}
+
+// sensors to acquire
+static acq_entry_t sensors[] = {
+    // ID EEPROM of a HAT
+    { .name = "eeprom ", .bus = ACQ_BUS_I2C0, .dev = 0x50, .reg = 0x00,
+      .len = 4, .period = 1000000 },
+    // TMP102 temperature
+    { .name = "tmp102 ", .bus = ACQ_BUS_I2C1, .dev = 0x48, .reg = 0x00,
+      .len = 2, .period = 100000 },
+    // BME280 pressure, temperature and humidity
+    { .name = "bme280 ", .bus = ACQ_BUS_I2C1, .dev = 0x76, .reg = 0xf7,
+      .len = 8, .period = 50000 },
+    // MPU-6050 accelerometer
+    { .name = "mpu6050", .bus = ACQ_BUS_I2C1, .dev = 0x68, .reg = 0x3b,
+      .len = 6, .period = 10000 },
+    // ADXL345 accelerometer on CE0 (read, multiple byte, DATAX0)
+    { .name = "adxl345", .bus = ACQ_BUS_SPI0, .dev = 0, .reg = 0xc0 | 0x32,
+      .len = 6, .period = 5000 },
+};
+
+#define NUM_SENSORS (sizeof(sensors) / sizeof(sensors[0]))
+
+int main(int argc, char **argv) {
+  const char msg[] = "\r\nSensor acquisition scheduler test.\r\n";
+
+  // disable IRQ
+  IRQ_DISABLE_BASIC = 1;
+
+  uart_init(UART_BAUD);
+
+  uart_print(msg);
+
+  i2c_init(&bus0, 0);
+  i2c_set_clock_speed(&bus0, I2C_STANDARD);
+  i2c_init(&bus1, 1);
+  i2c_set_clock_speed(&bus1, I2C_FAST);
+  spi_init((spi_t *) SPI0, 1, 1, 50);   // mode 3, 5MHz
+
+  acq_init(&bus0, &bus1, (spi_t *) SPI0);
+  for (int i = 0; i < NUM_SENSORS; i++) {
+    acq_add(&sensors[i]);
+  }
+
+  // enable IRQ
+  set_vbar(&exception_vector);
+  SYST_C1 = SYST_CLO + ACQ_TICK;
+  SYST_CS = SYST_CS_M1;
+  IRQ_ENABLE1 = IRQ_TIMER_C1;
+  IRQ_ENABLE2 = IRQ_I2C;
+  __asm volatile("cpsie i");
+
+  while (1) {
+    delay_ms(1000);
+
+    // print the latest sample of each sensor
+    uart_print("\r\nname    samples missed age(us) data\r\n");
+    for (int i = 0; i < NUM_SENSORS; i++) {
+      acq_entry_t *e = &sensors[i];
+      acq_sample_t s;
+      uint32_t seq = acq_read(e, &s);
+
+      uart_print(e->name);
+      uart_putchar(' ');
+      uart_put_dec(seq);
+      uart_putchar(' ');
+      uart_put_dec(e->missed);
+      uart_putchar(' ');
+      if (seq == 0) {
+        uart_print("-\r\n");
+        continue;
+      }
+      uart_put_dec((uint32_t) (systime() - s.time));
+      if (s.status != I2C_OK) {
+        uart_print(" error\r\n");
+        continue;
+      }
+      for (int j = 0; j < e->len; j++) {
+        uart_putchar(' ');
+        uart_put_hex(s.data[j]);
+      }
+      uart_print("\r\n");
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,39 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bsp.h"
+#include "servo.h"
+
+#define NUM_SERVOS 16
+
+// GPIO4-27 except the pins of UART (14, 15) and PWM0 (18)
+static const uint32_t servo_gpio[NUM_SERVOS] = {
+    4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 16, 17, 19, 20, 21, 22
+};
+
+int main(int argc, char **argv) {
+  int id[NUM_SERVOS];
+
+  uart_init(UART_BAUD);
+  uart_print("\r\nServo test. 16 servos on GPIO4-22.\r\n");
+
+  servo_init();
+  for (int i = 0; i < NUM_SERVOS; i++) {
+      id[i] = servo_add(servo_gpio[i], 1500);
+  }
+
+  int toggle = 0;
+  while(1) {
+      // sweep the servos between 0.6ms and 2.4ms in a wave
+      if (servo_idle()) {
+          toggle ^= 1;
+          for (int i = 0; i < NUM_SERVOS; i++) {
+              servo_move(id[i], toggle ? 2400 : 600, 1000 + i * 100);
+          }
+          uart_print(toggle ? "-> 2.4ms\r\n" : "-> 0.6ms\r\n");
+      }
+      servo_update();
+      delay_ms(5);
+  }
+  return 0;
+}
@@ -0,0 +1,191 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "servo.h"
+#include "pwm.h"
+#include "dma.h"
+
+// DMA channel for the chain
+#define SERVO_DMA  5
+
+// GPSET, then (pacing, GPCLR) for each pulse end, then the last pacing
+#define CHAIN_CBS  (1 + SERVO_MAX * 2 + 1)
+
+typedef struct _chain_t {
+    dma_cb_t cb[CHAIN_CBS];
+    uint32_t mask[SERVO_MAX + 1];   // mask[0] for GPSET, others for GPCLR
+    uint32_t num_cbs;
+} chain_t;
+
+static chain_t chains[2] __attribute__((aligned(32)));
+static int active;                  // chain running, or about to run
+static int switching;               // waiting for the DMA to enter chains[active]
+static uint32_t pacing_word;
+
+static servo_t servos[SERVO_MAX];
+static uint32_t num_servos;
+
+static void cb_write(dma_cb_t *cb, uint32_t *src, volatile uint32_t *reg) {
+    cb->ti = DMA_TI_NO_WIDE | DMA_TI_WAIT_RESP;
+    cb->source_ad = BUS_ADDR(src);
+    cb->dest_ad = PERI_ADDR(reg);
+    cb->txfr_len = 4;
+    cb->stride = 0;
+}
+
+static void cb_pace(dma_cb_t *cb, uint32_t usec) {
+    pwm_t *pwm = (pwm_t *) PWM;
+
+    cb->ti = DMA_TI_NO_WIDE | DMA_TI_PERMAP(DREQ_PWM) | DMA_TI_DEST_DREQ
+        | DMA_TI_WAIT_RESP;
+    cb->source_ad = BUS_ADDR(&pacing_word);
+    cb->dest_ad = PERI_ADDR(&pwm->FIF1);
+    cb->txfr_len = usec * 4;
+    cb->stride = 0;
+}
+
+// build the chain for the current widths, looping to itself
+static void build(chain_t *c) {
+    uint32_t order[SERVO_MAX];
+    uint32_t n = 0;
+
+    // sort by width (insertion sort of at most 16)
+    for (uint32_t i = 0; i < num_servos; i++) {
+        uint32_t j = n++;
+        while ((j > 0) && (servos[order[j - 1]].width > servos[i].width)) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    uint32_t k = 0;
+    uint32_t m = 0;
+    c->mask[m] = 0;
+    for (uint32_t i = 0; i < num_servos; i++) {
+        c->mask[m] |= 1U << servos[i].gpio;
+    }
+    cb_write(&c->cb[k++], &c->mask[m++], &GPSET0);
+
+    uint32_t t = 0;
+    for (uint32_t i = 0; i < n; ) {
+        uint32_t w = servos[order[i]].width;
+        // servos with the same width end at the same time
+        c->mask[m] = 0;
+        while ((i < n) && (servos[order[i]].width == w)) {
+            c->mask[m] |= 1U << servos[order[i]].gpio;
+            i++;
+        }
+        cb_pace(&c->cb[k++], w - t);
+        cb_write(&c->cb[k++], &c->mask[m++], &GPCLR0);
+        t = w;
+    }
+    cb_pace(&c->cb[k++], SERVO_PERIOD_US - t);
+
+    for (uint32_t i = 0; i < k - 1; i++) {
+        c->cb[i].nextconbk = BUS_ADDR(&c->cb[i + 1]);
+    }
+    c->cb[k - 1].nextconbk = BUS_ADDR(&c->cb[0]);
+    c->num_cbs = k;
+}
+
+static int dma_in_chain(chain_t *c) {
+    uint32_t ad = DMA_CH(SERVO_DMA)->CONBLK_AD;
+    return (ad >= BUS_ADDR(&c->cb[0])) && (ad < BUS_ADDR(&c->cb[CHAIN_CBS]));
+}
+
+void servo_init(void) {
+    pwm_t *pwm = (pwm_t *) PWM;
+
+    num_servos = 0;
+    pacing_word = 0;
+
+    // 500MHz / 50 = 10MHz, 10 clocks per FIFO word = 1us.
+    // the PWM output is not connected to any pin.
+    init_pwm(pwm, CM_PWMCTL_SRC_PLLD, 50);
+    pwm->CTL = 0;
+    pwm->RNG1 = 10;
+    pwm->CTL = CTL_CLRF1;
+    pwm->STA = STA_BERR | STA_GAPO1 | STA_RERR1 | STA_WERR1;
+    pwm->CTL = CTL_USEF1 | CTL_PWEN1;
+    pwm->DMAC = DMAC_ENAB | (15 << 8) | 1;
+
+    active = 0;
+    switching = 0;
+    build(&chains[0]);
+    dma_init(SERVO_DMA);
+    dma_start(SERVO_DMA, &chains[0].cb[0]);
+}
+
+int servo_add(uint32_t gpio, uint32_t width) {
+    if ((num_servos >= SERVO_MAX) || (gpio > 31)) {
+        return -1;
+    }
+    width = (width < SERVO_MIN_US) ? SERVO_MIN_US : width;
+    width = (width > SERVO_MAX_US) ? SERVO_MAX_US : width;
+
+    // GPFSELn registers are 4 bytes apart
+    volatile uint32_t *fsel = &GPFSEL0 + gpio / 10;
+    uint32_t shift = (gpio % 10) * 3;
+    *fsel = (*fsel & ~(7U << shift)) | (GPF_OUTPUT << shift);
+
+    servo_t *s = &servos[num_servos];
+    s->gpio = gpio;
+    s->width = width;
+    s->start_width = width;
+    s->target = width;
+    s->start_time = SYST_CLO;
+    s->duration = 0;
+    return num_servos++;
+}
+
+void servo_move(int id, uint32_t width, uint32_t duration) {
+    servo_t *s = &servos[id];
+
+    width = (width < SERVO_MIN_US) ? SERVO_MIN_US : width;
+    width = (width > SERVO_MAX_US) ? SERVO_MAX_US : width;
+    s->start_width = s->width;
+    s->target = width;
+    s->start_time = SYST_CLO;
+    s->duration = duration * 1000;
+}
+
+int servo_update(void) {
+    if (switching) {
+        if (!dma_in_chain(&chains[active])) {
+            // the previous chain is still running
+            return 0;
+        }
+        switching = 0;
+    }
+
+    uint32_t now = SYST_CLO;
+    for (uint32_t i = 0; i < num_servos; i++) {
+        servo_t *s = &servos[i];
+        uint32_t elapsed = now - s->start_time;
+        if (elapsed >= s->duration) {
+            s->width = s->target;
+        } else {
+            int32_t delta = (int32_t) s->target - (int32_t) s->start_width;
+            s->width = s->start_width
+                + (int32_t) ((int64_t) delta * elapsed / s->duration);
+        }
+    }
+
+    // build the idle chain and link the end of the running one to it
+    chain_t *old = &chains[active];
+    chain_t *new = &chains[active ^ 1];
+    build(new);
+    old->cb[old->num_cbs - 1].nextconbk = BUS_ADDR(&new->cb[0]);
+    active ^= 1;
+    switching = 1;
+    return 1;
+}
+
+int servo_idle(void) {
+    for (uint32_t i = 0; i < num_servos; i++) {
+        if (servos[i].width != servos[i].target) {
+            return 0;
+        }
+    }
+    return 1;
+}
@@ -0,0 +1,48 @@
+#ifndef SERVO_H
+#define SERVO_H
+
+#include <stdint.h>
+
+// Multi-servo pulse generator
+//
+// Up to SERVO_MAX servos on any of GPIO0-31. A chain of DMA control
+// blocks writes GPSET0 to start the pulses of all the servos, then
+// GPCLR0 to end each pulse. The time between the writes is made by
+// DMA blocks which write N words to the PWM FIFO; the PWM consumes one
+// word per microsecond, so the DREQ paces the chain with 1us resolution
+// and no CPU. The chain loops every SERVO_PERIOD_US.
+//
+// servo_update() moves the servos toward their targets by linear
+// interpolation and switches the DMA to a new chain at the end of the
+// current period.
+
+#define SERVO_MAX        16
+#define SERVO_PERIOD_US  20000     // 50Hz
+#define SERVO_MIN_US     500
+#define SERVO_MAX_US     2500
+
+typedef struct _servo_t {
+    uint32_t gpio;
+    uint32_t width;             // current pulse width (us)
+    uint32_t start_width;       // interpolation from start_width
+    uint32_t target;            // to target
+    uint32_t start_time;        // in usec of systime
+    uint32_t duration;
+} servo_t;
+
+void servo_init(void);
+
+// returns the servo number, -1 if no room
+int servo_add(uint32_t gpio, uint32_t width);
+
+// move to width (us) in duration (ms), 0 to jump
+void servo_move(int id, uint32_t width, uint32_t duration);
+
+// call from the main loop, at least once a period. returns 1 if a new
+// chain has been queued
+int servo_update(void);
+
+// returns 1 if all the servos reached their targets
+int servo_idle(void);
+
+#endif
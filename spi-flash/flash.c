@@ -0,0 +1,202 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "flash.h"
+
+// commands
+#define CMD_WREN       0x06
+#define CMD_RDSR       0x05
+#define CMD_READ_FAST  0x0B
+#define CMD_PP         0x02
+#define CMD_SE         0x20
+#define CMD_RDID       0x9F
+
+#define SR_WIP   (1<<0)
+
+static void command(flash_t *flash, uint8_t cmd, uint32_t addr, int with_addr) {
+    uint8_t hdr[4];
+
+    hdr[0] = cmd;
+    hdr[1] = addr >> 16;
+    hdr[2] = addr >> 8;
+    hdr[3] = addr;
+    spi_chip_select(flash->spi, flash->cs);
+    spi_begin(flash->spi);
+    spi_xfer(flash->spi, hdr, NULL, with_addr ? 4 : 1);
+}
+
+static uint8_t read_status(flash_t *flash) {
+    uint8_t sr;
+
+    command(flash, CMD_RDSR, 0, 0);
+    spi_xfer(flash->spi, NULL, &sr, 1);
+    spi_end(flash->spi);
+    return sr;
+}
+
+static void write_enable(flash_t *flash) {
+    command(flash, CMD_WREN, 0, 0);
+    spi_end(flash->spi);
+}
+
+static void wait_ready(flash_t *flash) {
+    while (read_status(flash) & SR_WIP);
+}
+
+// wait for the running erase, if any. if the area overlaps a queued
+// sector, wait for all the queued erases so that the area is erased
+// before it is accessed.
+static void wait_erase(flash_t *flash, uint32_t addr, uint32_t len) {
+    for (uint32_t i = flash->erase_tail; i != flash->erase_head; i++) {
+        uint32_t sector = flash->erase_queue[i % FLASH_ERASE_QUEUE];
+        if ((addr < sector + FLASH_SECTOR_SIZE) && (sector < addr + len)) {
+            flash_sync(flash);
+            return;
+        }
+    }
+    if (flash->erasing) {
+        wait_ready(flash);
+        flash->erasing = 0;
+        flash->erase_tail++;
+    }
+}
+
+static void invalidate(flash_t *flash, uint32_t addr, uint32_t len) {
+    uint32_t first = addr / FLASH_CACHE_LINE;
+    uint32_t last = (addr + len - 1) / FLASH_CACHE_LINE;
+
+    for (int i = 0; i < FLASH_CACHE_LINES; i++) {
+        flash_cache_line_t *l = &flash->cache[i];
+        if (l->last_use && (l->tag >= first) && (l->tag <= last)) {
+            l->last_use = 0;
+        }
+    }
+}
+
+int flash_init(flash_t *flash, spi_t *spi, int cs, uint32_t clk) {
+    flash->spi = spi;
+    flash->cs = cs;
+    flash->erasing = 0;
+    flash->erase_head = 0;
+    flash->erase_tail = 0;
+    flash->use_count = 0;
+    flash->hits = 0;
+    flash->misses = 0;
+    for (int i = 0; i < FLASH_CACHE_LINES; i++) {
+        flash->cache[i].last_use = 0;
+    }
+
+    spi_init(spi, 0, 0, clk);
+    command(flash, CMD_RDID, 0, 0);
+    spi_xfer(spi, NULL, flash->id, 3);
+    spi_end(spi);
+
+    // capacity byte is log2 of the size on most JEDEC parts
+    if ((flash->id[0] == 0x00) || (flash->id[0] == 0xff)
+        || (flash->id[2] < 16) || (flash->id[2] > 24)) {
+        flash->size = 0;
+        return -1;
+    }
+    flash->size = 1U << flash->id[2];
+    return 0;
+}
+
+void flash_read(flash_t *flash, uint32_t addr, uint8_t *buf, uint32_t len) {
+    uint8_t dummy = 0;
+
+    wait_erase(flash, addr, len);
+    command(flash, CMD_READ_FAST, addr, 1);
+    spi_xfer(flash->spi, &dummy, NULL, 1);
+    spi_xfer(flash->spi, NULL, buf, len);
+    spi_end(flash->spi);
+}
+
+static flash_cache_line_t *lookup(flash_t *flash, uint32_t tag) {
+    flash_cache_line_t *victim = &flash->cache[0];
+
+    for (int i = 0; i < FLASH_CACHE_LINES; i++) {
+        flash_cache_line_t *l = &flash->cache[i];
+        if (l->last_use && (l->tag == tag)) {
+            flash->hits++;
+            l->last_use = ++flash->use_count;
+            return l;
+        }
+        if (l->last_use < victim->last_use) {
+            victim = l;
+        }
+    }
+    // replace the least recently used line
+    flash->misses++;
+    flash_read(flash, tag * FLASH_CACHE_LINE, victim->data, FLASH_CACHE_LINE);
+    victim->tag = tag;
+    victim->last_use = ++flash->use_count;
+    return victim;
+}
+
+void flash_read_cached(flash_t *flash, uint32_t addr, uint8_t *buf, uint32_t len) {
+    while (len > 0) {
+        flash_cache_line_t *l = lookup(flash, addr / FLASH_CACHE_LINE);
+        uint32_t offset = addr % FLASH_CACHE_LINE;
+        uint32_t n = FLASH_CACHE_LINE - offset;
+        n = (n > len) ? len : n;
+        for (uint32_t i = 0; i < n; i++) {
+            *buf++ = l->data[offset + i];
+        }
+        addr += n;
+        len -= n;
+    }
+}
+
+void flash_program(flash_t *flash, uint32_t addr, const uint8_t *data, uint32_t len) {
+    if (len == 0) {
+        return;
+    }
+    wait_erase(flash, addr, len);
+    invalidate(flash, addr, len);
+    while (len > 0) {
+        // one PAGE PROGRAM up to the end of the page
+        uint32_t n = FLASH_PAGE_SIZE - (addr % FLASH_PAGE_SIZE);
+        n = (n > len) ? len : n;
+        write_enable(flash);
+        command(flash, CMD_PP, addr, 1);
+        spi_xfer(flash->spi, data, NULL, n);
+        spi_end(flash->spi);
+        wait_ready(flash);
+        addr += n;
+        data += n;
+        len -= n;
+    }
+}
+
+int flash_erase_sector(flash_t *flash, uint32_t addr) {
+    if (flash->erase_head - flash->erase_tail >= FLASH_ERASE_QUEUE) {
+        return -1;
+    }
+    addr &= ~(FLASH_SECTOR_SIZE - 1);
+    invalidate(flash, addr, FLASH_SECTOR_SIZE);
+    flash->erase_queue[flash->erase_head % FLASH_ERASE_QUEUE] = addr;
+    flash->erase_head++;
+    flash_poll(flash);
+    return 0;
+}
+
+uint32_t flash_poll(flash_t *flash) {
+    if (flash->erasing) {
+        if (read_status(flash) & SR_WIP) {
+            return flash->erase_head - flash->erase_tail;
+        }
+        flash->erasing = 0;
+        flash->erase_tail++;
+    }
+    if (flash->erase_head != flash->erase_tail) {
+        uint32_t addr = flash->erase_queue[flash->erase_tail % FLASH_ERASE_QUEUE];
+        write_enable(flash);
+        command(flash, CMD_SE, addr, 1);
+        spi_end(flash->spi);
+        flash->erasing = 1;
+    }
+    return flash->erase_head - flash->erase_tail;
+}
+
+void flash_sync(flash_t *flash) {
+    while (flash_poll(flash) != 0);
+}
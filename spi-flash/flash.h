@@ -0,0 +1,68 @@
+#ifndef FLASH_H
+#define FLASH_H
+
+#include <stdint.h>
+#include "spi.h"
+
+// JEDEC SPI NOR flash driver
+//
+// Reads use FAST READ (0x0B) and stream the whole block in one command
+// at the SPI clock. Writes are split at page boundaries and each page
+// is written by one PAGE PROGRAM (0x02). Sector erases are queued by
+// flash_erase_sector() and issued by flash_poll() one after another, so
+// the caller is not blocked for the erase time; the other operations
+// wait only while an erase is actually running.
+//
+// flash_read_cached() reads through a small LRU cache of
+// FLASH_CACHE_LINE byte lines for small random accesses such as
+// calibration tables. Programming and erasing invalidate the lines.
+
+#define FLASH_PAGE_SIZE    256
+#define FLASH_SECTOR_SIZE  4096
+
+#define FLASH_CACHE_LINES  8
+#define FLASH_CACHE_LINE   256
+#define FLASH_ERASE_QUEUE  16
+
+typedef struct _flash_cache_line_t {
+    uint32_t tag;               // address / FLASH_CACHE_LINE
+    uint32_t last_use;          // 0: invalid
+    uint8_t data[FLASH_CACHE_LINE];
+} flash_cache_line_t;
+
+typedef struct _flash_t {
+    spi_t *spi;
+    int cs;
+    uint8_t id[3];              // manufacturer, memory type, capacity
+    uint32_t size;              // bytes
+    int erasing;                // an erase is running
+    uint32_t erase_queue[FLASH_ERASE_QUEUE];
+    uint32_t erase_head;
+    uint32_t erase_tail;
+    uint32_t use_count;
+    uint32_t hits;
+    uint32_t misses;
+    flash_cache_line_t cache[FLASH_CACHE_LINES];
+} flash_t;
+
+// initialize SPI0 and read the JEDEC ID. returns -1 if no flash responds
+int flash_init(flash_t *flash, spi_t *spi, int cs, uint32_t clk);
+
+void flash_read(flash_t *flash, uint32_t addr, uint8_t *buf, uint32_t len);
+void flash_read_cached(flash_t *flash, uint32_t addr, uint8_t *buf, uint32_t len);
+
+// the area must have been erased
+void flash_program(flash_t *flash, uint32_t addr, const uint8_t *data, uint32_t len);
+
+// queue an erase of the sector which contains addr.
+// returns -1 if the queue is full
+int flash_erase_sector(flash_t *flash, uint32_t addr);
+
+// issue the queued erases, call it from the main loop.
+// returns the number of erases not completed yet
+uint32_t flash_poll(flash_t *flash);
+
+// wait for all the queued erases
+void flash_sync(flash_t *flash);
+
+#endif
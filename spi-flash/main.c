@@ -0,0 +1,109 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bsp.h"
+#include "flash.h"
+
+// print bytes per second of len bytes in usec
+static void print_rate(uint32_t len, uint32_t usec) {
+    uart_put_dec(usec);
+    uart_print("us ");
+    if (usec == 0) {
+        // shorter than the 1us resolution of the system timer
+        uart_print("-");
+    } else {
+        uart_put_dec((len * 1000 / usec) * 1000 / 1024);
+    }
+    uart_print("KB/s\r\n");
+}
+
+// test area: the last 64KB of the flash
+#define TEST_SIZE  (16 * FLASH_SECTOR_SIZE)
+
+static flash_t flash;
+static uint8_t wbuf[TEST_SIZE];
+static uint8_t rbuf[TEST_SIZE];
+
+int main(int argc, char **argv) {
+  spi_t* spi = (spi_t*) (SPI0);
+
+  uart_init(UART_BAUD);
+  uart_print("\r\nSPI NOR flash test.\r\n");
+
+  // 250MHz / 8 = 31.25MHz
+  if (flash_init(&flash, spi, 0, 8) < 0) {
+      uart_print("no flash\r\n");
+      while(1);
+  }
+  uart_print("JEDEC ID ");
+  uart_put_hex(flash.id[0]);
+  uart_put_hex(flash.id[1]);
+  uart_put_hex(flash.id[2]);
+  uart_print(", ");
+  uart_put_dec(flash.size / 1024);
+  uart_print("KB\r\n");
+
+  uint32_t base = flash.size - TEST_SIZE;
+
+  // queue the erases and prepare the data while the flash is busy
+  uint32_t start = SYST_CLO;
+  for (uint32_t a = 0; a < TEST_SIZE; a += FLASH_SECTOR_SIZE) {
+      flash_erase_sector(&flash, base + a);
+  }
+  uart_print("erase queued in ");
+  uart_put_dec(SYST_CLO - start);
+  uart_print("us\r\n");
+  for (uint32_t i = 0; i < TEST_SIZE; i++) {
+      wbuf[i] = (i >> 8) ^ i;
+  }
+  uint32_t polls = 0;
+  while (flash_poll(&flash) != 0) {
+      polls++;
+  }
+  uart_print("erase ");
+  uart_put_dec(TEST_SIZE / 1024);
+  uart_print("KB done in ");
+  uart_put_dec(SYST_CLO - start);
+  uart_print("us, main loop ran ");
+  uart_put_dec(polls);
+  uart_print(" times\r\n");
+
+  start = SYST_CLO;
+  flash_program(&flash, base, wbuf, TEST_SIZE);
+  uart_print("program ");
+  print_rate(TEST_SIZE, SYST_CLO - start);
+
+  start = SYST_CLO;
+  flash_read(&flash, base, rbuf, TEST_SIZE);
+  uart_print("fast read ");
+  print_rate(TEST_SIZE, SYST_CLO - start);
+
+  int err = 0;
+  for (uint32_t i = 0; i < TEST_SIZE; i++) {
+      if (rbuf[i] != wbuf[i]) {
+          err++;
+      }
+  }
+  uart_print("verify errors ");
+  uart_put_dec(err);
+  uart_print("\r\n");
+
+  // random small reads from a 1KB table through the cache
+  uint32_t seed = 1;
+  start = SYST_CLO;
+  for (int i = 0; i < 10000; i++) {
+      uint8_t v[4];
+      seed = seed * 1103515245 + 12345;
+      flash_read_cached(&flash, base + ((seed >> 16) % 1024), v, 4);
+  }
+  uart_print("10000 cached reads in ");
+  uart_put_dec(SYST_CLO - start);
+  uart_print("us, hits ");
+  uart_put_dec(flash.hits);
+  uart_print(" misses ");
+  uart_put_dec(flash.misses);
+  uart_print("\r\n");
+
+  while(1);
+  return 0;
+}
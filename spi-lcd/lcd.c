@@ -0,0 +1,254 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "lcd.h"
+#include "dma.h"
+
+// DMA channels for SPI TX and RX
+#define LCD_DMA_TX  4
+#define LCD_DMA_RX  5
+
+// LoSSI words of one line (2 bytes per pixel)
+#define LCD_MAX_WIDTH  320
+#define LINE_WORDS     (LCD_MAX_WIDTH * 2)
+
+#define LOSSI_DATA  (1<<8)
+
+// panel commands
+#define CMD_SWRESET 0x01
+#define CMD_SLPOUT  0x11
+#define CMD_INVON   0x21
+#define CMD_DISPON  0x29
+#define CMD_CASET   0x2A
+#define CMD_PASET   0x2B
+#define CMD_RAMWR   0x2C
+#define CMD_MADCTL  0x36
+#define CMD_COLMOD  0x3A
+
+// ping-pong line buffers: one is sent by DMA while the other is filled
+static uint32_t line_buf[2][LINE_WORDS] __attribute__((aligned(32)));
+static dma_cb_t tx_cb;
+static dma_cb_t rx_cb;
+static uint32_t rx_dummy;
+
+static void lossi_write(spi_t *spi, uint32_t word) {
+    while (!(spi->CS & CS_TXD));
+    spi->FIFO = word;
+    // discard received data
+    while (spi->CS & CS_RXD) {
+        spi->FIFO;
+    }
+}
+
+static void lossi_end(spi_t *spi) {
+    while (!(spi->CS & CS_DONE)) {
+        while (spi->CS & CS_RXD) {
+            spi->FIFO;
+        }
+    }
+    spi->CS = (spi->CS & ~(CS_TA | CS_DMAEN | CS_DMA_LEN)) | CLEAR_TX | CLEAR_RX;
+}
+
+void lcd_command(lcd_t *lcd, uint8_t cmd, const uint8_t *param, uint32_t len) {
+    spi_t *spi = lcd->spi;
+
+    spi->CS = (spi->CS & ~CS_CS) | CLEAR_TX | CLEAR_RX | CS_TA;
+    lossi_write(spi, cmd);
+    for (uint32_t i = 0; i < len; i++) {
+        lossi_write(spi, LOSSI_DATA | param[i]);
+    }
+    lossi_end(spi);
+}
+
+int lcd_init(lcd_t *lcd, int type, uint32_t width, uint32_t height,
+             uint16_t *fb, uint32_t clk) {
+    // the line buffers hold LCD_MAX_WIDTH pixels, and fb is walked with
+    // width as the stride, so a wider panel can not be clamped
+    if ((width == 0) || (width > LCD_MAX_WIDTH)) {
+        return -1;
+    }
+    lcd->spi = (spi_t *) SPI0;
+    lcd->type = type;
+    lcd->width = width;
+    lcd->height = height;
+    lcd->fb = fb;
+    lcd->num_dirty = 0;
+    lcd->bytes_sent = 0;
+
+    spi_init(lcd->spi, 0, 0, clk);
+    lcd->spi->CS |= CS_LEN;     // LoSSI mode
+    dma_init(LCD_DMA_TX);
+    dma_init(LCD_DMA_RX);
+
+    lcd_command(lcd, CMD_SWRESET, NULL, 0);
+    delay_ms(120);
+    lcd_command(lcd, CMD_SLPOUT, NULL, 0);
+    delay_ms(120);
+
+    const uint8_t colmod = 0x55;    // 16 bits per pixel
+    lcd_command(lcd, CMD_COLMOD, &colmod, 1);
+    if (type == LCD_ILI9341) {
+        const uint8_t madctl = 0x48;    // column address order, BGR
+        lcd_command(lcd, CMD_MADCTL, &madctl, 1);
+    } else {
+        const uint8_t madctl = 0x00;
+        lcd_command(lcd, CMD_MADCTL, &madctl, 1);
+        lcd_command(lcd, CMD_INVON, NULL, 0);
+    }
+    lcd_command(lcd, CMD_DISPON, NULL, 0);
+
+    lcd_fill_rect(lcd, 0, 0, lcd->width, lcd->height, 0);
+    lcd_flush(lcd);
+    return 0;
+}
+
+static uint32_t area(const lcd_rect_t *r) {
+    return (r->x2 - r->x1) * (r->y2 - r->y1);
+}
+
+static void merge(lcd_rect_t *dst, const lcd_rect_t *src) {
+    dst->x1 = (src->x1 < dst->x1) ? src->x1 : dst->x1;
+    dst->y1 = (src->y1 < dst->y1) ? src->y1 : dst->y1;
+    dst->x2 = (src->x2 > dst->x2) ? src->x2 : dst->x2;
+    dst->y2 = (src->y2 > dst->y2) ? src->y2 : dst->y2;
+}
+
+static int overlap(const lcd_rect_t *a, const lcd_rect_t *b) {
+    return (a->x1 <= b->x2) && (b->x1 <= a->x2)
+        && (a->y1 <= b->y2) && (b->y1 <= a->y2);
+}
+
+void lcd_mark_dirty(lcd_t *lcd, uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2) {
+    x2 = (x2 > lcd->width) ? lcd->width : x2;
+    y2 = (y2 > lcd->height) ? lcd->height : y2;
+    if ((x1 >= x2) || (y1 >= y2)) {
+        return;
+    }
+    lcd_rect_t r = { x1, y1, x2, y2 };
+
+    // merge with an overlapping or touching rectangle
+    for (uint32_t i = 0; i < lcd->num_dirty; i++) {
+        if (overlap(&lcd->dirty[i], &r)) {
+            merge(&lcd->dirty[i], &r);
+            return;
+        }
+    }
+    if (lcd->num_dirty < LCD_MAX_DIRTY) {
+        lcd->dirty[lcd->num_dirty++] = r;
+        return;
+    }
+    // no room: merge with the rectangle which grows least
+    uint32_t best = 0;
+    uint32_t best_growth = 0xffffffff;
+    for (uint32_t i = 0; i < lcd->num_dirty; i++) {
+        lcd_rect_t u = lcd->dirty[i];
+        merge(&u, &r);
+        uint32_t growth = area(&u) - area(&lcd->dirty[i]);
+        if (growth < best_growth) {
+            best_growth = growth;
+            best = i;
+        }
+    }
+    merge(&lcd->dirty[best], &r);
+}
+
+void lcd_fill_rect(lcd_t *lcd, uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2,
+                   uint16_t color) {
+    x2 = (x2 > lcd->width) ? lcd->width : x2;
+    y2 = (y2 > lcd->height) ? lcd->height : y2;
+    for (uint32_t y = y1; y < y2; y++) {
+        uint16_t *p = &lcd->fb[y * lcd->width];
+        for (uint32_t x = x1; x < x2; x++) {
+            p[x] = color;
+        }
+    }
+    lcd_mark_dirty(lcd, x1, y1, x2, y2);
+}
+
+void lcd_set_pixel(lcd_t *lcd, uint32_t x, uint32_t y, uint16_t color) {
+    if ((x < lcd->width) && (y < lcd->height)) {
+        lcd->fb[y * lcd->width + x] = color;
+        lcd_mark_dirty(lcd, x, y, x + 1, y + 1);
+    }
+}
+
+// convert a line of RGB565 pixels to LoSSI data words, high byte first
+static void convert_line(uint32_t *dst, const uint16_t *src, uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t c = src[i];
+        *dst++ = LOSSI_DATA | (c >> 8);
+        *dst++ = LOSSI_DATA | (c & 0xff);
+    }
+}
+
+static void send_line(spi_t *spi, const uint32_t *buf, uint32_t words) {
+    tx_cb.ti = DMA_TI_PERMAP(DREQ_SPI_TX) | DMA_TI_DEST_DREQ
+        | DMA_TI_SRC_INC | DMA_TI_WAIT_RESP;
+    tx_cb.source_ad = BUS_ADDR(buf);
+    tx_cb.dest_ad = PERI_ADDR(&spi->FIFO);
+    tx_cb.txfr_len = words * 4;
+    tx_cb.stride = 0;
+    tx_cb.nextconbk = 0;
+    dma_start(LCD_DMA_TX, &tx_cb);
+}
+
+static void set_window(lcd_t *lcd, const lcd_rect_t *r) {
+    uint8_t param[4];
+
+    param[0] = r->x1 >> 8;
+    param[1] = r->x1 & 0xff;
+    param[2] = (r->x2 - 1) >> 8;
+    param[3] = (r->x2 - 1) & 0xff;
+    lcd_command(lcd, CMD_CASET, param, 4);
+    param[0] = r->y1 >> 8;
+    param[1] = r->y1 & 0xff;
+    param[2] = (r->y2 - 1) >> 8;
+    param[3] = (r->y2 - 1) & 0xff;
+    lcd_command(lcd, CMD_PASET, param, 4);
+}
+
+static void flush_rect(lcd_t *lcd, const lcd_rect_t *r) {
+    spi_t *spi = lcd->spi;
+    uint32_t w = r->x2 - r->x1;
+    uint32_t words = w * 2;
+    int n = 0;
+
+    set_window(lcd, r);
+
+    // RAMWR, then the pixels by DMA with CS kept asserted
+    spi->CS = (spi->CS & ~CS_CS) | CLEAR_TX | CLEAR_RX | CS_TA;
+    lossi_write(spi, CMD_RAMWR);
+    while (!(spi->CS & CS_DONE));
+
+    // RX DMA drains the received words so that the transfer never
+    // stalls on a full RX FIFO; it is stopped when the rectangle is done
+    rx_cb.ti = DMA_TI_PERMAP(DREQ_SPI_RX) | DMA_TI_SRC_DREQ | DMA_TI_WAIT_RESP;
+    rx_cb.source_ad = PERI_ADDR(&spi->FIFO);
+    rx_cb.dest_ad = BUS_ADDR(&rx_dummy);
+    rx_cb.txfr_len = (r->y2 - r->y1) * words * 4;
+    rx_cb.stride = 0;
+    rx_cb.nextconbk = 0;
+    dma_start(LCD_DMA_RX, &rx_cb);
+    spi->CS |= CS_DMAEN | CS_DMA_LEN;
+
+    convert_line(line_buf[n], &lcd->fb[r->y1 * lcd->width + r->x1], w);
+    for (uint32_t y = r->y1; y < r->y2; y++) {
+        while (dma_busy(LCD_DMA_TX));
+        send_line(spi, line_buf[n], words);
+        n ^= 1;
+        if (y + 1 < r->y2) {
+            convert_line(line_buf[n], &lcd->fb[(y + 1) * lcd->width + r->x1], w);
+        }
+    }
+    while (dma_busy(LCD_DMA_TX));
+    while (!(spi->CS & CS_DONE));
+    dma_abort(LCD_DMA_RX);
+    lossi_end(spi);
+    lcd->bytes_sent += (r->y2 - r->y1) * w * 2;
+}
+
+void lcd_flush(lcd_t *lcd) {
+    for (uint32_t i = 0; i < lcd->num_dirty; i++) {
+        flush_rect(lcd, &lcd->dirty[i]);
+    }
+    lcd->num_dirty = 0;
+}
@@ -0,0 +1,62 @@
+#ifndef LCD_H
+#define LCD_H
+
+#include <stdint.h>
+#include "bsp.h"
+#include "spi.h"
+
+// SPI TFT display driver (ILI9341 / ST7789) in LoSSI mode
+//
+// The panel is connected by the 3-wire 9-bit serial interface: every
+// byte is preceded by a D/C bit, which the SPI0 LoSSI mode sends from
+// bit 8 of each FIFO word. No D/C GPIO is needed.
+//
+// The drawing functions write an RGB565 offscreen buffer (same layout
+// as RGB565 of SmartStart) and record the dirty rectangles. lcd_flush()
+// sets the column/page address window of each dirty rectangle and
+// streams only its pixels to the panel by DMA.
+
+#define LCD_ILI9341  0
+#define LCD_ST7789   1
+
+#define LCD_MAX_DIRTY  8
+
+#define RGB565(r, g, b) \
+    ((uint16_t) ((((r) >> 3) << 11) | (((g) >> 2) << 5) | ((b) >> 3)))
+
+// rectangle from (x1, y1) to (x2, y2), x2 and y2 are exclusive
+typedef struct _lcd_rect_t {
+    uint16_t x1;
+    uint16_t y1;
+    uint16_t x2;
+    uint16_t y2;
+} lcd_rect_t;
+
+typedef struct _lcd_t {
+    spi_t *spi;
+    int type;
+    uint32_t width;
+    uint32_t height;
+    uint16_t *fb;               // width * height pixels
+    lcd_rect_t dirty[LCD_MAX_DIRTY];
+    uint32_t num_dirty;
+    uint32_t bytes_sent;        // pixel bytes sent to the panel
+} lcd_t;
+
+// initialize SPI0 (CE0) and the panel. clk is the SPI clock divisor.
+// returns -1 if width is 0 or more than 320
+int lcd_init(lcd_t *lcd, int type, uint32_t width, uint32_t height,
+             uint16_t *fb, uint32_t clk);
+
+// send a command and its parameters by polling
+void lcd_command(lcd_t *lcd, uint8_t cmd, const uint8_t *param, uint32_t len);
+
+void lcd_mark_dirty(lcd_t *lcd, uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2);
+void lcd_fill_rect(lcd_t *lcd, uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2,
+                   uint16_t color);
+void lcd_set_pixel(lcd_t *lcd, uint32_t x, uint32_t y, uint16_t color);
+
+// send all the dirty rectangles and clear them
+void lcd_flush(lcd_t *lcd);
+
+#endif
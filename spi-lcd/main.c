@@ -0,0 +1,68 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bsp.h"
+#include "lcd.h"
+
+#define LCD_WIDTH   240
+#define LCD_HEIGHT  320
+#define BOX_SIZE    40
+
+static uint16_t framebuffer[LCD_WIDTH * LCD_HEIGHT];
+
+int main(int argc, char **argv) {
+  lcd_t lcd;
+
+  uart_init(UART_BAUD);
+  uart_print("\r\nSPI LCD test.\r\n");
+
+  // 250MHz / 8 = 31.25MHz
+  if (lcd_init(&lcd, LCD_ILI9341, LCD_WIDTH, LCD_HEIGHT, framebuffer, 8) < 0) {
+    uart_print("bad panel size.\r\n");
+    while (1) {
+    }
+  }
+
+  // background and a frame
+  lcd_fill_rect(&lcd, 0, 0, LCD_WIDTH, LCD_HEIGHT, RGB565(0, 0, 64));
+  lcd_fill_rect(&lcd, 0, 0, LCD_WIDTH, 4, RGB565(255, 255, 255));
+  lcd_fill_rect(&lcd, 0, LCD_HEIGHT - 4, LCD_WIDTH, LCD_HEIGHT, RGB565(255, 255, 255));
+  lcd_flush(&lcd);
+
+  // move a box: only the old and new positions are sent
+  int x = 10;
+  int y = 10;
+  int dx = 3;
+  int dy = 2;
+  uint32_t frames = 0;
+  uint32_t start = SYST_CLO;
+  lcd.bytes_sent = 0;
+  while(1) {
+      lcd_fill_rect(&lcd, x, y, x + BOX_SIZE, y + BOX_SIZE, RGB565(0, 0, 64));
+      if ((x + dx < 4) || (x + dx + BOX_SIZE > LCD_WIDTH - 4)) {
+          dx = -dx;
+      }
+      if ((y + dy < 4) || (y + dy + BOX_SIZE > LCD_HEIGHT - 4)) {
+          dy = -dy;
+      }
+      x += dx;
+      y += dy;
+      lcd_fill_rect(&lcd, x, y, x + BOX_SIZE, y + BOX_SIZE, RGB565(255, 128, 0));
+      lcd_flush(&lcd);
+      frames++;
+
+      uint32_t elapsed = SYST_CLO - start;
+      if (elapsed >= 1000000) {
+          uart_put_dec(frames);
+          uart_print(" fps, ");
+          uart_put_dec(lcd.bytes_sent / frames);
+          uart_print(" bytes/frame (full frame ");
+          uart_put_dec(LCD_WIDTH * LCD_HEIGHT * 2);
+          uart_print(")\r\n");
+          frames = 0;
+          lcd.bytes_sent = 0;
+          start = SYST_CLO;
+      }
+  }
+  return 0;
+}
@@ -0,0 +1,107 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bsp.h"
+#include "task.h"
+
+// Tasks
+
+#define LINE_LEN 64
+
+static char line[LINE_LEN];
+static event_t line_ready;
+
+// blink the ACT LED (GPIO47) at 1Hz without drift
+static void blink_task(void *arg) {
+    uint64_t next = systime();
+    GPFSEL4 = (GPFSEL4 & ~(7U << (3*7))) | (GPF_OUTPUT << (3*7));
+    for (;;) {
+        GPCLR1 = 1 << 15;   // LED on
+        next += 500000;
+        task_sleep_until(next);
+        GPSET1 = 1 << 15;   // LED off
+        next += 500000;
+        task_sleep_until(next);
+    }
+}
+
+// read characters from mini UART, echo them back and signal
+// line_ready on CR
+static void uart_rx_task(void *arg) {
+    static char buf[LINE_LEN];
+    int len = 0;
+    for (;;) {
+        while (!(MU_LSR & MU_LSR_RX_RDY)) {
+            task_yield();
+        }
+        char c = MU_IO;
+        if (c == 0x0D) {
+            uart_print("\r\n");
+            for (int i = 0; i < len; i++) {
+                line[i] = buf[i];
+            }
+            line[len] = 0;
+            len = 0;
+            event_signal(&line_ready);
+        } else if (len < LINE_LEN - 1) {
+            uart_putc(c);
+            buf[len++] = c;
+        }
+    }
+}
+
+// wait for a line and print it reversed
+static void shell_task(void *arg) {
+    for (;;) {
+        task_wait(&line_ready);
+        int len = 0;
+        while (line[len]) {
+            len++;
+        }
+        uart_print("> ");
+        for (int i = len - 1; i >= 0; i--) {
+            uart_putc(line[i]);
+        }
+        uart_print("\r\n");
+    }
+}
+
+// print statistics every 5 seconds
+static void stats_task(void *arg) {
+    task_t **t = (task_t **) arg;
+    uint64_t next = systime();
+    for (;;) {
+        next += 5000000;
+        task_sleep_until(next);
+        uart_print("uptime(s) ");
+        uart_put_dec(systime() / 1000000);
+        uart_print(" switches ");
+        uart_put_dec(task_switch_count());
+        for (int i = 0; t[i] != NULL; i++) {
+            if (!task_stack_ok(t[i])) {
+                uart_print(" stack overflow: ");
+                uart_print(t[i]->name);
+            }
+        }
+        uart_print("\r\n");
+    }
+}
+
+int main(int argc, char **argv) {
+  static task_t *t[5];
+
+  uart_init(UART_BAUD);
+  uart_print("\r\nCooperative multitasking test. Type a line.\r\n");
+
+  task_init();
+  event_init(&line_ready);
+  t[0] = task_create("blink", blink_task, NULL, TASK_STACK_SIZE);
+  t[1] = task_create("uart_rx", uart_rx_task, NULL, TASK_STACK_SIZE);
+  t[2] = task_create("shell", shell_task, NULL, TASK_STACK_SIZE);
+  t[3] = task_create("stats", stats_task, t, TASK_STACK_SIZE);
+  t[4] = NULL;
+
+  task_start();
+
+  return 0;
+}
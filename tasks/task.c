@@ -0,0 +1,199 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "task.h"
+
+#define STACK_GUARD  0xdeadbeefU
+
+// switch.S
+extern void task_switch(uint32_t **save_sp, uint32_t *load_sp);
+extern void task_trampoline(void);
+
+extern uint32_t __bss_end;
+
+static task_t tasks[TASK_MAX];
+static task_t *current;
+static uint32_t stack_top;
+static uint32_t switches;
+
+static inline uint32_t irq_save(void) {
+    uint32_t cpsr;
+    __asm volatile("mrs %0, cpsr \n"
+                   "cpsid i \n" : "=r" (cpsr) :: "memory");
+    return cpsr;
+}
+
+static inline void irq_restore(uint32_t cpsr) {
+    __asm volatile("msr cpsr_c, %0" :: "r" (cpsr) : "memory");
+}
+
+void task_init(void) {
+    for (int i = 0; i < TASK_MAX; i++) {
+        tasks[i].state = TASK_FREE;
+    }
+    // tasks[0] is main() running on the SVC stack
+    tasks[0].state = TASK_READY;
+    tasks[0].name = "idle";
+    tasks[0].stack_bottom = (uint32_t *) TASK_STACK_TOP;
+    tasks[0].stack_bottom[0] = STACK_GUARD;
+    current = &tasks[0];
+    stack_top = TASK_STACK_TOP;
+    switches = 0;
+}
+
+task_t *task_create(const char *name, task_fn_t fn, void *arg, uint32_t stack_size) {
+    task_t *t = NULL;
+    for (int i = 1; i < TASK_MAX; i++) {
+        if ((tasks[i].state == TASK_FREE) || (tasks[i].state == TASK_DEAD)) {
+            t = &tasks[i];
+            break;
+        }
+    }
+    if (t == NULL) {
+        return NULL;
+    }
+
+    // the stacks of dead tasks are not reused
+    stack_size = (stack_size + 7) & ~7U;
+    if (stack_top - stack_size <= (uint32_t) &__bss_end) {
+        return NULL;
+    }
+    uint32_t *top = (uint32_t *) stack_top;
+    stack_top -= stack_size;
+    t->stack_bottom = (uint32_t *) stack_top;
+    t->stack_bottom[0] = STACK_GUARD;
+
+    // initial frame popped by task_switch: r4-r12, lr
+    uint32_t *sp = top - 10;
+    sp[0] = (uint32_t) fn;               // r4
+    sp[1] = (uint32_t) arg;              // r5
+    for (int i = 2; i < 9; i++) {
+        sp[i] = 0;                       // r6-r12
+    }
+    sp[9] = (uint32_t) task_trampoline;  // lr
+
+    t->sp = sp;
+    t->name = name;
+    t->event = NULL;
+    t->state = TASK_READY;
+    return t;
+}
+
+// a sleeping or waiting task becomes ready when its condition is met
+static int task_runnable(task_t *t, uint64_t now) {
+    switch (t->state) {
+    case TASK_READY:
+        return 1;
+    case TASK_SLEEPING:
+        if (now >= t->wake_time) {
+            t->state = TASK_READY;
+            return 1;
+        }
+        return 0;
+    case TASK_WAITING: {
+        // the signals up to the wake up are consumed here, so that a
+        // signal after it stays pending until the next task_wait()
+        int ready = 0;
+        uint32_t cpsr = irq_save();
+        if (t->event->seq != t->event_seq) {
+            t->event->pending = 0;
+            t->state = TASK_READY;
+            ready = 1;
+        }
+        irq_restore(cpsr);
+        return ready;
+    }
+    default:
+        return 0;
+    }
+}
+
+static void schedule(void) {
+    uint64_t now = systime();
+    int cur = current - tasks;
+    task_t *next = NULL;
+
+    // round robin over the tasks after the current one; the idle task
+    // runs only when no other task can run
+    for (int n = 1; n <= TASK_MAX; n++) {
+        int i = (cur + n) % TASK_MAX;
+        if ((i != 0) && task_runnable(&tasks[i], now)) {
+            next = &tasks[i];
+            break;
+        }
+    }
+    if (next == NULL) {
+        next = &tasks[0];
+    }
+    if (next != current) {
+        task_t *prev = current;
+        current = next;
+        switches++;
+        task_switch(&prev->sp, next->sp);
+    }
+}
+
+void task_start(void) {
+    for (;;) {
+        task_yield();
+    }
+}
+
+void task_yield(void) {
+    schedule();
+}
+
+void task_sleep_until(uint64_t time) {
+    current->wake_time = time;
+    current->state = TASK_SLEEPING;
+    schedule();
+}
+
+void task_sleep(uint32_t usec) {
+    task_sleep_until(systime() + usec);
+}
+
+void task_exit(void) {
+    current->state = TASK_DEAD;
+    schedule();
+    for (;;) {
+    }
+}
+
+task_t *task_self(void) {
+    return current;
+}
+
+uint32_t task_switch_count(void) {
+    return switches;
+}
+
+int task_stack_ok(const task_t *task) {
+    return task->stack_bottom[0] == STACK_GUARD;
+}
+
+void event_init(event_t *ev) {
+    ev->seq = 0;
+    ev->pending = 0;
+}
+
+void event_signal(event_t *ev) {
+    uint32_t cpsr = irq_save();
+    ev->seq++;
+    ev->pending = 1;
+    irq_restore(cpsr);
+}
+
+void task_wait(event_t *ev) {
+    uint32_t cpsr = irq_save();
+    if (ev->pending) {
+        ev->pending = 0;
+        irq_restore(cpsr);
+        return;
+    }
+    current->event = ev;
+    current->event_seq = ev->seq;
+    current->state = TASK_WAITING;
+    irq_restore(cpsr);
+
+    schedule();
+}
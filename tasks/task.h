@@ -0,0 +1,71 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include <stdint.h>
+#include "bsp.h"
+
+// Cooperative multitasking kernel
+//
+// Every task has its own stack. The stacks are allocated downward
+// from TASK_STACK_TOP, below the stack of main() which Init_Machine
+// sets at SVC_STACK_TOP. A task runs until it calls task_yield(),
+// task_sleep_until() or task_wait().
+
+#define TASK_MAX          8
+#define SVC_STACK_TOP     BSP_SVC_STACK
+#define MAIN_STACK_SIZE   0x10000
+#define TASK_STACK_TOP    (SVC_STACK_TOP - MAIN_STACK_SIZE)
+#define TASK_STACK_SIZE   0x4000   // default stack size
+
+typedef void (*task_fn_t)(void *arg);
+
+typedef enum {
+    TASK_FREE = 0,
+    TASK_READY,
+    TASK_SLEEPING,
+    TASK_WAITING,
+    TASK_DEAD,
+} task_state_t;
+
+typedef struct _event_t {
+    volatile uint32_t seq;      // incremented by every signal
+    volatile uint32_t pending;  // signalled while nobody was waiting
+} event_t;
+
+typedef struct _task_t {
+    uint32_t *sp;               // saved stack pointer
+    task_state_t state;
+    const char *name;
+    uint64_t wake_time;         // TASK_SLEEPING: systime to wake up
+    event_t *event;             // TASK_WAITING: event to wait for
+    uint32_t event_seq;         // TASK_WAITING: event->seq on wait
+    uint32_t *stack_bottom;
+} task_t;
+
+// main() becomes the idle task
+void task_init(void);
+
+// returns NULL if no task slot or stack space is left
+task_t *task_create(const char *name, task_fn_t fn, void *arg, uint32_t stack_size);
+
+// run the tasks; the caller (main) becomes the idle task and never returns
+void task_start(void) __attribute__((noreturn));
+
+void task_yield(void);
+void task_sleep_until(uint64_t time);
+void task_sleep(uint32_t usec);
+void task_exit(void) __attribute__((noreturn));
+
+task_t *task_self(void);
+uint32_t task_switch_count(void);
+
+// returns 0 if the guard word at the bottom of the stack was overwritten
+int task_stack_ok(const task_t *task);
+
+// an event wakes all the tasks waiting for it. if no task is waiting,
+// the event is kept pending and the next task_wait() returns at once.
+void event_init(event_t *ev);
+void event_signal(event_t *ev);
+void task_wait(event_t *ev);
+
+#endif
@@ -0,0 +1,142 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bsp.h"
+#include "sched.h"
+
+static void busy_wait(uint32_t usec) {
+    uint64_t end = systime() + usec;
+    while (systime() < end);
+}
+
+// Tasks
+
+#define AUDIO_PERIOD    1000
+#define CONTROL_PERIOD  10000
+
+static mutex_t bus_lock;
+static volatile uint32_t audio_jitter;
+static volatile uint32_t control_wait;
+
+// priority 0: periodic refill (e.g. I2S), measures the wake up jitter
+static void audio_task(void *arg) {
+    uint64_t next = systime();
+    for (;;) {
+        next += AUDIO_PERIOD;
+        task_sleep_until(next);
+        uint32_t jitter = systime() - next;
+        if (jitter > audio_jitter) {
+            audio_jitter = jitter;
+        }
+        busy_wait(100);
+    }
+}
+
+// priority 1: control loop sharing a bus with the logger task
+static void control_task(void *arg) {
+    uint64_t next = systime();
+    for (;;) {
+        next += CONTROL_PERIOD;
+        task_sleep_until(next);
+        uint64_t t = systime();
+        mutex_lock(&bus_lock);
+        uint32_t wait = systime() - t;
+        if (wait > control_wait) {
+            control_wait = wait;
+        }
+        busy_wait(500);
+        mutex_unlock(&bus_lock);
+    }
+}
+
+// priority 2: wakes up often and would delay the logger without
+// priority inheritance
+static void worker_task(void *arg) {
+    for (;;) {
+        task_sleep(3000);
+        busy_wait(2000);
+    }
+}
+
+// priority 3: holds the bus for a long time
+static void logger_task(void *arg) {
+    for (;;) {
+        mutex_lock(&bus_lock);
+        busy_wait(3000);
+        mutex_unlock(&bus_lock);
+        task_sleep(20000);
+    }
+}
+
+// priority 4: never yields, two instances share the CPU time left
+static void runaway_task(void *arg) {
+    volatile uint32_t *count = (volatile uint32_t *) arg;
+    for (;;) {
+        (*count)++;
+    }
+}
+
+// priority 1: prints the CPU time of each task every second
+static void stats_task(void *arg) {
+    uint64_t next = systime();
+    uint64_t prev_time[TASK_MAX];
+    uint64_t prev_idle = 0;
+    for (int i = 0; i < TASK_MAX; i++) {
+        prev_time[i] = 0;
+    }
+
+    for (;;) {
+        next += 1000000;
+        task_sleep_until(next);
+
+        int i = 0;
+        for (task_t *t = task_iterate(NULL); t != NULL; t = task_iterate(t), i++) {
+            uint64_t cpu = t->cpu_time;
+            uart_print(t->name);
+            uart_putc(' ');
+            uart_put_dec((uint32_t) ((cpu - prev_time[i]) / 10000));
+            uart_print("% ");
+            if (!task_stack_ok(t)) {
+                uart_print("(stack overflow) ");
+            }
+            prev_time[i] = cpu;
+        }
+        uint64_t idle = sched_idle_time();
+        uart_print("idle ");
+        uart_put_dec((uint32_t) ((idle - prev_idle) / 10000));
+        uart_print("% / jitter(us) ");
+        uart_put_dec(audio_jitter);
+        uart_print(" mutex wait(us) ");
+        uart_put_dec(control_wait);
+        uart_print(" switches ");
+        uart_put_dec(sched_switch_count());
+        uart_print("\r\n");
+        prev_idle = idle;
+        audio_jitter = 0;
+        control_wait = 0;
+    }
+}
+
+int main(int argc, char **argv) {
+  static volatile uint32_t count1;
+  static volatile uint32_t count2;
+
+  uart_init(UART_BAUD);
+  uart_print("\r\nPreemptive scheduler test.\r\n");
+
+  sched_init();
+  mutex_init(&bus_lock);
+  task_create("audio", 0, audio_task, NULL, TASK_STACK_SIZE);
+  task_create("control", 1, control_task, NULL, TASK_STACK_SIZE);
+  task_create("stats", 1, stats_task, NULL, TASK_STACK_SIZE);
+  task_create("worker", 2, worker_task, NULL, TASK_STACK_SIZE);
+  task_create("logger", 3, logger_task, NULL, TASK_STACK_SIZE);
+  task_create("runaway1", 4, runaway_task, (void *) &count1, TASK_STACK_SIZE);
+  task_create("runaway2", 4, runaway_task, (void *) &count2, TASK_STACK_SIZE);
+
+  // SCHED_TICK: 1ms periodic tick
+  // SCHED_TICKLESS: the timer is programmed for the next event only
+  sched_start(SCHED_TICKLESS);
+
+  return 0;
+}
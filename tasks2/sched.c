@@ -0,0 +1,496 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "bsp.h"
+#include "sched.h"
+
+#define IRQ_BASIC         IOREG(0x2000B200)
+#define IRQ_ENABLE_BASIC  IOREG(0x2000B218)
+#define IRQ_DISABLE_BASIC IOREG(0x2000B224)
+
+#define RPI_BASIC_ARM_TIMER_IRQ (1 << 0)
+
+#define ARM_TIMER_LOD IOREG(0x2000B400)
+#define ARM_TIMER_VAL IOREG(0x2000B404)
+#define ARM_TIMER_CTL IOREG(0x2000B408)
+#define ARM_TIMER_CLI IOREG(0x2000B40C)
+#define ARM_TIMER_RIS IOREG(0x2000B410)
+#define ARM_TIMER_MIS IOREG(0x2000B414)
+#define ARM_TIMER_RLD IOREG(0x2000B418)
+#define ARM_TIMER_DIV IOREG(0x2000B41C)
+
+// shortest and longest delay programmed in tickless mode
+#define TICKLESS_MIN_US  20
+#define TICKLESS_MAX_US  1000000
+
+#define STACK_GUARD  0xdeadbeefU
+
+// SVC mode, IRQ enabled, FIQ disabled
+#define TASK_INITIAL_CPSR  0x00000053
+
+// switch.S
+extern void context_switch(int rotate);
+extern void _irq_preempt(void);
+
+extern uint32_t __bss_end;
+
+// ldr pc, [pc, #24]
+#define	JMP_PC_24	0xe59ff018
+
+typedef void (*exception_hander_t)(void);
+
+typedef struct __attribute__((aligned(32))) _vector_table_t {
+    const unsigned int vector[8]; // all elements shoud be JMP_PC_24
+    exception_hander_t reset;
+    exception_hander_t undef;
+    exception_hander_t svc;
+    exception_hander_t prefetch_abort;
+    exception_hander_t data_abort;
+    exception_hander_t hypervisor_trap;
+    exception_hander_t irq;
+    exception_hander_t fiq;
+} vector_table_t;
+
+static void __attribute__((naked)) hangup(void);
+
+static vector_table_t exception_vector = { \
+    .vector = { JMP_PC_24, JMP_PC_24, JMP_PC_24, JMP_PC_24, \
+                JMP_PC_24, JMP_PC_24, JMP_PC_24, JMP_PC_24 },
+    .reset = Init_Machine,
+    .undef = hangup,
+    .svc = hangup,
+    .prefetch_abort = hangup,
+    .data_abort = hangup,
+    .hypervisor_trap = hangup,
+    .irq = _irq_preempt,
+    .fiq = hangup
+};
+
+static void __attribute__((naked)) hangup(void) {
+    while(1) {
+    }
+}
+
+static void set_vbar(vector_table_t *base) {
+    __asm volatile ("mcr p15, 0, %[base], c12, c0, 0"
+                    :: [base] "r" (base));
+}
+
+static inline uint32_t irq_save(void) {
+    uint32_t cpsr;
+    __asm volatile("mrs %0, cpsr \n"
+                   "cpsid i \n" : "=r" (cpsr) :: "memory");
+    return cpsr;
+}
+
+static inline void irq_restore(uint32_t cpsr) {
+    __asm volatile("msr cpsr_c, %0" :: "r" (cpsr) : "memory");
+}
+
+static task_t tasks[TASK_MAX];
+static task_t *current;
+static uint32_t stack_top;
+static sched_mode_t sched_mode;
+static uint64_t last_account;   // systime when cpu_time was last updated
+static uint64_t slice_start;    // systime when the current slice started
+static uint32_t switches;
+static int started;
+static volatile int in_irq;
+static sched_irq_hook_t irq_hook;
+
+void sched_init(void) {
+    for (int i = 0; i < TASK_MAX; i++) {
+        tasks[i].state = TASK_FREE;
+    }
+    // tasks[0] is main() running on the SVC stack
+    tasks[0].state = TASK_READY;
+    tasks[0].prio = TASK_PRIO_IDLE;
+    tasks[0].base_prio = TASK_PRIO_IDLE;
+    tasks[0].name = "idle";
+    tasks[0].cpu_time = 0;
+    tasks[0].stack_bottom = (uint32_t *) TASK_STACK_TOP;
+    tasks[0].stack_bottom[0] = STACK_GUARD;
+    current = &tasks[0];
+    stack_top = TASK_STACK_TOP;
+    switches = 0;
+    started = 0;
+    in_irq = 0;
+    irq_hook = NULL;
+}
+
+task_t *task_create(const char *name, uint32_t prio, task_fn_t fn, void *arg,
+                    uint32_t stack_size) {
+    if (prio >= TASK_PRIO_LEVELS) {
+        return NULL;
+    }
+
+    uint32_t cpsr = irq_save();
+    task_t *t = NULL;
+    for (int i = 1; i < TASK_MAX; i++) {
+        if (tasks[i].state == TASK_FREE) {
+            t = &tasks[i];
+            break;
+        }
+    }
+    stack_size = (stack_size + 7) & ~7U;
+    if ((t == NULL) || (stack_top - stack_size <= (uint32_t) &__bss_end)) {
+        irq_restore(cpsr);
+        return NULL;
+    }
+    uint32_t *top = (uint32_t *) stack_top;
+    stack_top -= stack_size;
+    t->stack_bottom = (uint32_t *) stack_top;
+    t->stack_bottom[0] = STACK_GUARD;
+
+    // initial frame restored by switch.S
+    uint32_t *sp = top - 16;
+    sp[0] = (uint32_t) arg;              // r0
+    for (int i = 1; i < 13; i++) {
+        sp[i] = 0;                       // r1-r12
+    }
+    sp[13] = (uint32_t) task_exit;       // lr
+    sp[14] = (uint32_t) fn;              // pc
+    sp[15] = TASK_INITIAL_CPSR;          // cpsr
+
+    t->sp = sp;
+    t->name = name;
+    t->prio = prio;
+    t->base_prio = prio;
+    t->event = NULL;
+    t->mutex = NULL;
+    t->cpu_time = 0;
+    t->state = TASK_READY;
+
+    // preempt the caller if the new task has a higher priority
+    if (started && !in_irq && (prio < current->prio)) {
+        context_switch(0);
+    }
+    irq_restore(cpsr);
+    return t;
+}
+
+// wake up the sleeping tasks, returns the earliest remaining wake up time
+static uint64_t wake_sleepers(uint64_t now) {
+    uint64_t next = now + TICKLESS_MAX_US;
+    for (int i = 1; i < TASK_MAX; i++) {
+        task_t *t = &tasks[i];
+        if (t->state == TASK_SLEEPING) {
+            if (now >= t->wake_time) {
+                t->state = TASK_READY;
+            } else if (t->wake_time < next) {
+                next = t->wake_time;
+            }
+        }
+    }
+    return next;
+}
+
+// highest priority ready task. if rotate is 0 the current task keeps
+// running unless a higher priority task is ready, otherwise the next
+// task of the same priority gets the CPU.
+static task_t *pick_next(int rotate) {
+    int cur = current - tasks;
+    task_t *next = &tasks[0];
+    uint32_t best = TASK_PRIO_IDLE;
+
+    for (int n = 1; n <= TASK_MAX; n++) {
+        int i = (cur + n) % TASK_MAX;
+        task_t *t = &tasks[i];
+        if ((i != 0) && (t->state == TASK_READY) && (t->prio < best)) {
+            best = t->prio;
+            next = t;
+        }
+    }
+    if (!rotate && (current != &tasks[0]) && (current->state == TASK_READY)
+        && (current->prio <= best)) {
+        next = current;
+    }
+    return next;
+}
+
+// another ready task has the same priority as t
+static int has_peer(task_t *t) {
+    for (int i = 1; i < TASK_MAX; i++) {
+        if ((&tasks[i] != t) && (tasks[i].state == TASK_READY)
+            && (tasks[i].prio == t->prio)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void program_timer(uint64_t now, uint64_t next_wake) {
+    if (sched_mode != SCHED_TICKLESS) {
+        return;
+    }
+    uint64_t deadline = next_wake;
+    if ((current != &tasks[0]) && has_peer(current)) {
+        uint64_t slice_end = slice_start + SCHED_SLICE_US;
+        if (slice_end < deadline) {
+            deadline = slice_end;
+        }
+    }
+    uint32_t delay = (deadline > now + TICKLESS_MIN_US) ?
+        (uint32_t) (deadline - now) : TICKLESS_MIN_US;
+    // writing LOD restarts the count down at once
+    ARM_TIMER_LOD = delay - 1;
+    ARM_TIMER_RLD = TICKLESS_MAX_US - 1;
+}
+
+static uint32_t *switch_to(task_t *next, int rotate, uint64_t now) {
+    current->cpu_time += now - last_account;
+    last_account = now;
+    if (next != current) {
+        switches++;
+        current = next;
+        slice_start = now;
+    } else if (rotate) {
+        // no other task of the same priority: start a new slice
+        slice_start = now;
+    }
+    return current->sp;
+}
+
+// called by context_switch() in switch.S with CPU IRQ disabled
+uint32_t *sched_switch(uint32_t *sp, int rotate) {
+    current->sp = sp;
+    uint64_t now = systime();
+    uint64_t next_wake = wake_sleepers(now);
+    task_t *next = pick_next(rotate);
+    sp = switch_to(next, rotate, now);
+    program_timer(now, next_wake);
+    return sp;
+}
+
+// called by _irq_preempt in switch.S with CPU IRQ disabled
+uint32_t *sched_irq(uint32_t *sp) {
+    current->sp = sp;
+    in_irq = 1;
+
+    int rotate = 0;
+    uint64_t now = systime();
+    if (ARM_TIMER_MIS) {
+        ARM_TIMER_CLI = 0;
+        rotate = (now - slice_start >= SCHED_SLICE_US);
+    }
+    if (irq_hook != NULL) {
+        irq_hook();
+    }
+
+    uint64_t next_wake = wake_sleepers(now);
+    task_t *next = pick_next(rotate);
+    sp = switch_to(next, rotate, now);
+    program_timer(now, next_wake);
+
+    in_irq = 0;
+    return sp;
+}
+
+void sched_start(sched_mode_t mode) {
+    sched_mode = mode;
+
+    ARM_TIMER_CTL = 0x003E0002; // timer and irq disabled, 23-bit counter
+    ARM_TIMER_DIV = 0x000000F9; // 250MHz / (249 + 1) = 1 MHz
+    if (mode == SCHED_TICK) {
+        ARM_TIMER_LOD = SCHED_TICK_US - 1;
+        ARM_TIMER_RLD = SCHED_TICK_US - 1;
+    } else {
+        ARM_TIMER_LOD = TICKLESS_MIN_US - 1;
+        ARM_TIMER_RLD = TICKLESS_MAX_US - 1;
+    }
+    ARM_TIMER_CLI = 0;
+    ARM_TIMER_CTL = 0x003E00A2; // timer and irq enabled, 23-bit counter
+
+    set_vbar(&exception_vector);
+    IRQ_ENABLE_BASIC = RPI_BASIC_ARM_TIMER_IRQ;
+
+    irq_save();
+    last_account = systime();
+    slice_start = last_account;
+    started = 1;
+    context_switch(0);
+    __asm volatile("cpsie i" ::: "memory");
+
+    // idle task
+    for (;;) {
+        // wait for interrupt
+        __asm volatile("mcr p15, 0, %0, c7, c0, 4" :: "r" (0));
+    }
+}
+
+void task_yield(void) {
+    uint32_t cpsr = irq_save();
+    context_switch(1);
+    irq_restore(cpsr);
+}
+
+void task_sleep_until(uint64_t time) {
+    uint32_t cpsr = irq_save();
+    current->wake_time = time;
+    current->state = TASK_SLEEPING;
+    context_switch(0);
+    irq_restore(cpsr);
+}
+
+void task_sleep(uint32_t usec) {
+    task_sleep_until(systime() + usec);
+}
+
+void task_exit(void) {
+    irq_save();
+    current->state = TASK_DEAD;
+    context_switch(0);
+    for (;;) {
+    }
+}
+
+task_t *task_self(void) {
+    return current;
+}
+
+task_t *task_iterate(task_t *prev) {
+    int i = (prev == NULL) ? 1 : (prev - tasks) + 1;
+    for (; i < TASK_MAX; i++) {
+        if (tasks[i].state != TASK_FREE) {
+            return &tasks[i];
+        }
+    }
+    return NULL;
+}
+
+uint64_t sched_idle_time(void) {
+    return tasks[0].cpu_time;
+}
+
+uint32_t sched_switch_count(void) {
+    return switches;
+}
+
+int task_stack_ok(const task_t *task) {
+    return task->stack_bottom[0] == STACK_GUARD;
+}
+
+void sched_set_irq_hook(sched_irq_hook_t hook) {
+    uint32_t cpsr = irq_save();
+    irq_hook = hook;
+    irq_restore(cpsr);
+}
+
+// Events
+
+void event_init(event_t *ev) {
+    ev->seq = 0;
+    ev->pending = 0;
+}
+
+void event_signal(event_t *ev) {
+    uint32_t cpsr = irq_save();
+    int preempt = 0;
+    int woken = 0;
+    ev->seq++;
+    for (int i = 1; i < TASK_MAX; i++) {
+        task_t *t = &tasks[i];
+        if ((t->state == TASK_WAITING) && (t->event == ev)) {
+            t->state = TASK_READY;
+            t->event = NULL;
+            woken = 1;
+            if (t->prio < current->prio) {
+                preempt = 1;
+            }
+        }
+    }
+    // kept for the next task_wait() only if nobody received it
+    if (!woken) {
+        ev->pending = 1;
+    }
+    // in an interrupt handler sched_irq() switches on return
+    if (preempt && !in_irq) {
+        context_switch(0);
+    }
+    irq_restore(cpsr);
+}
+
+void task_wait(event_t *ev) {
+    uint32_t cpsr = irq_save();
+    if (ev->pending) {
+        ev->pending = 0;
+    } else {
+        current->event = ev;
+        current->event_seq = ev->seq;
+        current->state = TASK_WAITING;
+        context_switch(0);
+    }
+    irq_restore(cpsr);
+}
+
+// Mutexes with priority inheritance
+
+void mutex_init(mutex_t *m) {
+    m->owner = NULL;
+}
+
+// priority of t raised by the tasks waiting for the mutexes t owns
+static uint32_t inherited_prio(task_t *t) {
+    uint32_t prio = t->base_prio;
+    for (int i = 1; i < TASK_MAX; i++) {
+        task_t *w = &tasks[i];
+        if ((w->state == TASK_BLOCKED) && (w->mutex->owner == t)
+            && (w->prio < prio)) {
+            prio = w->prio;
+        }
+    }
+    return prio;
+}
+
+void mutex_lock(mutex_t *m) {
+    uint32_t cpsr = irq_save();
+    while (m->owner != NULL) {
+        current->mutex = m;
+        current->state = TASK_BLOCKED;
+        // lend our priority to the owner, and to the owner of the
+        // mutex the owner is waiting for, and so on
+        task_t *t = m->owner;
+        while ((t != NULL) && (t->prio > current->prio)) {
+            t->prio = current->prio;
+            if (t->state != TASK_BLOCKED) {
+                break;
+            }
+            t = t->mutex->owner;
+        }
+        context_switch(0);
+    }
+    current->mutex = NULL;
+    m->owner = current;
+    // other tasks may be still waiting for this mutex
+    current->prio = inherited_prio(current);
+    irq_restore(cpsr);
+}
+
+void mutex_unlock(mutex_t *m) {
+    uint32_t cpsr = irq_save();
+    if (m->owner != current) {
+        irq_restore(cpsr);
+        return;
+    }
+    m->owner = NULL;
+
+    // wake the highest priority waiter; it takes the mutex when it runs
+    task_t *w = NULL;
+    for (int i = 1; i < TASK_MAX; i++) {
+        task_t *t = &tasks[i];
+        if ((t->state == TASK_BLOCKED) && (t->mutex == m)
+            && ((w == NULL) || (t->prio < w->prio))) {
+            w = t;
+        }
+    }
+    if (w != NULL) {
+        w->state = TASK_READY;
+        w->mutex = NULL;
+    }
+
+    // give back the inherited priority
+    current->prio = inherited_prio(current);
+    if ((w != NULL) && (w->prio < current->prio)) {
+        context_switch(0);
+    }
+    irq_restore(cpsr);
+}
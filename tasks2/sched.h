@@ -0,0 +1,106 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdint.h>
+#include "bsp.h"
+
+// Preemptive fixed-priority scheduler
+//
+// The highest priority ready task always runs. Tasks of the same
+// priority are time-sliced round robin. The ARM timer interrupt drives
+// the scheduler, either as a periodic tick (SCHED_TICK) or programmed
+// for the next wake-up or time slice only (SCHED_TICKLESS).
+// All tasks run in SVC mode; the stacks are allocated downward from
+// TASK_STACK_TOP, below the stack of main() at SVC_STACK_TOP.
+
+#define TASK_MAX          16
+#define TASK_PRIO_LEVELS  8
+#define TASK_PRIO_HIGHEST 0
+#define TASK_PRIO_IDLE    TASK_PRIO_LEVELS   // main() after sched_start()
+
+#define SVC_STACK_TOP     BSP_SVC_STACK
+#define MAIN_STACK_SIZE   0x10000
+#define TASK_STACK_TOP    (SVC_STACK_TOP - MAIN_STACK_SIZE)
+#define TASK_STACK_SIZE   0x4000
+
+#define SCHED_TICK_US     1000    // period of the tick
+#define SCHED_SLICE_US    10000   // time slice of the tasks of the same priority
+
+typedef enum {
+    SCHED_TICK = 0,
+    SCHED_TICKLESS,
+} sched_mode_t;
+
+typedef void (*task_fn_t)(void *arg);
+
+typedef enum {
+    TASK_FREE = 0,
+    TASK_READY,
+    TASK_SLEEPING,
+    TASK_WAITING,       // waiting for an event
+    TASK_BLOCKED,       // waiting for a mutex
+    TASK_DEAD,
+} task_state_t;
+
+typedef struct _task_t task_t;
+
+typedef struct _event_t {
+    volatile uint32_t seq;
+    volatile uint32_t pending;
+} event_t;
+
+typedef struct _mutex_t {
+    task_t *volatile owner;
+} mutex_t;
+
+struct _task_t {
+    uint32_t *sp;               // saved context (see switch.S)
+    task_state_t state;
+    uint32_t prio;              // effective priority (may be inherited)
+    uint32_t base_prio;         // priority given on task_create()
+    const char *name;
+    uint64_t wake_time;         // TASK_SLEEPING
+    event_t *event;             // TASK_WAITING
+    uint32_t event_seq;
+    mutex_t *mutex;             // TASK_BLOCKED
+    uint64_t cpu_time;          // usec spent running
+    uint32_t *stack_bottom;
+};
+
+void sched_init(void);
+
+// returns NULL if no task slot or stack space is left
+task_t *task_create(const char *name, uint32_t prio, task_fn_t fn, void *arg,
+                    uint32_t stack_size);
+
+// start the scheduler; main() becomes the idle task and never returns
+void sched_start(sched_mode_t mode) __attribute__((noreturn));
+
+void task_yield(void);
+void task_sleep_until(uint64_t time);
+void task_sleep(uint32_t usec);
+void task_exit(void) __attribute__((noreturn));
+task_t *task_self(void);
+
+// returns the tasks one by one for statistics, NULL at the end
+task_t *task_iterate(task_t *prev);
+uint64_t sched_idle_time(void);
+uint32_t sched_switch_count(void);
+int task_stack_ok(const task_t *task);
+
+// event_signal() can be called from interrupt handlers
+void event_init(event_t *ev);
+void event_signal(event_t *ev);
+void task_wait(event_t *ev);
+
+// mutex with priority inheritance: while a task waits for a mutex,
+// the owner runs at the priority of the waiter if it is higher
+void mutex_init(mutex_t *m);
+void mutex_lock(mutex_t *m);
+void mutex_unlock(mutex_t *m);
+
+// called for the interrupts other than the ARM timer
+typedef void (*sched_irq_hook_t)(void);
+void sched_set_irq_hook(sched_irq_hook_t hook);
+
+#endif
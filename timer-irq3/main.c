@@ -0,0 +1,254 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bsp.h"
+#include "ring.h"
+
+// ldr pc, [pc, #24]
+#define	JMP_PC_24	0xe59ff018
+
+typedef void (*exception_hander_t)(void);
+
+typedef struct __attribute__((aligned(32))) _vector_table_t {
+    const unsigned int vector[8]; // all elements shoud be JMP_PC_24
+    exception_hander_t reset;
+    exception_hander_t undef;
+    exception_hander_t svc;
+    exception_hander_t prefetch_abort;
+    exception_hander_t data_abort;
+    exception_hander_t hypervisor_trap;
+    exception_hander_t irq;
+    exception_hander_t fiq;
+} vector_table_t;
+
+static void __attribute__((interrupt("UNDEF"))) undef_handler(void);
+static void __attribute__((interrupt("SWI"))) svc_handler(void);
+static void __attribute__((interrupt("ABORT"))) abort_handler(void);
+static void __attribute__((interrupt("IRQ"))) irq_handler(void);
+static void __attribute__((interrupt("FIQ"))) fiq_handler(void);
+static void __attribute__((naked)) hangup(void);
+
+static vector_table_t exception_vector = { \
+    .vector = { JMP_PC_24, JMP_PC_24, JMP_PC_24, JMP_PC_24, \
+                JMP_PC_24, JMP_PC_24, JMP_PC_24, JMP_PC_24 },
+    .reset = Init_Machine,
+    .undef = undef_handler,
+    .svc = svc_handler,
+    .prefetch_abort = abort_handler,
+    .data_abort = abort_handler,
+    .hypervisor_trap = hangup,
+    .irq = irq_handler,
+    .fiq = hangup
+};
+
+void set_vbar(vector_table_t *base) {
+    __asm volatile ("mcr p15, 0, %[base], c12, c0, 0"
+                  :: [base] "r" (base));
+}
+
+#define IRQ_BASIC         IOREG(0x2000B200)
+#define IRQ_PEND1         IOREG(0x2000B204)
+#define IRQ_PEND2         IOREG(0x2000B208)
+#define IRQ_FIQ_CONTROL   IOREG(0x2000B20C)
+#define IRQ_ENABLE1       IOREG(0x2000B210)
+#define IRQ_ENABLE2       IOREG(0x2000B214)
+#define IRQ_ENABLE_BASIC  IOREG(0x2000B218)
+#define IRQ_DISABLE1      IOREG(0x2000B21C)
+#define IRQ_DISABLE2      IOREG(0x2000B220)
+#define IRQ_DISABLE_BASIC IOREG(0x2000B224)
+
+#define IRQ_TIMER_C1  (1 << 1)
+#define IRQ_TIMER_C3  (1 << 3)
+
+// interrupt periods in usec
+#define PERIOD_C1  50
+#define PERIOD_C3  70
+
+// an item tells its producer (upper 8 bits) and sequence number
+#define ITEM(id, seq)   (((id) << 24) | ((seq) & 0xffffffU))
+#define ITEM_ID(v)      ((v) >> 24)
+#define ITEM_SEQ(v)     ((v) & 0xffffffU)
+
+#define PRODUCERS  3    // 0: main loop, 1: timer 1, 2: timer 3
+
+SPSC_RING_DEFINE(spsc_ring, uint32_t, 16)
+MPSC_RING_DEFINE(mpsc_ring, uint32_t, 32)
+
+static spsc_ring_t ring1;
+static spsc_ring_t ring3;
+static mpsc_ring_t shared;
+
+// written by each producer only
+static volatile uint32_t produced[PRODUCERS];
+static volatile uint32_t dropped[PRODUCERS];
+static volatile uint32_t dropped1;
+static volatile uint32_t dropped3;
+
+static void __attribute__((interrupt("UNDEF"))) undef_handler(void) {
+}
+
+static void __attribute__((interrupt("SWI"))) svc_handler(void) {
+}
+
+static void __attribute__((interrupt("ABORT"))) abort_handler(void) {
+}
+
+static uint32_t next_compare(uint32_t compare, uint32_t period) {
+    uint32_t next = compare + period;
+    // do not lose the timer when the handler is late
+    if ((int32_t) (next - SYST_CLO) < 10) {
+        next = SYST_CLO + 10;
+    }
+    return next;
+}
+
+static void produce(int id, spsc_ring_t *ring, volatile uint32_t *ring_dropped) {
+    uint32_t seq = produced[id];
+    uint32_t v = ITEM(id, seq);
+    if (ring != NULL && !spsc_ring_push(ring, &v)) {
+        (*ring_dropped)++;
+    }
+    if (!mpsc_ring_push(&shared, &v)) {
+        dropped[id]++;
+    }
+    produced[id] = seq + 1;
+}
+
+static void __attribute__((interrupt("IRQ"))) irq_handler(void) {
+    if (IRQ_PEND1 & IRQ_TIMER_C1) {
+        SYST_C1 = next_compare(SYST_C1, PERIOD_C1);
+        SYST_CS = IRQ_TIMER_C1;
+        produce(1, &ring1, &dropped1);
+    }
+    if (IRQ_PEND1 & IRQ_TIMER_C3) {
+        SYST_C3 = next_compare(SYST_C3, PERIOD_C3);
+        SYST_CS = IRQ_TIMER_C3;
+        produce(2, &ring3, &dropped3);
+    }
+}
+
+//static void __attribute__((interrupt("FIQ"))) fiq_handler(void) {
+static void __attribute__((interrupt("IRQ"))) fiq_handler(void) {
+}
+
+static void __attribute__((naked)) hangup(void) {
+  while(1) {
+  }
+}
+
+// consumer side state
+static uint32_t received[PRODUCERS];
+static uint32_t expected[PRODUCERS];
+static uint32_t gaps[PRODUCERS];
+static uint32_t order_errors;
+static uint32_t spsc_expected1;
+static uint32_t spsc_expected3;
+static uint32_t spsc_errors;
+
+// items of one producer arrive in order; a gap is allowed only
+// when the producer dropped items
+static void check_shared(uint32_t v) {
+    uint32_t id = ITEM_ID(v);
+    if (id >= PRODUCERS) {
+        order_errors++;
+        return;
+    }
+    uint32_t seq = ITEM_SEQ(v);
+    if (seq != expected[id]) {
+        if (((seq - expected[id]) & 0xffffffU) > 0x800000U) {
+            order_errors++;
+        } else {
+            gaps[id] += (seq - expected[id]) & 0xffffffU;
+        }
+    }
+    expected[id] = (seq + 1) & 0xffffffU;
+    received[id]++;
+}
+
+// the sequence is 24bit: a number behind the expected one modulo 2^24
+// is out of order, one ahead of it is a gap from dropped items
+static void check_spsc(uint32_t v, uint32_t *exp) {
+    uint32_t seq = ITEM_SEQ(v);
+    if (((seq - *exp) & 0xffffffU) > 0x800000U) {
+        spsc_errors++;
+    }
+    *exp = (seq + 1) & 0xffffffU;
+}
+
+int main(int argc, char **argv) {
+  const char msg[] = "Lock-free ring buffer test.\012\015\000";
+
+  // disable IRQ
+  IRQ_DISABLE_BASIC = 1;
+  
+  uart_init(UART_BAUD);
+
+  // type message
+  for(int i = 0; msg[i]; i++) {
+    uart_putchar(msg[i]);
+    delay_ms(100);
+  }
+
+  MU_IIR = 0xC6; // enable FIFO(0xC0), clear FIFO(0x06)
+
+  spsc_ring_init(&ring1);
+  spsc_ring_init(&ring3);
+  mpsc_ring_init(&shared);
+
+  // set timer
+  int now = SYST_CLO;
+  SYST_C1 = now + 1000000;
+  SYST_C3 = now + 1000100;
+  
+  // enable IRQ
+  set_vbar(&exception_vector);
+  IRQ_ENABLE1 = (IRQ_TIMER_C1 | IRQ_TIMER_C3);
+  __asm volatile("mrs r0, cpsr \n"
+                 "bic r0, r0, #0x80 \n"
+                 "msr cpsr_c, r0 \n");
+
+  uart_print("producer produced received dropped gaps\012\015");
+  uint64_t report = systime() + 1000000;
+  while (1) {
+    uint32_t v;
+
+    // the main loop is a producer of the shared ring too
+    produce(0, NULL, NULL);
+
+    while (mpsc_ring_pop(&shared, &v)) {
+      check_shared(v);
+    }
+    while (spsc_ring_pop(&ring1, &v)) {
+      check_spsc(v, &spsc_expected1);
+    }
+    while (spsc_ring_pop(&ring3, &v)) {
+      check_spsc(v, &spsc_expected3);
+    }
+
+    if (systime() >= report) {
+      report += 1000000;
+      for (int i = 0; i < PRODUCERS; i++) {
+        uart_put_dec(i);
+        uart_putchar(' ');
+        uart_put_dec(produced[i]);
+        uart_putchar(' ');
+        uart_put_dec(received[i]);
+        uart_putchar(' ');
+        uart_put_dec(dropped[i]);
+        uart_putchar(' ');
+        uart_put_dec(gaps[i]);
+        uart_print("\012\015");
+      }
+      uart_print("order errors ");
+      uart_put_dec(order_errors);
+      uart_print(" spsc errors ");
+      uart_put_dec(spsc_errors);
+      uart_print(" spsc dropped ");
+      uart_put_dec(dropped1 + dropped3);
+      uart_print("\012\015");
+    }
+  }
+
+  return 0;
+}
+
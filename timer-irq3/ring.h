@@ -0,0 +1,132 @@
+#ifndef RING_H
+#define RING_H
+
+// Bounded lock-free ring buffers for interrupt-to-task communication
+//
+// SPSC_RING_DEFINE(name, type, len)
+//   one producer and one consumer, wait-free on both sides.
+// MPSC_RING_DEFINE(name, type, len)
+//   any number of producers (interrupt handlers of any priority and
+//   tasks) and one consumer. Producers reserve a slot with ldrex/strex,
+//   the consumer is wait-free. A producer preempted between reserving
+//   and publishing its slot only delays the consumer, it never blocks
+//   the other producers.
+//
+// len must be a power of 2. The producer and consumer indexes live in
+// separate cache lines. push returns 0 if the ring is full, pop returns
+// 0 if it is empty.
+//
+//   SPSC_RING_DEFINE(rx_ring, uint8_t, 64)
+//   static rx_ring_t rx;
+//   rx_ring_init(&rx);
+//   rx_ring_push(&rx, &c);      // in the interrupt handler
+//   rx_ring_pop(&rx, &c);       // in the main loop
+
+#include <stdint.h>
+#include "atomic.h"
+
+#define RING_CACHE_LINE  32     // ARM1176 L1 cache line
+#define RING_ALIGNED     __attribute__((aligned(RING_CACHE_LINE)))
+
+#define SPSC_RING_DEFINE(name, type, len)                                 \
+typedef struct _##name##_t {                                              \
+    volatile uint32_t head RING_ALIGNED;  /* written by the producer */   \
+    volatile uint32_t tail RING_ALIGNED;  /* written by the consumer */   \
+    type buf[len] RING_ALIGNED;                                           \
+} name##_t;                                                               \
+                                                                          \
+static inline void name##_init(name##_t *r) {                             \
+    r->head = 0;                                                          \
+    r->tail = 0;                                                          \
+}                                                                         \
+                                                                          \
+static inline int name##_push(name##_t *r, const type *v) {               \
+    uint32_t h = r->head;                                                 \
+    if (h - r->tail >= (len)) {                                           \
+        return 0;                                                         \
+    }                                                                     \
+    r->buf[h & ((len) - 1)] = *v;                                         \
+    dmb();                                                                \
+    r->head = h + 1;                                                      \
+    return 1;                                                             \
+}                                                                         \
+                                                                          \
+static inline int name##_pop(name##_t *r, type *v) {                      \
+    uint32_t t = r->tail;                                                 \
+    if (t == r->head) {                                                   \
+        return 0;                                                         \
+    }                                                                     \
+    dmb();                                                                \
+    *v = r->buf[t & ((len) - 1)];                                         \
+    dmb();                                                                \
+    r->tail = t + 1;                                                      \
+    return 1;                                                             \
+}                                                                         \
+                                                                          \
+static inline uint32_t name##_count(name##_t *r) {                        \
+    return r->head - r->tail;                                             \
+}
+
+// Each slot has a sequence number: seq == pos means the slot is free
+// for the producer of position pos, seq == pos + 1 means it holds the
+// item of position pos for the consumer.
+#define MPSC_RING_DEFINE(name, type, len)                                 \
+typedef struct _##name##_slot_t {                                         \
+    volatile uint32_t seq;                                                \
+    type value;                                                           \
+} name##_slot_t;                                                          \
+                                                                          \
+typedef struct _##name##_t {                                              \
+    volatile uint32_t head RING_ALIGNED;  /* next position to reserve */  \
+    volatile uint32_t tail RING_ALIGNED;  /* next position to pop */      \
+    name##_slot_t slot[len] RING_ALIGNED;                                 \
+} name##_t;                                                               \
+                                                                          \
+static inline void name##_init(name##_t *r) {                             \
+    for (uint32_t i = 0; i < (len); i++) {                                \
+        r->slot[i].seq = i;                                               \
+    }                                                                     \
+    r->head = 0;                                                          \
+    r->tail = 0;                                                          \
+}                                                                         \
+                                                                          \
+static inline int name##_push(name##_t *r, const type *v) {               \
+    name##_slot_t *s;                                                     \
+    uint32_t pos = r->head;                                               \
+    for (;;) {                                                            \
+        s = &r->slot[pos & ((len) - 1)];                                  \
+        int32_t dif = (int32_t) (s->seq - pos);                           \
+        if (dif == 0) {                                                   \
+            if (cas32(&r->head, pos, pos + 1)) {                          \
+                break;                                                    \
+            }                                                             \
+        } else if (dif < 0) {                                             \
+            return 0;                                                     \
+        }                                                                 \
+        pos = r->head;                                                    \
+    }                                                                     \
+    s->value = *v;                                                        \
+    dmb();                                                                \
+    s->seq = pos + 1;                                                     \
+    return 1;                                                             \
+}                                                                         \
+                                                                          \
+static inline int name##_pop(name##_t *r, type *v) {                      \
+    uint32_t t = r->tail;                                                 \
+    name##_slot_t *s = &r->slot[t & ((len) - 1)];                         \
+    if (s->seq != t + 1) {                                                \
+        return 0;                                                         \
+    }                                                                     \
+    dmb();                                                                \
+    *v = s->value;                                                        \
+    dmb();                                                                \
+    s->seq = t + (len);                                                   \
+    r->tail = t + 1;                                                      \
+    return 1;                                                             \
+}                                                                         \
+                                                                          \
+static inline uint32_t name##_count(name##_t *r) {                        \
+    return r->head - r->tail;                                             \
+}
+
+#endif
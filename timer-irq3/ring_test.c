@@ -0,0 +1,127 @@
+// Host stress test of ring.h with threads
+//
+//   make test
+//
+// SPSC: one producer thread and the consumer (main thread) pass
+// sequence numbers through a small ring. MPSC: several producer threads
+// push (id, sequence) items into a shared ring. The consumer checks that
+// every item arrives exactly once and in order for each producer.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "ring.h"
+
+#define ITEMS      1000000U
+#define PRODUCERS  4
+
+#define ITEM(id, seq)   (((uint32_t) (id) << 24) | ((seq) & 0xffffffU))
+#define ITEM_ID(v)      ((v) >> 24)
+#define ITEM_SEQ(v)     ((v) & 0xffffffU)
+
+SPSC_RING_DEFINE(spsc_ring, uint32_t, 16)
+MPSC_RING_DEFINE(mpsc_ring, uint32_t, 32)
+
+static spsc_ring_t spsc;
+static mpsc_ring_t mpsc;
+
+static void *spsc_producer(void *arg) {
+    for (uint32_t i = 0; i < ITEMS; i++) {
+        while (!spsc_ring_push(&spsc, &i)) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void *mpsc_producer(void *arg) {
+    uint32_t id = (uint32_t) (uintptr_t) arg;
+    for (uint32_t i = 0; i < ITEMS; i++) {
+        uint32_t v = ITEM(id, i);
+        while (!mpsc_ring_push(&mpsc, &v)) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static int test_spsc(void) {
+    pthread_t th;
+    uint32_t expected = 0;
+    uint32_t v;
+    int errors = 0;
+
+    spsc_ring_init(&spsc);
+    pthread_create(&th, NULL, spsc_producer, NULL);
+    while (expected < ITEMS) {
+        if (!spsc_ring_pop(&spsc, &v)) {
+            sched_yield();
+            continue;
+        }
+        if (v != expected) {
+            if (errors++ < 10) {
+                printf("spsc: %u, expected %u\n", v, expected);
+            }
+        }
+        expected = v + 1;
+    }
+    pthread_join(th, NULL);
+    if (spsc_ring_pop(&spsc, &v)) {
+        printf("spsc: extra item %u\n", v);
+        errors++;
+    }
+    printf("spsc: %u items, %d errors\n", ITEMS, errors);
+    return errors;
+}
+
+static int test_mpsc(void) {
+    pthread_t th[PRODUCERS];
+    uint32_t expected[PRODUCERS] = {0};
+    uint32_t total = 0;
+    uint32_t v;
+    int errors = 0;
+
+    mpsc_ring_init(&mpsc);
+    for (uintptr_t id = 0; id < PRODUCERS; id++) {
+        pthread_create(&th[id], NULL, mpsc_producer, (void *) id);
+    }
+    while (total < PRODUCERS * ITEMS) {
+        if (!mpsc_ring_pop(&mpsc, &v)) {
+            sched_yield();
+            continue;
+        }
+        total++;
+        uint32_t id = ITEM_ID(v);
+        if (id >= PRODUCERS) {
+            if (errors++ < 10) {
+                printf("mpsc: bad item %08x\n", v);
+            }
+            continue;
+        }
+        if (ITEM_SEQ(v) != ITEM_SEQ(expected[id])) {
+            if (errors++ < 10) {
+                printf("mpsc: producer %u: %u, expected %u\n",
+                       id, ITEM_SEQ(v), ITEM_SEQ(expected[id]));
+            }
+        }
+        expected[id] = ITEM_SEQ(v) + 1;
+    }
+    for (int id = 0; id < PRODUCERS; id++) {
+        pthread_join(th[id], NULL);
+    }
+    if (mpsc_ring_pop(&mpsc, &v)) {
+        printf("mpsc: extra item %08x\n", v);
+        errors++;
+    }
+    printf("mpsc: %d producers x %u items, %d errors\n", PRODUCERS, ITEMS, errors);
+    return errors;
+}
+
+int main(int argc, char **argv) {
+    int errors = test_spsc() + test_mpsc();
+    printf("%s\n", errors ? "FAIL" : "OK");
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -328,6 +328,7 @@ int	vsscanf (const char *str, const char *format, va_list arg)
 		if (*format == '%')											// Format is a specifier otherwise its a literal
 		{
 			format++;												// Advance format pointer
+			base = 10;												// Default base of each specifier
 			if (*format == '*') {									// Check for dont store flag
 				dontStore = true;									// Set dont store flag
 				tp++;												// Next character
@@ -391,10 +392,8 @@ int	vsscanf (const char *str, const char *format, va_list arg)
 				break;
 			}
 
-			/* unsigned/hex/octal and pointer find start */
+			/* unsigned/octal and pointer find start */
 			case 'u':
-			case 'x':
-			case 'X':
 			case 'o':
 			case 'p':
 			{
@@ -403,6 +402,15 @@ int	vsscanf (const char *str, const char *format, va_list arg)
 				break;
 			}
 
+			/* hex find start */
+			case 'x':
+			case 'X':
+			{
+				// We are looking for  hex digit to start number
+				while (!isxdigit(*tp) && (*tp != '\0'))  tp++;
+				break;
+			}
+
 
 			/* Floats/double/double double find start */
 			case 'a':
@@ -427,8 +435,6 @@ int	vsscanf (const char *str, const char *format, va_list arg)
 
 				spos = tp;											// String match starts here
 				tp++;												// Move to next character
-
-				if (*tp == '\0') return(count);						// End of string reached
 			}
 			else {
 				if (*format == '\0') return(count);					// End of format reached
@@ -489,6 +495,8 @@ int	vsscanf (const char *str, const char *format, va_list arg)
 			case 'X':
 			{
 				base = 16;													// Set base to 16
+				if (*spos == '0' && (*tp == 'x' || *tp == 'X'))
+					tp++;													// Optional 0x prefix, strtoul skips it
 				while (isdigit(*tp) || (*tp >= 'a' && *tp <= 'f')
 					|| (*tp >= 'A' && *tp <= 'F'))  tp++;					// keep advancing so long as 0-9, a-f, A-F
 				break;
@@ -0,0 +1,119 @@
+// Host test of the formatting of emb-stdio.c
+//
+//   make test
+//
+// emb_sprintf() is compared with snprintf() of the host libc for the
+// conversions used by the examples. emb-stdio.c is built with its printf,
+// sscanf and vsscanf renamed (see the Makefile) and printf() goes to
+// Embedded_Console_WriteChar() of this file.
+//
+// long and pointers are 64 bits on the host and 32 bits on the target,
+// %ld and %p are not compared. Known differences from libc which are
+// not tested: %p is upper case without 0x, %.0d of 0 prints "0" and
+// %#o of 0 prints "00".
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int emb_sprintf(char *buf, const char *fmt, ...);
+int emb_printf(const char *fmt, ...);
+int emb_sscanf(const char *str, const char *format, ...);
+
+static char console[256];
+static int console_len;
+
+void Embedded_Console_WriteChar(char ch) {
+    if (console_len < sizeof(console) - 1) {
+        console[console_len++] = ch;
+    }
+}
+
+static int errors;
+static int tests;
+
+#define T(fmt, ...) test(__LINE__, fmt, \
+    emb_sprintf(out, fmt, __VA_ARGS__), snprintf(ref, sizeof(ref), fmt, __VA_ARGS__))
+
+static char out[256];
+static char ref[256];
+
+static void test(int line, const char *fmt, int n, int n_ref) {
+    tests++;
+    if ((n != n_ref) || strcmp(out, ref)) {
+        printf("line %d: \"%s\": \"%s\" (%d), expected \"%s\" (%d)\n",
+               line, fmt, out, n, ref, n_ref);
+        errors++;
+    }
+}
+
+static void test_sprintf(void) {
+    int pos = 0;
+    int pos_ref = 0;
+
+    T("%d %d %d", 0, 12345, -12345);
+    T("%d %d", INT32_MAX, INT32_MIN);
+    T("%i|%5d|%-5d|%05d|%+d|% d", 7, 42, 42, -42, 42, 42);
+    T("%u %u", 0U, UINT32_MAX);
+    T("%x %X %08x %#x %#X", 0xbeefU, 0xbeefU, 0x1aU, 0x1aU, 0xffffffffU);
+    T("%o %#o %6o", 8U, 8U, 0777U);
+    T("%hd %hu %hx", 70000, 70000, 0x12345);
+    T("%.3d|%8.3d|%-8.3d|", 5, -5, 5);
+    T("%s|%8s|%-8s|%.3s|%8.2s|", "abcd", "abcd", "abcd", "abcd", "abcd");
+    T("%*d|%-*d|%.*s|", 6, 1, 6, 1, 2, "xyz");
+    T("%c%c%3c%-3c|", 'a', 'b', 'c', 'd');
+    T("100%% %s", "");
+    T("BENCH %s %u %s", "memcpy", 123456U, "KB/s");
+    T("%s", "no conversions");
+
+    emb_sprintf(out, "ab%ncd", &pos);
+    snprintf(ref, sizeof(ref), "ab%ncd", &pos_ref);
+    tests++;
+    if (pos != pos_ref) {
+        printf("%%n: %d, expected %d\n", pos, pos_ref);
+        errors++;
+    }
+}
+
+static void test_printf(void) {
+    int n = emb_printf("%s=%04x\n", "reg", 0x2aU);
+
+    tests++;
+    console[console_len] = '\0';
+    if ((n != 9) || strcmp(console, "reg=002a\n")) {
+        printf("printf: \"%s\" (%d)\n", console, n);
+        errors++;
+    }
+}
+
+static void test_sscanf(void) {
+    int d = 0;
+    unsigned x = 0;
+    char s[16] = "";
+    int n = emb_sscanf("key -123 0x1f end", "%s %d %x", s, &d, &x);
+
+    tests++;
+    if ((n != 3) || strcmp(s, "key") || (d != -123) || (x != 0x1f)) {
+        printf("sscanf: %d \"%s\" %d %x\n", n, s, d, x);
+        errors++;
+    }
+
+    // %x starting with a letter, %d after %x is decimal again, a one
+    // digit number at the end
+    n = emb_sscanf("ff 5", "%x %d", &x, &d);
+    tests++;
+    if ((n != 2) || (x != 0xff) || (d != 5)) {
+        printf("sscanf: %d %x %d\n", n, x, d);
+        errors++;
+    }
+}
+
+int main(int argc, char **argv) {
+    test_sprintf();
+    test_printf();
+    test_sscanf();
+    printf("%d tests, %d errors\n", tests, errors);
+    printf("%s\n", errors ? "FAIL" : "OK");
+    return errors ? EXIT_FAILURE : EXIT_SUCCESS;
+}
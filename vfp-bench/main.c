@@ -0,0 +1,289 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bsp.h"
+#include "vfp.h"
+
+// ldr pc, [pc, #24]
+#define	JMP_PC_24	0xe59ff018
+
+typedef void (*exception_hander_t)(void);
+
+typedef struct __attribute__((aligned(32))) _vector_table_t {
+    const unsigned int vector[8]; // all elements shoud be JMP_PC_24
+    exception_hander_t reset;
+    exception_hander_t undef;
+    exception_hander_t svc;
+    exception_hander_t prefetch_abort;
+    exception_hander_t data_abort;
+    exception_hander_t hypervisor_trap;
+    exception_hander_t irq;
+    exception_hander_t fiq;
+} vector_table_t;
+
+// irq.S, calls irq_handler
+void _irq_handler_stub(void);
+static void __attribute__((naked)) hangup(void);
+
+static vector_table_t exception_vector = { \
+    .vector = { JMP_PC_24, JMP_PC_24, JMP_PC_24, JMP_PC_24, \
+                JMP_PC_24, JMP_PC_24, JMP_PC_24, JMP_PC_24 },
+    .reset = Init_Machine,
+#ifdef USE_VFP
+    .undef = vfp_undef_handler,
+#else
+    .undef = hangup,
+#endif
+    .svc = hangup,
+    .prefetch_abort = hangup,
+    .data_abort = hangup,
+    .hypervisor_trap = hangup,
+    .irq = _irq_handler_stub,
+    .fiq = hangup
+};
+
+void set_vbar(vector_table_t *base) {
+    __asm volatile ("mcr p15, 0, %[base], c12, c0, 0"
+                    :: [base] "r" (base));
+}
+
+#define IRQ_BASIC         IOREG(0x2000B200)
+#define IRQ_PEND1         IOREG(0x2000B204)
+#define IRQ_ENABLE1       IOREG(0x2000B210)
+#define IRQ_DISABLE_BASIC IOREG(0x2000B224)
+
+#define IRQ_TIMER_C1  (1 << 1)
+
+// 1ms tick which uses float, to exercise the VFP context switch
+static volatile uint32_t ticks;
+static volatile float tick_sec;
+
+static void tick(void) {
+    tick_sec += 0.001f;
+    ticks++;
+}
+
+// called from _irq_handler_stub with VFP disabled (VFP=1)
+void irq_handler(void) {
+    if (IRQ_PEND1 & IRQ_TIMER_C1) {
+        tick();
+        SYST_C1 = SYST_C1 + 1000;
+        SYST_CS = (1 << 1);
+    }
+}
+
+static void __attribute__((naked)) hangup(void) {
+  while(1) {
+  }
+}
+
+// Cycle counter of ARM1176 (Performance Monitor Control Register)
+
+static inline void ccnt_start(void) {
+    // enable counters (E), reset count registers (P) and cycle counter (C)
+    __asm volatile("mcr p15, 0, %0, c15, c12, 0" :: "r" (7));
+}
+
+static inline uint32_t ccnt_read(void) {
+    uint32_t c;
+    __asm volatile("mrc p15, 0, %0, c15, c12, 1" : "=r" (c));
+    return c;
+}
+
+static void enable_icache(void) {
+    uint32_t c1;
+    __asm volatile("mrc p15, 0, %0, c1, c0, 0" : "=r" (c1));
+    c1 |= (1 << 12) | (1 << 11);    // I-cache, branch prediction
+    __asm volatile("mcr p15, 0, %0, c1, c0, 0" :: "r" (c1));
+}
+
+// Float benchmarks
+
+#define SIGNAL_LEN  1024
+#define MAT_N       16
+
+static float signal[SIGNAL_LEN];
+static float mat_a[MAT_N][MAT_N];
+static float mat_b[MAT_N][MAT_N];
+static float mat_c[MAT_N][MAT_N];
+
+// 2nd order Butterworth lowpass, fc = fs / 16
+static float biquad(void) {
+    const float b0 = 0.0300882f, b1 = 0.0601764f, b2 = 0.0300882f;
+    const float a1 = -1.4542436f, a2 = 0.5745964f;
+    float x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+    float sum = 0;
+
+    for (int i = 0; i < SIGNAL_LEN; i++) {
+        float x = signal[i];
+        float y = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = y;
+        sum += y;
+    }
+    return sum;
+}
+
+static float matmul(void) {
+    float sum = 0;
+    for (int i = 0; i < MAT_N; i++) {
+        for (int j = 0; j < MAT_N; j++) {
+            float acc = 0;
+            for (int k = 0; k < MAT_N; k++) {
+                acc += mat_a[i][k] * mat_b[k][j];
+            }
+            mat_c[i][j] = acc;
+            sum += acc;
+        }
+    }
+    return sum;
+}
+
+// sin by a polynomial and sqrt by Newton's method
+static float poly_sqrt(void) {
+    float sum = 0;
+    for (int i = 0; i < SIGNAL_LEN; i++) {
+        float x = signal[i];
+        float x2 = x * x;
+        float s = x * (1.0f - x2 * (0.16666667f - x2 * (0.00833333f - x2 * 0.00019841f)));
+        float v = 1.0f + x2;
+        float r = v;
+        for (int n = 0; n < 4; n++) {
+            r = 0.5f * (r + v / r);
+        }
+        sum += s + r;
+    }
+    return sum;
+}
+
+typedef struct _bench_t {
+    const char *name;
+    const char *key;            // name of the result for make bench
+    float (*func)(void);
+    uint32_t flops;             // per call
+} bench_t;
+
+static const bench_t benches[] = {
+    { "biquad ", "biquad", biquad, SIGNAL_LEN * 10 },
+    { "matmul ", "matmul", matmul, MAT_N * MAT_N * (MAT_N * 2 + 1) },
+    { "sin/sqrt", "sin_sqrt", poly_sqrt, SIGNAL_LEN * 22 },
+};
+
+#define NUM_BENCHES  (sizeof(benches) / sizeof(benches[0]))
+#define BENCH_TIME   200000     // us for each result of make bench
+
+// run all, returns a checksum of the results
+static uint32_t run_benches(int print) {
+    uint32_t check = 0;
+
+    for (int i = 0; i < NUM_BENCHES; i++) {
+        ccnt_start();
+        float r = benches[i].func();
+        uint32_t cycles = ccnt_read();
+        union { float f; uint32_t u; } v = { .f = r };
+        check = check * 31 + v.u;
+        if (print) {
+            uart_print(benches[i].name);
+            uart_putchar(' ');
+            uart_put_dec(cycles);
+            uart_putchar(' ');
+            uart_put_dec(cycles / benches[i].flops);
+            uart_putchar(' ');
+            // MFLOPS at 700MHz
+            uart_put_dec((uint64_t) benches[i].flops * 700 / cycles);
+            uart_print("\r\n");
+        }
+    }
+    return check;
+}
+
+// results for make bench (bsp/README.md) as calls per second measured
+// with the system timer: QEMU does not count the cycles of the ARM1176
+static void bench_results(void) {
+    for (int i = 0; i < NUM_BENCHES; i++) {
+        uint32_t n = 0;
+        uint32_t start = SYST_CLO;
+        uint32_t t;
+
+        do {
+            benches[i].func();
+            n++;
+        } while ((t = SYST_CLO - start) < BENCH_TIME);
+        uart_printf("BENCH %s %u call/s\r\n", benches[i].key,
+                    (uint32_t) ((uint64_t) n * 1000000 / t));
+    }
+}
+
+int main(int argc, char **argv) {
+  // disable IRQ
+  IRQ_DISABLE_BASIC = 1;
+
+  uart_init(UART_BAUD);
+
+  enable_icache();
+#ifdef USE_VFP
+  uart_print("\r\nFloat benchmark: VFP hard float\r\n");
+#else
+  uart_print("\r\nFloat benchmark: soft float\r\n");
+#endif
+
+  // test data
+  for (int i = 0; i < SIGNAL_LEN; i++) {
+      signal[i] = (float) ((i * 37) % 200 - 100) / 100.0f;
+  }
+  for (int i = 0; i < MAT_N; i++) {
+      for (int j = 0; j < MAT_N; j++) {
+          mat_a[i][j] = (float) (i - j) * 0.25f;
+          mat_b[i][j] = (float) (i + j) * 0.125f;
+      }
+  }
+
+  uart_print("name     cycles cycles/flop MFLOPS\r\n");
+  uint32_t check = run_benches(1);
+  bench_results();
+
+  // run again with a float interrupt every 1ms, the results must be
+  // the same if the context of the interrupted code is kept
+  set_vbar(&exception_vector);
+  SYST_C1 = SYST_CLO + 1000;
+  IRQ_ENABLE1 = IRQ_TIMER_C1;
+  __asm volatile("mrs r0, cpsr \n"
+                 "bic r0, r0, #0x80 \n"
+                 "msr cpsr_c, r0 \n");
+
+  uint32_t errors = 0;
+  uint64_t end = systime() + 2000000;
+  uint32_t runs = 0;
+  while (systime() < end) {
+      if (run_benches(0) != check) {
+          errors++;
+      }
+      runs++;
+  }
+  uart_put_dec(runs);
+  uart_print(" runs with interrupts, ");
+  uart_put_dec(errors);
+  uart_print(" errors, ");
+  uart_put_dec(ticks);
+  uart_print(" ticks (");
+  uart_put_dec((uint32_t) (tick_sec * 1000.0f));
+  uart_print("ms)");
+#ifdef USE_VFP
+  uart_print(", ");
+  uart_put_dec(vfp_lazy_saves);
+  uart_print(" VFP context saves");
+#endif
+  uart_print("\r\n");
+
+  // a changed result fails make bench: no end line
+  uart_printf("BENCH irq_runs %u run/s\r\n", runs / 2);
+  if (errors == 0) {
+      uart_print("BENCH end\r\n");
+  }
+  delay_ms(10);   // let the FIFO drain before the reset
+  power_reset();
+
+  return 0;
+}
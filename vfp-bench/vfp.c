@@ -0,0 +1,79 @@
+#include <stdint.h>
+#include "vfp.h"
+
+#ifdef USE_VFP
+
+typedef struct _vfp_context_t {
+    uint64_t d[16];
+    uint32_t fpscr;
+} vfp_context_t;
+
+// interrupts are not nested, one context is enough
+static vfp_context_t irq_ctx;
+static volatile int irq_active;
+static volatile int irq_saved;
+volatile uint32_t vfp_lazy_saves;
+
+static inline uint32_t get_fpexc(void) {
+    uint32_t v;
+    __asm volatile("vmrs %0, fpexc" : "=r" (v));
+    return v;
+}
+
+static inline void set_fpexc(uint32_t v) {
+    __asm volatile("vmsr fpexc, %0" :: "r" (v) : "memory");
+}
+
+static void save_context(vfp_context_t *c) {
+    uint32_t fpscr;
+    __asm volatile("vstmia %0, {d0-d15}" :: "r" (c->d) : "memory");
+    __asm volatile("vmrs %0, fpscr" : "=r" (fpscr));
+    c->fpscr = fpscr;
+}
+
+static void restore_context(vfp_context_t *c) {
+    __asm volatile("vldmia %0, {d0-d15}" :: "r" (c->d) : "memory");
+    __asm volatile("vmsr fpscr, %0" :: "r" (c->fpscr));
+}
+
+uint32_t vfp_irq_enter(void) {
+    uint32_t fpexc = get_fpexc();
+    set_fpexc(fpexc & ~FPEXC_EN);
+    irq_saved = 0;
+    irq_active = 1;
+    return fpexc;
+}
+
+void vfp_irq_exit(uint32_t fpexc) {
+    if (irq_saved) {
+        set_fpexc(FPEXC_EN);
+        restore_context(&irq_ctx);
+    }
+    irq_active = 0;
+    set_fpexc(fpexc);
+}
+
+// returns 0 if the exception was the first VFP instruction of a handler
+__attribute__((used)) int vfp_undef(void) {
+    if (!irq_active || irq_saved) {
+        return -1;
+    }
+    set_fpexc(FPEXC_EN);
+    save_context(&irq_ctx);
+    __asm volatile("vmsr fpscr, %0" :: "r" (FPSCR_RUNFAST));
+    irq_saved = 1;
+    vfp_lazy_saves++;
+    return 0;
+}
+
+__attribute__((naked)) void vfp_undef_handler(void) {
+    __asm volatile("sub lr, lr, #4 \n"          // retry the instruction
+                   "push {r0-r3, r12, lr} \n"
+                   "bl vfp_undef \n"
+                   "cmp r0, #0 \n"
+                   "bne . \n"                   // not ours: hang up
+                   "pop {r0-r3, r12, lr} \n"
+                   "movs pc, lr \n");
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef VFP_H
+#define VFP_H
+
+#include <stdint.h>
+
+// VFP context for interrupt handlers (hard float profile only)
+//
+// Init_Machine of the bsp (VFP=1) enables VFP (CPACR and FPEXC) in
+// RunFast mode, so every operation is done in hardware without support
+// code.
+//
+// The interrupt stub does not save the 16 double registers and FPSCR
+// on every interrupt. vfp_irq_enter() disables VFP instead; when the
+// handler executes its first VFP instruction the undefined instruction
+// exception calls vfp_undef_handler, which saves the context of the
+// interrupted code, enables VFP and retries the instruction.
+// vfp_irq_exit() restores the context only if it has been saved.
+// Handlers which do not use float cost two FPEXC writes.
+//
+// _irq_handler_stub of irq.S calls them around the C handler, so the
+// handler itself is plain C and may use float anywhere:
+//
+//   fpexc = vfp_irq_enter();
+//   irq_handler();
+//   vfp_irq_exit(fpexc);
+//
+// Interrupts are not nested and there is one saved context. Examples
+// which nest interrupts or switch tasks would need one per level or
+// task, so bsp/profile.mk accepts VFP=1 only for an example which sets
+// VFP_CONTEXT = 1.
+
+#define FPEXC_EX  (1U << 31)
+#define FPEXC_EN  (1U << 30)
+
+#define FPSCR_DN  (1U << 25)    // default NaN
+#define FPSCR_FZ  (1U << 24)    // flush to zero
+#define FPSCR_RUNFAST  (FPSCR_DN | FPSCR_FZ)
+
+#ifdef USE_VFP
+
+uint32_t vfp_irq_enter(void);
+void vfp_irq_exit(uint32_t fpexc);
+
+// undefined instruction exception vector
+void vfp_undef_handler(void);
+
+// number of contexts saved by the handlers
+extern volatile uint32_t vfp_lazy_saves;
+
+#endif
+
+#endif
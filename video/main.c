@@ -1,24 +1,7 @@
 #include <stdint.h>
 #include <stdio.h>
 
-#define IOREG(X)  (*(volatile uint32_t *) (X))
-
-extern uint32_t __bss_start, __bss_end;
-
-__attribute__((naked)) __attribute__((section(".startup"))) \
-void Init_Machine(void) {
-  // set CPSR
-  __asm volatile("ldr r0, =0x000000d3");
-  __asm volatile("msr cpsr, r0");
-  // set stack pointer
-  __asm volatile("ldr sp, =0x06400000");
-  // zero out .bss section
-  for (uint32_t *dest = &__bss_start; dest < &__bss_end;) {
-    *dest++ = 0;
-  }
-  __asm volatile("bl _start");
-  __asm volatile("b .");
-}
+#include "bsp.h"
 
 #define MAILBOX0_FIFO   IOREG(0x2000B880)
 #define MAILBOX0_POLL   IOREG(0x2000B890)
@@ -79,7 +62,7 @@ static fb_info_t fb_info = {1920, 1080, 480, 270, 0, 16, 0, 0, 0, 0};
 
 static inline void *coord2ptr(int x, int y) {
     return (void *) (fb_info.buf_addr                   \
-                     + (fb_info.bpp + 7 >> 3) * x       \
+                     + ((fb_info.bpp + 7) >> 3) * x       \
                      + fb_info.row_bytes * y);
 }
 
@@ -117,14 +100,3 @@ int main(int argc, char **argv) {
 
     return 0;
 }
-
-void _start(void) {
-  // when we get here: stack is initialised, bss is clear, data is copied
-  // initialise the cpu and peripherals
-  // now that we have a basic system up and running we can call main
-  main(0, NULL);
-
-  // we must not return
-  for (;;) {
-  }
-}
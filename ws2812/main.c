@@ -0,0 +1,62 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "bsp.h"
+#include "ws2812.h"
+
+#define NUM_LEDS  300
+#define FRAME_US  16667     // 60Hz
+
+static uint32_t pixels[NUM_LEDS];
+static ws2812_t strip;
+
+// color wheel: 0..767 to 0x00RRGGBB
+static uint32_t wheel(uint32_t pos) {
+    pos %= 768;
+    if (pos < 256) {
+        return ((255 - pos) << 16) | (pos << 8);
+    } else if (pos < 512) {
+        pos -= 256;
+        return ((255 - pos) << 8) | pos;
+    } else {
+        pos -= 512;
+        return (pos << 16) | (255 - pos);
+    }
+}
+
+int main(int argc, char **argv) {
+  uart_init(UART_BAUD);
+  uart_print("\r\nWS2812 test. Data is on GPIO18.\r\n");
+
+  ws2812_init(&strip, NUM_LEDS, pixels);
+  strip.brightness = 64;
+
+  uint32_t offset = 0;
+  uint32_t next = SYST_CLO;
+  uint32_t report = next;
+  uint32_t cpu = 0;
+  while(1) {
+      // rainbow moving along the strip
+      uint32_t start = SYST_CLO;
+      for (int i = 0; i < NUM_LEDS; i++) {
+          pixels[i] = wheel(i * 768 / NUM_LEDS + offset);
+      }
+      offset += 8;
+      ws2812_show(&strip);
+      cpu += SYST_CLO - start;
+
+      next += FRAME_US;
+      while ((int32_t) (next - SYST_CLO) > 0);
+
+      if (SYST_CLO - report >= 1000000) {
+          uart_put_dec(strip.frames);
+          uart_print(" fps, CPU ");
+          uart_put_dec(cpu);
+          uart_print("us/s\r\n");
+          strip.frames = 0;
+          cpu = 0;
+          report = SYST_CLO;
+      }
+  }
+  return 0;
+}
@@ -0,0 +1,105 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "ws2812.h"
+#include "dma.h"
+
+// DMA channel for the PWM FIFO
+#define WS2812_DMA  5
+
+// 3 PWM bits per LED bit, 24 LED bits per LED
+#define BITS_PER_LED   72
+// low for 300us (720 PWM bits) after a frame to latch the colors
+#define RESET_WORDS    24
+#define MAX_WORDS      ((WS2812_MAX_LEDS * BITS_PER_LED + 31) / 32 + RESET_WORDS)
+
+static uint32_t lut[256];
+static uint32_t stream[2][MAX_WORDS] __attribute__((aligned(32)));
+static uint32_t stream_words;
+static dma_cb_t ws_cb;
+
+static void init_lut(void) {
+    for (uint32_t v = 0; v < 256; v++) {
+        uint32_t code = 0;
+        for (int b = 7; b >= 0; b--) {
+            code = (code << 3) | ((v & (1U << b)) ? 6 : 4);
+        }
+        lut[v] = code;
+    }
+}
+
+void ws2812_init(ws2812_t *strip, uint32_t num_leds, uint32_t *pixels) {
+    pwm_t *pwm = (pwm_t *) PWM;
+
+    num_leds = (num_leds > WS2812_MAX_LEDS) ? WS2812_MAX_LEDS : num_leds;
+    strip->pwm = pwm;
+    strip->num_leds = num_leds;
+    strip->pixels = pixels;
+    strip->brightness = 256;
+    strip->back = 0;
+    strip->frames = 0;
+    stream_words = (num_leds * BITS_PER_LED + 31) / 32 + RESET_WORDS;
+    init_lut();
+
+    init_pwm(pwm, CM_PWMCTL_SRC_OSC, 8);    // 19.2MHz / 8 = 2.4MHz
+    pwm->CTL = 0;
+    pwm->RNG1 = 32;                         // 32 bits per FIFO word
+    pwm->CTL = CTL_CLRF1;
+    pwm->STA = STA_BERR | STA_GAPO1 | STA_RERR1 | STA_WERR1;
+    // output is low while the FIFO is empty (SBIT1 = 0, RPTL1 = 0)
+    pwm->CTL = CTL_USEF1 | CTL_MODE1 | CTL_PWEN1;
+    pwm->DMAC = DMAC_ENAB | (7 << 8) | 7;
+    dma_init(WS2812_DMA);
+}
+
+// encode the pixels in GRB order into a PWM bitstream
+static void encode(ws2812_t *strip, uint32_t *dst) {
+    uint64_t acc = 0;
+    uint32_t nbits = 0;
+    uint32_t bri = strip->brightness;
+
+    for (uint32_t i = 0; i < strip->num_leds; i++) {
+        uint32_t c = strip->pixels[i];
+        uint32_t r = (((c >> 16) & 0xff) * bri) >> 8;
+        uint32_t g = (((c >> 8) & 0xff) * bri) >> 8;
+        uint32_t b = ((c & 0xff) * bri) >> 8;
+        uint32_t grb[3] = { g, r, b };
+        for (int j = 0; j < 3; j++) {
+            acc = (acc << 24) | lut[grb[j]];
+            nbits += 24;
+            if (nbits >= 32) {
+                nbits -= 32;
+                *dst++ = (uint32_t) (acc >> nbits);
+            }
+        }
+    }
+    if (nbits > 0) {
+        *dst++ = (uint32_t) (acc << (32 - nbits));
+    }
+    for (int i = 0; i < RESET_WORDS; i++) {
+        *dst++ = 0;
+    }
+}
+
+int ws2812_busy(ws2812_t *strip) {
+    return dma_busy(WS2812_DMA);
+}
+
+void ws2812_show(ws2812_t *strip) {
+    uint32_t *buf = stream[strip->back];
+
+    // the previous frame is still sent from the other buffer
+    encode(strip, buf);
+    while (dma_busy(WS2812_DMA));
+
+    ws_cb.ti = DMA_TI_PERMAP(DREQ_PWM) | DMA_TI_DEST_DREQ
+        | DMA_TI_SRC_INC | DMA_TI_WAIT_RESP;
+    ws_cb.source_ad = BUS_ADDR(buf);
+    ws_cb.dest_ad = PERI_ADDR(&strip->pwm->FIF1);
+    ws_cb.txfr_len = stream_words * 4;
+    ws_cb.stride = 0;
+    ws_cb.nextconbk = 0;
+    dma_start(WS2812_DMA, &ws_cb);
+
+    strip->back ^= 1;
+    strip->frames++;
+}
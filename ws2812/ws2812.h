@@ -0,0 +1,38 @@
+#ifndef WS2812_H
+#define WS2812_H
+
+#include <stdint.h>
+#include "pwm.h"
+
+// WS2812 (NeoPixel) LED strip driver
+//
+// PWM channel 1 runs in serializer mode (CTL_MODE1): each 32-bit FIFO
+// word is shifted out MSB first at 2.4MHz. A WS2812 bit is 3 PWM bits
+// (1.25us), 100 for 0 and 110 for 1, so a color byte becomes a 24-bit
+// code taken from a lookup table.
+//
+// ws2812_show() encodes the pixels into one of two bitstream buffers
+// and sends it by DMA. The next frame is encoded while the previous
+// one is being sent.
+
+#define WS2812_MAX_LEDS  1024
+
+typedef struct _ws2812_t {
+    pwm_t *pwm;
+    uint32_t num_leds;
+    uint32_t *pixels;           // 0x00RRGGBB
+    uint32_t brightness;        // 0..256
+    int back;                   // buffer to encode next
+    uint32_t frames;
+} ws2812_t;
+
+// GPIO18. pixels must have num_leds entries
+void ws2812_init(ws2812_t *strip, uint32_t num_leds, uint32_t *pixels);
+
+// send the pixels, returns after the previous frame is sent
+void ws2812_show(ws2812_t *strip);
+
+// returns 1 while a frame is being sent
+int ws2812_busy(ws2812_t *strip);
+
+#endif